@@ -7,8 +7,9 @@
 #include <iostream>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
+#include "../../../common/code/header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/GpuTimer.h"
 
 #include <iostream>
 
@@ -38,6 +39,14 @@ float lastFrame = 0.0f;
 // Lighting set-up
 vec3 lightPos(1.2f, 1.0f, 2.0f);
 
+// Anti-aliasing settings
+enum AntiAliasing { MSAA_AA, FXAA_AA, NO_AA };
+const char* ANTI_ALIASING_NAMES[] = { "4x MSAA", "FXAA", "none" };
+AntiAliasing antiAliasing = MSAA_AA;
+bool aaKeyPressed = false;
+
+unsigned int antiAliasingBytesPerPixel(AntiAliasing mode);
+
 int main() {
     // Initialize GLFW to create a context for OpenGL
     glfwInit();
@@ -81,6 +90,7 @@ int main() {
     // Build and Compile our shaders
     Shader shader("msaa.vs", "msaa.fs");
     Shader screenShader("post.vs", "post.fs");
+    Shader fxaaShader("post.vs", "fxaa.fs");
 
     // set up vertex data (and buffer(s)) and configure vertex attributes
   // ------------------------------------------------------------------
@@ -208,9 +218,43 @@ int main() {
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // Configure the single sampled framebuffer the post-process path draws the scene into. FXAA
+    // smooths it into screenTexture, so the path needs no multisampled storage at all
+    unsigned int aliasedFBO;
+    glGenFramebuffers(1, &aliasedFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, aliasedFBO);
+
+    unsigned int aliasedTexture;
+    glGenTextures(1, &aliasedTexture);
+    glBindTexture(GL_TEXTURE_2D, aliasedTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, aliasedTexture, 0);
+
+    unsigned int aliasedRbo;
+    glGenRenderbuffers(1, &aliasedRbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, aliasedRbo);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCR_WIDTH, SCR_HEIGHT);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, aliasedRbo);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "ERROR::FRAMEBUFFER:: Aliased Framebuffer is not complete" << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
     // Shader configuration
     shader.use();
     screenShader.setInt("screenTexture", 0);
+    fxaaShader.use();
+    fxaaShader.setInt("screenTexture", 0);
+    fxaaShader.setVec2("texelSize", 1.0f / SCR_WIDTH, 1.0f / SCR_HEIGHT);
+
+    // One timer per mode, each covering the scene and its anti-aliasing up to the final pass
+    GpuTimer aaTimers[3];
 
     // Render Loop
     while (!glfwWindowShouldClose(window)) {
@@ -226,8 +270,10 @@ int main() {
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         
-        // 1. Draw scene as normal in multisampled buffers
-        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        // 1. Draw scene as normal in multisampled buffers, or in the single sampled ones for the post-process path
+        GpuTimer& aaTimer = aaTimers[antiAliasing];
+        aaTimer.begin();
+        glBindFramebuffer(GL_FRAMEBUFFER, antiAliasing == MSAA_AA ? framebuffer : aliasedFBO);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         glEnable(GL_DEPTH_TEST);
@@ -243,9 +289,23 @@ int main() {
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         // 2. Now blit multisampled buffer(s) to normal colorbuffer of intermediate FBO. Image is stored in screenTexture
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
-        glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        unsigned int resolvedTexture = screenTexture;
+        if (antiAliasing == MSAA_AA) {
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, intermediateFBO);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        } else if (antiAliasing == FXAA_AA) {
+            // Or find the edges from the luma of the aliased image and blend across them into screenTexture
+            glBindFramebuffer(GL_FRAMEBUFFER, intermediateFBO);
+            glDisable(GL_DEPTH_TEST);
+            fxaaShader.use();
+            glBindVertexArray(quadVAO);
+            glBindTexture(GL_TEXTURE_2D, aliasedTexture);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            resolvedTexture = aliasedTexture;
+        }
+        aaTimer.end();
         
         // 3. Now render quad with scene's visual as its texture image
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
@@ -256,15 +316,30 @@ int main() {
         // Draw screen quad
         screenShader.use();
         glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, screenTexture); // Use the now resolved color attachment as its texture image
+        glBindTexture(GL_TEXTURE_2D, resolvedTexture); // Use the now resolved color attachment as its texture image
         glDrawArrays(GL_TRIANGLES, 0, 6);
 
         // Swap buffers and poll I/O events
         glfwSwapBuffers(window);
         glfwPollEvents();
 
+        float megabytes = antiAliasingBytesPerPixel(antiAliasing) * SCR_WIDTH * SCR_HEIGHT / (1024.0f * 1024.0f);
+        float megabytes4K = antiAliasingBytesPerPixel(antiAliasing) * 3840.0f * 2160.0f / (1024.0f * 1024.0f);
+        cout << "AA: " << ANTI_ALIASING_NAMES[antiAliasing] << " | GPU: " << aaTimer.averageMilliseconds()
+             << " ms | VRAM: " << megabytes << " MB (" << megabytes4K << " MB at 3840x2160)" << endl;
+
     }
 
+    // Deallocate all resources once they are no longer needed
+    glDeleteFramebuffers(1, &framebuffer);
+    glDeleteFramebuffers(1, &intermediateFBO);
+    glDeleteFramebuffers(1, &aliasedFBO);
+    glDeleteTextures(1, &textureColorBufferMultiSampled);
+    glDeleteTextures(1, &screenTexture);
+    glDeleteTextures(1, &aliasedTexture);
+    glDeleteRenderbuffers(1, &rbo);
+    glDeleteRenderbuffers(1, &aliasedRbo);
+
     // Terminate the program
     glfwTerminate();
     return 0;
@@ -286,6 +361,27 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_PRESS && !aaKeyPressed) {
+        antiAliasing = (AntiAliasing)((antiAliasing + 1) % 3);
+        aaKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_M) == GLFW_RELEASE) {
+        aaKeyPressed = false;
+    }
+}
+
+// Bytes per pixel of the render targets a mode draws through before the final pass. RGB8 counts
+// as the 4 bytes drivers pad it to, and every multisampled target stores all 4 of its samples
+unsigned int antiAliasingBytesPerPixel(AntiAliasing mode) {
+    if (mode == MSAA_AA) {
+        return 4 * (4 + 4) + 4; // Multisampled color and depth-stencil, then the resolved color
+    }
+    if (mode == FXAA_AA) {
+        return 4 + 4 + 4;       // Color and depth-stencil, then the smoothed color
+    }
+    return 4 + 4;
 }
 
 // Whenever the window size is changed, this callback function executes
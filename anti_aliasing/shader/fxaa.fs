@@ -0,0 +1,131 @@
+#version 330 core
+
+in vec2 TexCoords;
+
+out vec4 FragColor;
+
+uniform sampler2D screenTexture; // Sampled with GL_LINEAR, which the edge blend relies on
+uniform vec2 texelSize;
+
+const float EDGE_THRESHOLD_MIN = 0.0312; // Darkest contrast treated as an edge
+const float EDGE_THRESHOLD_MAX = 0.125;  // Contrast relative to the brightest neighbor treated as an edge
+const float SUBPIXEL_QUALITY = 0.75;     // How much single pixel features are smoothed
+const int SEARCH_STEPS = 10;
+const float SEARCH_STRIDES[SEARCH_STEPS] = float[](1.0, 1.0, 1.0, 1.0, 1.0, 1.5, 2.0, 2.0, 4.0, 8.0);
+
+float luma(vec3 color) {
+    // Perceptual, so edges are found where they are visible
+    return sqrt(dot(color, vec3(0.299, 0.587, 0.114)));
+}
+
+// FXAA: finds edges from the contrast in luma between a pixel and its neighbors, follows each edge
+// along its direction to where it ends, and blends the pixel with its neighbor across the edge by
+// how far it is from the end, which turns stair steps back into the slope they came from
+void main() {
+    vec3 colorCenter = texture(screenTexture, TexCoords).rgb;
+    float lumaCenter = luma(colorCenter);
+    float lumaDown = luma(textureOffset(screenTexture, TexCoords, ivec2(0, -1)).rgb);
+    float lumaUp = luma(textureOffset(screenTexture, TexCoords, ivec2(0, 1)).rgb);
+    float lumaLeft = luma(textureOffset(screenTexture, TexCoords, ivec2(-1, 0)).rgb);
+    float lumaRight = luma(textureOffset(screenTexture, TexCoords, ivec2(1, 0)).rgb);
+
+    // Most pixels aren't on an edge and leave after these five fetches
+    float lumaMin = min(lumaCenter, min(min(lumaDown, lumaUp), min(lumaLeft, lumaRight)));
+    float lumaMax = max(lumaCenter, max(max(lumaDown, lumaUp), max(lumaLeft, lumaRight)));
+    float lumaRange = lumaMax - lumaMin;
+    if (lumaRange < max(EDGE_THRESHOLD_MIN, lumaMax * EDGE_THRESHOLD_MAX)) {
+        FragColor = vec4(colorCenter, 1.0);
+        return;
+    }
+
+    float lumaDownLeft = luma(textureOffset(screenTexture, TexCoords, ivec2(-1, -1)).rgb);
+    float lumaUpRight = luma(textureOffset(screenTexture, TexCoords, ivec2(1, 1)).rgb);
+    float lumaUpLeft = luma(textureOffset(screenTexture, TexCoords, ivec2(-1, 1)).rgb);
+    float lumaDownRight = luma(textureOffset(screenTexture, TexCoords, ivec2(1, -1)).rgb);
+
+    float lumaDownUp = lumaDown + lumaUp;
+    float lumaLeftRight = lumaLeft + lumaRight;
+    float lumaLeftCorners = lumaDownLeft + lumaUpLeft;
+    float lumaDownCorners = lumaDownLeft + lumaDownRight;
+    float lumaRightCorners = lumaDownRight + lumaUpRight;
+    float lumaUpCorners = lumaUpRight + lumaUpLeft;
+
+    // The edge runs along the axis the luma changes least across
+    float edgeHorizontal = abs(-2.0 * lumaLeft + lumaLeftCorners) + abs(-2.0 * lumaCenter + lumaDownUp) * 2.0 + abs(-2.0 * lumaRight + lumaRightCorners);
+    float edgeVertical = abs(-2.0 * lumaUp + lumaUpCorners) + abs(-2.0 * lumaCenter + lumaLeftRight) * 2.0 + abs(-2.0 * lumaDown + lumaDownCorners);
+    bool isHorizontal = edgeHorizontal >= edgeVertical;
+
+    // Which side of the pixel the edge is on: the neighbor across it with the steeper gradient
+    float luma1 = isHorizontal ? lumaDown : lumaLeft;
+    float luma2 = isHorizontal ? lumaUp : lumaRight;
+    float gradient1 = luma1 - lumaCenter;
+    float gradient2 = luma2 - lumaCenter;
+    bool is1Steepest = abs(gradient1) >= abs(gradient2);
+    float gradientScaled = 0.25 * max(abs(gradient1), abs(gradient2));
+
+    float stepLength = isHorizontal ? texelSize.y : texelSize.x;
+    float lumaLocalAverage;
+    if (is1Steepest) {
+        stepLength = -stepLength;
+        lumaLocalAverage = 0.5 * (luma1 + lumaCenter);
+    } else {
+        lumaLocalAverage = 0.5 * (luma2 + lumaCenter);
+    }
+
+    // Start half a texel across, on the edge itself, and walk along it both ways until the luma
+    // there no longer matches the edge's
+    vec2 currentUv = TexCoords;
+    if (isHorizontal) {
+        currentUv.y += stepLength * 0.5;
+    } else {
+        currentUv.x += stepLength * 0.5;
+    }
+    vec2 offset = isHorizontal ? vec2(texelSize.x, 0.0) : vec2(0.0, texelSize.y);
+
+    vec2 uv1 = currentUv;
+    vec2 uv2 = currentUv;
+    float lumaEnd1 = 0.0;
+    float lumaEnd2 = 0.0;
+    bool reached1 = false;
+    bool reached2 = false;
+    for (int i = 0; i < SEARCH_STEPS && !(reached1 && reached2); i++) {
+        if (!reached1) {
+            uv1 -= offset * SEARCH_STRIDES[i];
+            lumaEnd1 = luma(texture(screenTexture, uv1).rgb) - lumaLocalAverage;
+            reached1 = abs(lumaEnd1) >= gradientScaled;
+        }
+        if (!reached2) {
+            uv2 += offset * SEARCH_STRIDES[i];
+            lumaEnd2 = luma(texture(screenTexture, uv2).rgb) - lumaLocalAverage;
+            reached2 = abs(lumaEnd2) >= gradientScaled;
+        }
+    }
+
+    float distance1 = isHorizontal ? (TexCoords.x - uv1.x) : (TexCoords.y - uv1.y);
+    float distance2 = isHorizontal ? (uv2.x - TexCoords.x) : (uv2.y - TexCoords.y);
+    bool isDirection1 = distance1 < distance2;
+    float distanceFinal = min(distance1, distance2);
+    float edgeLength = distance1 + distance2;
+
+    // Blend only when the luma at the nearer end moves away from the center's, as it does at the
+    // end of a stair step the pixel belongs to
+    bool isLumaCenterSmaller = lumaCenter < lumaLocalAverage;
+    bool correctVariation = ((isDirection1 ? lumaEnd1 : lumaEnd2) < 0.0) != isLumaCenterSmaller;
+    float pixelOffset = correctVariation ? -distanceFinal / edgeLength + 0.5 : 0.0;
+
+    // Single pixel features have no edge to follow, so they are blended by how much they stand
+    // out from the average of their 3x3 neighborhood instead
+    float lumaAverage = (1.0 / 12.0) * (2.0 * (lumaDownUp + lumaLeftRight) + lumaLeftCorners + lumaRightCorners);
+    float subPixelOffset1 = clamp(abs(lumaAverage - lumaCenter) / lumaRange, 0.0, 1.0);
+    float subPixelOffset2 = (-2.0 * subPixelOffset1 + 3.0) * subPixelOffset1 * subPixelOffset1;
+    float subPixelOffset = subPixelOffset2 * subPixelOffset2 * SUBPIXEL_QUALITY;
+    pixelOffset = max(pixelOffset, subPixelOffset);
+
+    vec2 finalUv = TexCoords;
+    if (isHorizontal) {
+        finalUv.y += pixelOffset * stepLength;
+    } else {
+        finalUv.x += pixelOffset * stepLength;
+    }
+    FragColor = vec4(texture(screenTexture, finalUv).rgb, 1.0);
+}
\ No newline at end of file
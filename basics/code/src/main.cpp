@@ -6,7 +6,8 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
+#include "../../../common/code/header/stb_image.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 using namespace std;
 using namespace glm;
@@ -156,64 +157,10 @@ int main() {
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*) (3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // Load and create a texture
-    unsigned int texture1, texture2;
-
-    // Texture 1
-    glGenTextures(1, &texture1);
-    glBindTexture(GL_TEXTURE_2D, texture1);
-
-    // Set texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-    // Load image, create texture, and generate mipmaps
-    int width, height, nrChannels;
+    // Load the textures; the shared sampler repeats them and filters trilinearly across their mipmaps
     stbi_set_flip_vertically_on_load(true); // Tell stbi.h to flip loaded texture on the y-axis
-    
-    unsigned char* data = stbi_load("WoodenTexture.jpg", &width, &height, &nrChannels, 0);
-    
-    // Check to see if image data was succesfully loaded
-    if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        cout << "Failed to Load texture" << endl;
-    }
-
-    // Free image data
-    stbi_image_free(data);
-
-    // Texture 2
-    glGenTextures(1, &texture2);
-    glBindTexture(GL_TEXTURE_2D, texture2);
-
-    // Set texture wrapping parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-    // Set texture filtering parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // Load image, create textures, and generate mipmaps
-    data = stbi_load("awesomeface.png", &width, &height, &nrChannels, 0);
-    
-    // Check to see if image data was successfully loaded
-    if (data) {
-        // Note that .png has a transparency and thus alpha channel
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-    } else {
-        cout << "Failed to load texture" << endl;
-    }
-
-    // Free image data
-    stbi_image_free(data);
+    unsigned int texture1 = loadTexture("WoodenTexture.jpg");
+    unsigned int texture2 = loadTexture("awesomeface.png"); // Note that .png has a transparency and thus alpha channel
 
     // Tell OpenGL for each sampler which texture unit it belongs to
     shaderProgram.use();
@@ -235,10 +182,8 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         // Bind textures on corresponding texture units
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, texture1);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, texture2);
+        bindTexture(0, texture1);
+        bindTexture(1, texture2);
 
         // Activate shader
         shaderProgram.use();
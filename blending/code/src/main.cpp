@@ -4,12 +4,15 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
-#include <map>
+#include <chrono>
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
 #include "Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/FullscreenPass.h"
+#include "../../../common/code/header/GpuTimer.h"
+#include "../../../common/code/header/TransparentSorter.h"
 
 using namespace std;
 using namespace glm;
@@ -18,12 +21,19 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(const char* path);
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// Transparency settings
+const int FIELD_SIZE = 150; // Windows per row and column of the stress test field
+const unsigned int FIELD_COUNT = FIELD_SIZE * FIELD_SIZE;
+bool windowField = false;
+bool fieldKeyPressed = false;
+bool weightedOIT = false; // Weighted blended order-independent transparency instead of sorting
+bool oitKeyPressed = false;
+
 // Camera set-up
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2;
@@ -76,6 +86,8 @@ int main() {
 
     // Build and compile shader programs
     Shader shader("blend.vs", "blend.fs");
+    Shader accumShader("blend.vs", "oit_accum.fs");
+    Shader compositeShader("oit_composite.vs", "oit_composite.fs");
 
     // Set up vertex data and configure vertex attributes
     float cubeVertices[] = {
@@ -211,13 +223,78 @@ int main() {
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     
+    // Offsets of the windows in drawing order, one per instance. Sized once for the largest set
+    unsigned int instanceVBO;
+    glGenBuffers(1, &instanceVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, FIELD_COUNT * sizeof(vec3), NULL, GL_DYNAMIC_DRAW);
+
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(vec3), (void*)0);
+    glVertexAttribDivisor(2, 1);
+
     // Unbind VAO
     glBindVertexArray(0);
 
     // Load textures
     unsigned int cubeTexture = loadTexture("marble.jpg");
     unsigned int floorTexture = loadTexture("metal.png");
-    unsigned int transparentTexture = loadTexture("window.png");
+    // Blended with its real alpha, so it mustn't get the coverage-preserving mips of a cutout
+    unsigned int transparentTexture = loadTexture("window.png", TEXTURE_COLOR);
+
+    // With weighted blended OIT the opaque scene is drawn into its own framebuffer, so the
+    // accumulation pass can test against its depth
+    unsigned int sceneFBO;
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+
+    unsigned int sceneColor;
+    glGenTextures(1, &sceneColor);
+    glBindTexture(GL_TEXTURE_2D, sceneColor);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor, 0);
+
+    unsigned int rboDepth;
+    glGenRenderbuffers(1, &rboDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
+
+    // Accumulation targets, sharing the scene's depth: RGBA16F holds the weighted sum of the
+    // premultiplied colors in rgb and the product of (1 - alpha), the revealage, in alpha. R16F
+    // holds the weighted sum of the alphas the colors are normalized by. OpenGL 3.3 has one blend
+    // function for all targets, so the revealage rides in the alpha of the first target, which
+    // blends multiplicatively while its rgb add; the second then adds and must be a float format
+    unsigned int accumFBO;
+    glGenFramebuffers(1, &accumFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, accumFBO);
+
+    unsigned int accumTextures[2];
+    glGenTextures(2, accumTextures);
+    GLenum accumFormats[2] = { GL_RGBA16F, GL_R16F };
+    GLenum accumLayouts[2] = { GL_RGBA, GL_RED };
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, accumTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, accumFormats[i], SCR_WIDTH, SCR_HEIGHT, 0, accumLayouts[i], GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, accumTextures[i], 0);
+    }
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     // Window locations
     vector<vec3> windows {
@@ -228,8 +305,34 @@ int main() {
         vec3(0.5f, 0.0f, -0.6f)
     };
 
+    // A field of rows of windows behind the scene, with many at the same depth
+    vector<vec3> field;
+    field.reserve(FIELD_COUNT);
+    for (int z = 0; z < FIELD_SIZE; z++) {
+        for (int x = 0; x < FIELD_SIZE; x++) {
+            field.push_back(vec3((x - FIELD_SIZE / 2) * 0.5f, (z % 3) * 0.25f, -3.0f - z * 0.25f));
+        }
+    }
+
+    // Per-frame sorting buffers, reserved up front so the render loop never allocates
+    TransparentSorter sorter;
+    vector<float> depths;
+    vector<vec3> sortedOffsets;
+    depths.reserve(FIELD_COUNT);
+    sortedOffsets.reserve(FIELD_COUNT);
+    bool lastWindowField = windowField;
+    bool offsetsSorted = true; // Whether the instance buffer holds a sorted order rather than the windows as they are
+
     shader.use();
     shader.setInt("texture1", 0);
+    accumShader.use();
+    accumShader.setInt("texture1", 0);
+    compositeShader.use();
+    compositeShader.setInt("accumTexture", 0);
+    compositeShader.setInt("weightTexture", 1);
+
+    GpuTimer sortedTimer;
+    GpuTimer oitTimer;
 
     // Render Loop
     while (!glfwWindowShouldClose(window)) {
@@ -241,14 +344,50 @@ int main() {
         // Input
         processInput(window);
 
-        // Sort transparent windows before rendering
-        map<float, vec3> sorted;
-        for (unsigned int i = 0; i < windows.size(); i++) {
-            float distance = length(camera.Position - windows[i]);
-            sorted[distance] = windows[i];
+        // Set up view/projection/model transformations
+        mat4 model = mat4(1.0f);
+        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        mat4 view = camera.GetViewMatrix();
+
+        // Last frame's order means nothing for a different set of windows
+        const vector<vec3>& transparent = windowField ? field : windows;
+        unsigned int transparentCount = (unsigned int)transparent.size();
+        if (windowField != lastWindowField) {
+            sorter.reset();
+            lastWindowField = windowField;
+            offsetsSorted = true;
+        }
+
+        // Sort transparent windows by view depth before rendering. Windows at the same depth all
+        // stay in, in a fixed order
+        auto sortStart = chrono::high_resolution_clock::now();
+        if (!weightedOIT) {
+            depths.resize(transparentCount);
+            for (unsigned int i = 0; i < transparentCount; i++) {
+                depths[i] = -(view * vec4(transparent[i], 1.0f)).z;
+            }
+            const vector<unsigned int>& order = sorter.sortBackToFront(depths.data(), transparentCount);
+
+            sortedOffsets.resize(transparentCount);
+            for (unsigned int i = 0; i < transparentCount; i++) {
+                sortedOffsets[i] = transparent[order[i]];
+            }
+        }
+        auto sortEnd = chrono::high_resolution_clock::now();
+
+        // Weighted blended OIT takes the windows in any order, so they are only uploaded when they change
+        if (!weightedOIT) {
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, transparentCount * sizeof(vec3), sortedOffsets.data());
+            offsetsSorted = true;
+        } else if (offsetsSorted) {
+            glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+            glBufferSubData(GL_ARRAY_BUFFER, 0, transparentCount * sizeof(vec3), transparent.data());
+            offsetsSorted = false;
         }
 
         // Render
+        glBindFramebuffer(GL_FRAMEBUFFER, weightedOIT ? sceneFBO : 0);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -256,17 +395,12 @@ int main() {
         // Activate shader
         shader.use();
 
-        // Set up view/projection/model transformations
-        mat4 model = mat4(1.0f);
-        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        mat4 view = camera.GetViewMatrix();
         shader.setMat4("projection", projection);
         shader.setMat4("view", view);
 
         // Draw cubes
         glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        bindTexture(0, cubeTexture);
 
         // Set up model matrix
         model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
@@ -285,7 +419,7 @@ int main() {
 
         // Draw the floor
         glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        bindTexture(0, floorTexture);
 
         // Set up model matrix
         shader.setMat4("model", mat4(1.0f));
@@ -295,14 +429,49 @@ int main() {
 
         // Draw windows
         glBindVertexArray(transparentVAO);
-        glBindTexture(GL_TEXTURE_2D, transparentTexture);
-
-        for (map<float, vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it) {
-            model = mat4(1.0f);
-            model = translate(model, it->second);
-            shader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 6);
+        bindTexture(0, transparentTexture);
+
+        GpuTimer& transparentTimer = weightedOIT ? oitTimer : sortedTimer;
+        transparentTimer.begin();
+        if (!weightedOIT) {
+            // All windows in one draw, placed by their instance offsets in sorted order
+            shader.setMat4("model", mat4(1.0f));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, transparentCount);
+        } else {
+            // Accumulate every window in one draw, in whatever order, testing against the scene's
+            // depth without writing it
+            glBindFramebuffer(GL_FRAMEBUFFER, accumFBO);
+            const float clearAccum[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            const float clearWeight[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 0, clearAccum);
+            glClearBufferfv(GL_COLOR, 1, clearWeight);
+
+            glDepthMask(GL_FALSE);
+            glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+            accumShader.use();
+            accumShader.setMat4("projection", projection);
+            accumShader.setMat4("view", view);
+            accumShader.setMat4("model", mat4(1.0f));
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, transparentCount);
+
+            // Composite the average transparent color over the scene, covering as much of it as
+            // the revealage doesn't let through
+            glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+            glDisable(GL_DEPTH_TEST);
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            compositeShader.use();
+            bindTexture(0, accumTextures[0]);
+            bindTexture(1, accumTextures[1]);
+            drawFullscreenTriangle();
+            glEnable(GL_DEPTH_TEST);
+            glDepthMask(GL_TRUE);
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
         }
+        transparentTimer.end();
 
 
         // Unbind VAO
@@ -313,6 +482,12 @@ int main() {
         glfwSwapBuffers(window);
         glfwPollEvents();
 
+        cout << "Windows: " << transparentCount << " | mode: " << (weightedOIT ? "weighted OIT" : "sorted")
+            << " | sort: " << chrono::duration<double, micro>(sortEnd - sortStart).count() << " us";
+        if (!weightedOIT) {
+            cout << " (" << (sorter.lastPath() == COHERENT_SORT ? "coherent" : "radix") << ")";
+        }
+        cout << " | transparent GPU: " << transparentTimer.averageMilliseconds() << " ms" << endl;
     }
 
     // Deallocate all resources once they are no longer needed
@@ -320,6 +495,14 @@ int main() {
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteBuffers(1, &planeVBO);
+    glDeleteVertexArrays(1, &transparentVAO);
+    glDeleteBuffers(1, &transparentVBO);
+    glDeleteBuffers(1, &instanceVBO);
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteFramebuffers(1, &accumFBO);
+    glDeleteTextures(1, &sceneColor);
+    glDeleteTextures(2, accumTextures);
+    glDeleteRenderbuffers(1, &rboDepth);
 
     // Terminate the program
     glfwTerminate();
@@ -342,6 +525,24 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !fieldKeyPressed) {
+        windowField = !windowField;
+        fieldKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE) {
+        fieldKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !oitKeyPressed) {
+        weightedOIT = !weightedOIT;
+        oitKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+        oitKeyPressed = false;
+    }
 }
 
 // Whenever the window size is changed, this callback function executes
@@ -368,41 +569,4 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
-}
-
-
-// Utility function for loading a 2D texture from a file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec2 aTexCoords;
+layout (location = 2) in vec3 aOffset; // Per window; left disabled, and so zero, for everything else
 
 out vec2 TexCoords;
 
@@ -11,5 +12,5 @@ uniform mat4 projection;
 
 void main() {
     TexCoords = aTexCoords;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+    gl_Position = projection * view * model * vec4(aPos + aOffset, 1.0);
 }
@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (location = 0) out vec4 Accum;
+layout (location = 1) out float Weight;
+
+in vec2 TexCoords;
+
+uniform sampler2D texture1;
+
+const float NEAR = 0.1;  // Planes of the projection in main.cpp
+const float FAR = 100.0;
+
+// Weighted blended order-independent transparency. Every fragment adds its premultiplied color
+// times a weight to the first target and its alpha times the weight to the second, and multiplies
+// the alpha of the first by (1 - alpha). Near, opaque fragments get larger weights, so they
+// dominate the average color the way they would have covered the farther ones
+void main() {
+    vec4 color = texture(texture1, TexCoords);
+    if (color.a < 0.01)
+        discard;
+
+    // Falls off with view depth. Capped low enough that a couple of hundred layers at the cap fit
+    // in the half floats of the targets
+    float depth = NEAR * FAR / (FAR - gl_FragCoord.z * (FAR - NEAR));
+    float weight = clamp(10.0 / (1e-5 + pow(depth / 5.0, 2.0) + pow(depth / 200.0, 6.0)), 1e-2, 3e2);
+    weight *= pow(min(1.0, color.a * 10.0) + 0.01, 3.0);
+    Accum = vec4(color.rgb * color.a * weight, color.a);
+    Weight = color.a * weight;
+}
\ No newline at end of file
@@ -0,0 +1,19 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D accumTexture;  // Weighted premultiplied colors in rgb, revealage in alpha
+uniform sampler2D weightTexture; // Weighted alphas
+
+void main() {
+    vec4 accum = texture(accumTexture, TexCoords);
+    float revealage = accum.a;
+    if (revealage >= 1.0)
+        discard;
+
+    // The weighted average color, blended over the scene by how much of it is covered
+    vec3 average = accum.rgb / max(texture(weightTexture, TexCoords).r, 1e-5);
+    FragColor = vec4(average, 1.0 - revealage);
+}
\ No newline at end of file
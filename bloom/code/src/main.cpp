@@ -5,10 +5,15 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <algorithm>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/GpuTimer.h"
+#include "../../../common/code/header/GaussianBlur.h"
+#include "../../../common/code/header/AutoExposure.h"
+#include "../../../common/code/header/ColorGrading.h"
 
 #include <iostream>
 
@@ -20,7 +25,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path, bool gammaCorrection);
 void renderQuad();
 void renderCube();
 
@@ -29,7 +33,26 @@ const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool bloom = true;
 bool bloomKeyPressed = false;
-float exposure = 1.0f;
+bool mipChainBloom = true; // Blur by downsampling and upsampling a chain of half-size targets instead of a separable Gaussian
+bool mipChainKeyPressed = false;
+float exposure = 1.0f;              // Multiplies the measured exposure when autoExposure is on
+bool autoExposure = true;
+bool autoExposureKeyPressed = false;
+
+// Gaussian bloom
+float blurSigma = 4.5f;             // In screen pixels
+unsigned int blurDownscale = 1;     // Blur at full, half or quarter resolution
+bool downscaleKeyPressed = false;
+
+// Mip chain bloom
+const unsigned int BLOOM_MIP_COUNT = 6;
+const float BLOOM_FILTER_RADIUS = 0.005f;
+
+// Render targets
+const GLenum HDR_FORMAT = GL_R11F_G11F_B10F;    // 4 bytes a pixel; GL_RGBA16F (8 bytes) when alpha or more precision is needed
+bool srgbFramebuffer = true;                    // Let the default framebuffer do the sRGB encode
+string colorGradePath = "";                     // Optional color grade strip; the grade is neutral without one
+const unsigned int LUT_SIZE = 32;
 
 // camera
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
@@ -48,6 +71,7 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, srgbFramebuffer);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -79,15 +103,20 @@ int main() {
     glEnable(GL_DEPTH_TEST);
  
 
+    // The composite writes linear color if the default framebuffer encodes, sRGB if it can't
+    bool displayEncodes = srgbFramebuffer && enableSrgbFramebuffer();
+    unsigned int colorLut = createColorLut(colorGradePath, !displayEncodes, LUT_SIZE);
+
     // Build and compile shaders
     Shader shader("bloom.vs", "bloom.fs");
     Shader shaderLight("bloom.vs", "light_box.fs");
-    Shader shaderBlur("blur.vs", "blur.fs");
     Shader shaderBloomFinal("bloom_final.vs", "bloom_final.fs");
+    Shader shaderDownsample("blur.vs", "bloom_downsample.fs");
+    Shader shaderUpsample("blur.vs", "bloom_upsample.fs");
 
     // Load textures
-    unsigned int containerTexture = loadTexture("container2.png", true);
-    unsigned int woodTexture = loadTexture("wood.png", true);
+    unsigned int containerTexture = loadTexture("container2.png", TEXTURE_COLOR, true);
+    unsigned int woodTexture = loadTexture("wood.png", TEXTURE_COLOR, true);
 
     // Configure floating point framebuffer
     unsigned int hdrFBO;
@@ -100,7 +129,7 @@ int main() {
     
     for (int i = 0; i < 2; i++) {
         glBindTexture(GL_TEXTURE_2D, colorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+        glTexImage2D(GL_TEXTURE_2D, 0, HDR_FORMAT, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -127,30 +156,48 @@ int main() {
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-    // Ping-Pong Framebuffer for blurring
-    unsigned int pingpongFBO[2];
-    unsigned int pingpongColorBuffers[2];
-    glGenFramebuffers(2, pingpongFBO);
-    glGenTextures(2, pingpongColorBuffers);
+    // Separable Gaussian for blurring, with weights generated for blurSigma
+    GaussianBlur gaussianBlur(SCR_WIDTH, SCR_HEIGHT, blurSigma, blurDownscale, HDR_FORMAT);
+
+    // Mip chain for the downsample/upsample bloom. Every level is half the size of the one above
+    // it, starting at half the screen, so the whole chain costs less than a single full-size
+    // ping-pong buffer and each pass touches a quarter of the pixels of the one before
+    unsigned int bloomFBO;
+    glGenFramebuffers(1, &bloomFBO);
+
+    unsigned int bloomMips[BLOOM_MIP_COUNT];
+    ivec2 bloomMipSizes[BLOOM_MIP_COUNT];
+    glGenTextures(BLOOM_MIP_COUNT, bloomMips);
+    ivec2 mipSize(SCR_WIDTH, SCR_HEIGHT);
 
-    for (unsigned int i = 0; i < 2; i++) {
-        glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[i]);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[i]);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    for (unsigned int i = 0; i < BLOOM_MIP_COUNT; i++) {
+        mipSize = ivec2(std::max(mipSize.x / 2, 1), std::max(mipSize.y / 2, 1));
+        bloomMipSizes[i] = mipSize;
 
+        glBindTexture(GL_TEXTURE_2D, bloomMips[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, HDR_FORMAT, mipSize.x, mipSize.y, 0, GL_RGB, GL_FLOAT, NULL);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, pingpongColorBuffers[i], 0);
-        
-        // Check if Framebuffer is complete
-        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-            cout << "Framebuffer not complete." << endl;
-        }
     }
 
+    glBindFramebuffer(GL_FRAMEBUFFER, bloomFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloomMips[0], 0);
+
+    // Check if Framebuffer is complete
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Measures the average luminance of the scene and adapts to it over time
+    AutoExposure exposureMeter;
+
+    // GPU time of each blur path, so the two can be compared by toggling between them
+    GpuTimer gaussianTimer;
+    GpuTimer mipChainTimer;
+
     // Lighting
     // Positions
     vector<vec3> lightPositions;
@@ -169,11 +216,16 @@ int main() {
     // Shader configuration
     shader.use();
     shader.setInt("diffuseTexture", 0);
-    shaderBlur.use();
-    shaderBlur.setInt("image", 0);
     shaderBloomFinal.use();
     shaderBloomFinal.setInt("scene", 0);
     shaderBloomFinal.setInt("bloomBlur", 1);
+    shaderBloomFinal.setInt("colorLut", 2);
+    shaderBloomFinal.setFloat("lutSize", LUT_SIZE);
+    shaderDownsample.use();
+    shaderDownsample.setInt("srcTexture", 0);
+    shaderUpsample.use();
+    shaderUpsample.setInt("srcTexture", 0);
+    shaderUpsample.setFloat("filterRadius", BLOOM_FILTER_RADIUS);
 
     // Render Loop
     while (!glfwWindowShouldClose(window)) {
@@ -200,8 +252,7 @@ int main() {
             shader.use();
             shader.setMat4("projection", projection);
             shader.setMat4("view", view);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            bindTexture(0, woodTexture);
 
             // Set lighting uniforms
             for (unsigned int i = 0; i < lightPositions.size(); i++) {
@@ -219,7 +270,7 @@ int main() {
             renderCube();
 
             // Then create multiple cubes as the scenery
-            glBindTexture(GL_TEXTURE_2D, containerTexture);
+            bindTexture(0, containerTexture);
             model = mat4(1.0f);
             model = translate(model, vec3(0.0f, 1.5f, 0.0));
             model = scale(model, vec3(0.5f));
@@ -272,36 +323,83 @@ int main() {
             }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 2. Blur bright fragments with two-pass Gaussian Blur
-        bool horizontal = true, first_iteration = true;
-        unsigned int amount = 10;
-        shaderBlur.use();
-
-        for (unsigned int i = 0; i < amount; i++) {
-            glBindFramebuffer(GL_FRAMEBUFFER, pingpongFBO[horizontal]);
-            shaderBlur.setInt("horizontal", horizontal);
-            glBindTexture(GL_TEXTURE_2D, first_iteration ? colorBuffers[1] : pingpongColorBuffers[!horizontal]);
-            renderQuad();
-            horizontal = !horizontal;
-            if (first_iteration) {
-                first_iteration = false;
+        // 2. Measure the scene; the exposure it gives lags a few frames behind
+        exposureMeter.update(colorBuffers[0], deltaTime);
+        float frameExposure = autoExposure ? exposure * exposureMeter.getExposure() : exposure;
+
+        // 3. Blur bright fragments
+        unsigned int bloomTexture;
+        float bloomStrength;
+
+        if (mipChainBloom) {
+            // 3a. Downsample the bright fragments through the mip chain, then walk back up
+            // adding each level's tent-filtered result onto the level above it
+            mipChainTimer.begin();
+            glBindFramebuffer(GL_FRAMEBUFFER, bloomFBO);
+            glDisable(GL_DEPTH_TEST);
+
+            shaderDownsample.use();
+            for (unsigned int i = 0; i < BLOOM_MIP_COUNT; i++) {
+                glViewport(0, 0, bloomMipSizes[i].x, bloomMipSizes[i].y);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloomMips[i], 0);
+
+                // Only the first pass sees single bright texels; later levels are already filtered
+                shaderDownsample.setBool("karisAverage", i == 0);
+                bindTexture(0, i == 0 ? colorBuffers[1] : bloomMips[i - 1]);
+                renderQuad();
+            }
+
+            shaderUpsample.use();
+            glEnable(GL_BLEND);
+            glBlendFunc(GL_ONE, GL_ONE);
+            glBlendEquation(GL_FUNC_ADD);
+            for (unsigned int i = BLOOM_MIP_COUNT - 1; i > 0; i--) {
+                glViewport(0, 0, bloomMipSizes[i - 1].x, bloomMipSizes[i - 1].y);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, bloomMips[i - 1], 0);
+                bindTexture(0, bloomMips[i]);
+                renderQuad();
             }
+            glDisable(GL_BLEND);
+
+            glEnable(GL_DEPTH_TEST);
+            glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            mipChainTimer.end();
+
+            // The top level now holds the sum of every level
+            bloomTexture = bloomMips[0];
+            bloomStrength = 1.0f / BLOOM_MIP_COUNT;
+        } else {
+            // 3b. Blur bright fragments with a two-pass Gaussian Blur
+            gaussianTimer.begin();
+            gaussianBlur.setSigma(blurSigma);
+            gaussianBlur.setDownscale(blurDownscale);
+            bloomTexture = gaussianBlur.apply(colorBuffers[1]);
+            gaussianTimer.end();
+
+            bloomStrength = 1.0f;
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 3. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
+        // 4. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffer's (clamped) color range
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         shaderBloomFinal.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffers[0]);
+        bindTexture(0, colorBuffers[0]);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, pingpongColorBuffers[!horizontal]);
+        glBindTexture(GL_TEXTURE_2D, bloomTexture);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_3D, colorLut);
 
         shaderBloomFinal.setInt("bloom", bloom);
-        shaderBloomFinal.setFloat("exposure", exposure);
+        shaderBloomFinal.setFloat("bloomStrength", bloomStrength);
+        shaderBloomFinal.setFloat("exposure", frameExposure);
         renderQuad();
 
-        cout << "Bloom: " << (bloom ? "on" : "off") << "| exposure: " << exposure << endl;
+        cout << "Bloom: " << (bloom ? "on" : "off") << "| exposure: " << frameExposure
+             << " | auto exposure: " << (autoExposure ? "on" : "off")
+             << " | blur: " << (mipChainBloom ? "mip chain" : "gaussian")
+             << " (sigma " << blurSigma << ", 1/" << blurDownscale << " res, " << gaussianBlur.fetchesPerPass() << " fetches per pass)"
+             << " | gaussian GPU: " << gaussianTimer.averageMilliseconds() << " ms"
+             << " | mip chain GPU: " << mipChainTimer.averageMilliseconds() << " ms" << endl;
         
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -439,6 +537,39 @@ void processInput(GLFWwindow* window) {
         bloomKeyPressed = false;
     }
 
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !mipChainKeyPressed) {
+        mipChainBloom = !mipChainBloom;
+        mipChainKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) {
+        mipChainKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS && !downscaleKeyPressed) {
+        blurDownscale = blurDownscale == 4 ? 1 : blurDownscale * 2;
+        downscaleKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_RELEASE) {
+        downscaleKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) {
+        blurSigma = std::max(blurSigma - 2.0f * deltaTime, 0.5f);
+    } else if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
+        blurSigma = std::min(blurSigma + 2.0f * deltaTime, 32.0f);
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !autoExposureKeyPressed) {
+        autoExposure = !autoExposure;
+        autoExposureKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE) {
+        autoExposureKeyPressed = false;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
         if (exposure > 0.0f) {
             exposure -= .001f;
@@ -480,42 +611,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path, bool gammaCorrection) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum dataFormat;
-        GLenum internalFormat;
-
-        if (nrComponents == 1) {
-            internalFormat = dataFormat = GL_RED;
-        } else if (nrComponents == 3) {
-            internalFormat = gammaCorrection ? GL_SRGB : GL_RGB;
-            dataFormat = GL_RGB;
-        } else if (nrComponents == 4) {
-            internalFormat = gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
-            dataFormat = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
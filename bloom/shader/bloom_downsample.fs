@@ -0,0 +1,65 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2D srcTexture;
+uniform bool karisAverage; // Only for the first downsample, where single bright texels are still unfiltered
+
+// Weights a group of samples down by its brightness, so a lone very bright texel can't dominate
+// the average and flicker as it moves between texels
+float karisWeight(vec3 color) {
+    float luma = dot(color, vec3(0.2126, 0.7152, 0.0722));
+    return 1.0 / (1.0 + luma);
+}
+
+// 13 bilinear taps spread over a 4x4 texel area of the source: a center box of four taps plus
+// four overlapping corner boxes. This keeps the downsample from aliasing like a plain 2x2 box
+void main() {
+    vec2 texel = 1.0 / textureSize(srcTexture, 0);
+    float x = texel.x;
+    float y = texel.y;
+
+    vec3 a = texture(srcTexture, TexCoords + vec2(-2.0 * x,  2.0 * y)).rgb;
+    vec3 b = texture(srcTexture, TexCoords + vec2( 0.0,      2.0 * y)).rgb;
+    vec3 c = texture(srcTexture, TexCoords + vec2( 2.0 * x,  2.0 * y)).rgb;
+    vec3 d = texture(srcTexture, TexCoords + vec2(-2.0 * x,  0.0)).rgb;
+    vec3 e = texture(srcTexture, TexCoords).rgb;
+    vec3 f = texture(srcTexture, TexCoords + vec2( 2.0 * x,  0.0)).rgb;
+    vec3 g = texture(srcTexture, TexCoords + vec2(-2.0 * x, -2.0 * y)).rgb;
+    vec3 h = texture(srcTexture, TexCoords + vec2( 0.0,     -2.0 * y)).rgb;
+    vec3 i = texture(srcTexture, TexCoords + vec2( 2.0 * x, -2.0 * y)).rgb;
+    vec3 j = texture(srcTexture, TexCoords + vec2(-x,  y)).rgb;
+    vec3 k = texture(srcTexture, TexCoords + vec2( x,  y)).rgb;
+    vec3 l = texture(srcTexture, TexCoords + vec2(-x, -y)).rgb;
+    vec3 m = texture(srcTexture, TexCoords + vec2( x, -y)).rgb;
+
+    vec3 result;
+    if (karisAverage) {
+        // Each of the five boxes is averaged on its own and weighted by its brightness
+        vec3 groups[5] = vec3[](
+            (j + k + l + m) * 0.25,
+            (a + b + d + e) * 0.25,
+            (b + c + e + f) * 0.25,
+            (d + e + g + h) * 0.25,
+            (e + f + h + i) * 0.25
+        );
+        float boxWeights[5] = float[](0.5, 0.125, 0.125, 0.125, 0.125);
+
+        result = vec3(0.0);
+        float totalWeight = 0.0;
+        for (int n = 0; n < 5; n++) {
+            float weight = boxWeights[n] * karisWeight(groups[n]);
+            result += groups[n] * weight;
+            totalWeight += weight;
+        }
+        result /= totalWeight;
+    } else {
+        result = e * 0.125;
+        result += (a + c + g + i) * 0.03125;
+        result += (b + d + f + h) * 0.0625;
+        result += (j + k + l + m) * 0.125;
+    }
+
+    FragColor = vec4(max(result, 0.0001), 1.0);
+}
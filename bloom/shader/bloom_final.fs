@@ -6,23 +6,26 @@ in vec2 TexCoords;
 
 uniform sampler2D scene;
 uniform sampler2D bloomBlur;
+uniform sampler3D colorLut;
 uniform bool bloom;
+uniform float bloomStrength; // Scales the blurred texture down when it holds the sum of several levels
 uniform float exposure;
+uniform float lutSize;
 
+// Bloom, tone mapping, color grading and display encoding all happen in this one pass, so the HDR
+// image is read once and the display image written once
 void main() {
-    const float gamma = 2.2;
     vec3 hdrColor = texture(scene, TexCoords).rgb;
-    vec3 bloomColor = texture(bloomBlur, TexCoords).rgb;
 
     if(bloom) {
-        hdrColor += bloomColor; // Additive blending
+        hdrColor += texture(bloomBlur, TexCoords).rgb * bloomStrength; // Additive blending
     }
 
     // Tone mapping
     vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
 
-    // Also gamma coorect
-    result = pow(result, vec3(1.0 / gamma));
-    FragColor = vec4(result, 1.0);
-
+    // Grade and encode through the lookup table. It is indexed by the square root of the color;
+    // the scale and offset land 0 and 1 on the centers of its edge texels
+    vec3 lutCoords = sqrt(result) * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize;
+    FragColor = vec4(texture(colorLut, lutCoords).rgb, 1.0);
 }
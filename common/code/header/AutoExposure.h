@@ -0,0 +1,65 @@
+#ifndef AUTO_EXPOSURE_H
+#define AUTO_EXPOSURE_H
+
+#include <glad/glad.h>
+
+#include <vector>
+
+using namespace std;
+
+// How the exposure follows the scene
+struct Exposure_Settings {
+	float keyValue = 0.18f;     // Brightness the average luminance is exposed to (middle grey)
+	float speedUp = 3.0f;       // Adaptation rate, per second, when the scene gets brighter
+	float speedDown = 1.0f;     // Adaptation rate, per second, when the scene gets darker
+	float minExposure = 0.05f;
+	float maxExposure = 20.0f;
+};
+
+// Finds the exposure for an HDR image on the GPU. The image is reduced to the log of its luminance
+// in a square target whose mip chain glGenerateMipmap then averages down to one texel: the log
+// average (geometric mean) luminance of the frame. That texel is copied into a pixel pack buffer
+// and only read once the fence after the copy has signaled, a few frames later, so measuring never
+// stalls the frame. The adapted luminance then moves toward each result at the configured rate
+class AutoExposure {
+public:
+	// size is the side of the reduction target, a power of two; readbackLatency is the number of
+	// frames of measurements that can be in flight
+	AutoExposure(const Exposure_Settings& settings = Exposure_Settings(), unsigned int size = 256, unsigned int readbackLatency = 3);
+	~AutoExposure();
+
+	AutoExposure(const AutoExposure&) = delete;
+	AutoExposure& operator=(const AutoExposure&) = delete;
+
+	// Measures hdrTexture and adapts to the newest measurement that has come back. Framebuffer,
+	// viewport, depth test and blending are restored afterwards
+	void update(unsigned int hdrTexture, float deltaTime);
+
+	// Exposure that maps the adapted average luminance to the key value
+	float getExposure() const;
+
+	// Luminance the exposure is currently adapted to
+	float getAdaptedLuminance() const;
+
+	Exposure_Settings settings;
+
+private:
+	unsigned int size;
+	unsigned int levels;
+	unsigned int program;
+	unsigned int framebuffer;
+	unsigned int luminanceTexture;
+
+	vector<unsigned int> readbackBuffers;
+	vector<GLsync> fences;
+	unsigned int next;
+
+	bool measured;
+	float measuredLogLuminance;
+	float adaptedLogLuminance;
+
+	void measure(unsigned int hdrTexture);
+	void collectReadbacks();
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef COLOR_GRADING_H
+#define COLOR_GRADING_H
+
+#include <string>
+
+using namespace std;
+
+// Builds the 3D lookup texture a composite pass uses to grade tonemapped color and encode it for
+// the display in one fetch. The table is indexed by the square root of the linear color, which
+// spreads its cells close to evenly in perceived brightness, so a small table stays smooth in
+// the darks. gradePath is an optional grade in the usual strip layout, a size * size wide by size
+// high image in sRGB with red along x, green down y and blue across the tiles; without one the
+// grade is neutral. When encodeSrgb is false the table outputs linear color, for a framebuffer
+// that does the sRGB encode itself
+unsigned int createColorLut(const string& gradePath, bool encodeSrgb, unsigned int size = 32);
+
+// Turns on GL_FRAMEBUFFER_SRGB if the default framebuffer has sRGB storage (ask for it with the
+// GLFW_SRGB_CAPABLE window hint). Returns whether writes to it are now encoded
+bool enableSrgbFramebuffer();
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef CONE_STEP_MAP_H
+#define CONE_STEP_MAP_H
+
+#include <vector>
+
+using namespace std;
+
+struct Cone_Step_Settings {
+	int searchRadius = 16;          // In texels. Cones are narrowed so they never reach further out
+	float maxConeRatio = 1.0f;      // Widest cone stored, horizontal texture coordinates per unit of depth
+	bool wrap = true;               // Look across the edges, for GL_REPEAT height maps
+	unsigned int threadCount = 0;   // 0 uses one thread per core
+};
+
+// Relaxed cone step map of a depth map (0 at the surface, 1 at the deepest point), read from the
+// first channel of the image. Every texel gets the widest cone, opening upwards from its depth,
+// that a ray entering it crosses the depth map at most once in. A ray can then jump straight to
+// the edge of the cone at each step and lands at most one crossing past the surface, which a
+// single interpolation finds. Rows are split across threads.
+// Returns tightly packed RG8: the depth in red and the square root of the cone ratio in green,
+// which keeps more precision for the narrow cones where it matters
+vector<unsigned char> generateConeStepMap(const unsigned char* pixels, int width, int height, int components, const Cone_Step_Settings& settings);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CUBEMAP_LOADER_H
+#define CUBEMAP_LOADER_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Creates a cubemap from six face images in the order +X, -X, +Y, -Y, +Z, -Z. The faces are
+// decoded at the same time on worker threads and uploaded once all of them are ready, so loading
+// takes about as long as the slowest face instead of the sum of all six
+unsigned int loadCubemap(const vector<string>& faces);
+
+// Creates an RGB16F cubemap from an equirectangular (latitude/longitude) HDR panorama. The
+// conversion runs once on the CPU and is cached next to the panorama, e.g. "sky.hdr" with 512
+// texel faces becomes "sky.hdr.cube512.ktx". A faceSize of 0 picks a quarter of the panorama's
+// width, which keeps about one texel per panorama pixel along the horizon
+unsigned int loadEquirectangularCubemap(const string& path, int faceSize = 0);
+
+// Resamples a panorama of linear RGB floats into six faces of faceSize x faceSize RGB floats,
+// stored face after face in the same order as the cubemap faces. Rows of every face are split
+// across threadCount threads (0 uses one per core)
+vector<float> equirectangularToCubemap(const float* rgb, int width, int height, int faceSize, unsigned int threadCount = 0);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef FULLSCREEN_PASS_H
+#define FULLSCREEN_PASS_H
+
+#include <string>
+
+using namespace std;
+
+// Vertex shader for full-screen passes. It builds one triangle that covers the screen from
+// gl_VertexID and passes TexCoords on, so the pass needs no vertex buffer
+extern const char* FULLSCREEN_VERTEX_SHADER;
+
+// Compiles and links a program from source, for shaders that are generated or built into common
+// code rather than loaded from a demo's shader directory. Prints errors tagged with name
+unsigned int compileProgram(const string& vertexSource, const string& fragmentSource, const string& name);
+
+// Draws the full-screen triangle with whatever program is bound
+void drawFullscreenTriangle();
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef GAUSSIAN_BLUR_H
+#define GAUSSIAN_BLUR_H
+
+#include <glad/glad.h>
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// One half of a symmetric separable Gaussian, already folded into bilinear taps. Tap 0 is the
+// center texel; every other tap is sampled at +offset and -offset. Offsets are in texels
+struct Blur_Kernel {
+	vector<float> offsets;
+	vector<float> weights;
+};
+
+// Normalized Gaussian weights for sigma (in texels) out to radius texels, or 3 sigma when radius
+// is 0. Each pair of neighboring texels is merged into one sample placed between them so the
+// bilinear filter returns their weighted sum, which roughly halves the fetches per pass
+Blur_Kernel gaussianKernel(float sigma, int radius = 0);
+
+// Fragment shader source for a blur pass that takes kernel.offsets.size() taps per side. The tap
+// count is a constant, so the loop unrolls; the offsets and weights are uniforms, so every sigma
+// that folds to the same tap count shares one program
+string blurShaderSource(unsigned int tapCount);
+
+// Separable Gaussian blur of a texture into a target owned by the blur. The target can be half
+// or quarter resolution: the source is box filtered down to it, then the blur is done in fewer,
+// larger texels with sigma scaled to match, so the result covers the same screen area for a
+// fraction of the fetches. The source has to be sampled with GL_LINEAR filtering for the folded
+// taps and the box filter to be correct
+class GaussianBlur {
+public:
+	// sigma is in full resolution texels; downscale is 1, 2 or 4
+	GaussianBlur(unsigned int width, unsigned int height, float sigma, unsigned int downscale = 1, GLenum internalFormat = GL_RGBA16F);
+	~GaussianBlur();
+
+	GaussianBlur(const GaussianBlur&) = delete;
+	GaussianBlur& operator=(const GaussianBlur&) = delete;
+
+	// Blurs source with `passes` horizontal and vertical pass pairs and returns the texture holding
+	// the result. Framebuffer, viewport, depth test and blending are restored afterwards
+	unsigned int apply(unsigned int source, unsigned int passes = 1);
+
+	void setSigma(float sigma);
+	void setDownscale(unsigned int downscale);
+
+	float getSigma() const;
+	unsigned int getDownscale() const;
+
+	// Texture fetches per pixel in each pass
+	unsigned int fetchesPerPass() const;
+
+private:
+	unsigned int width;
+	unsigned int height;
+	GLenum internalFormat;
+	float sigma;
+	unsigned int downscale;
+
+	Blur_Kernel kernel;
+	unsigned int program;
+	unsigned int framebuffers[2];
+	unsigned int textures[2];
+
+	void createTargets();
+	void deleteTargets();
+	void updateKernel();
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef GPU_TIMER_H
+#define GPU_TIMER_H
+
+#include <vector>
+
+using namespace std;
+
+// Measures how long the GPU spends on the commands between begin() and end() with
+// GL_TIME_ELAPSED queries. Results arrive a few frames late, so the timer cycles through a small
+// ring of queries and only reads the ones the GPU has finished, which keeps it from stalling the
+// frame. Only one timer can be running at a time
+class GpuTimer {
+public:
+	// latency is the number of frames a result may be in flight before it's waited on
+	GpuTimer(unsigned int latency = 4);
+	~GpuTimer();
+
+	GpuTimer(const GpuTimer&) = delete;
+	GpuTimer& operator=(const GpuTimer&) = delete;
+
+	void begin();
+	void end();
+
+	// Most recent measurement that has arrived, in milliseconds
+	float milliseconds() const;
+
+	// Moving average over roughly the last 30 measurements, in milliseconds
+	float averageMilliseconds() const;
+
+private:
+	vector<unsigned int> queries;
+	vector<bool> pending;
+	unsigned int next;
+	float last;
+	float average;
+	bool hasAverage;
+
+	// Reads the query in the slot into the averages; waits for it if wait is true
+	void collect(unsigned int slot, bool wait);
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef JUMP_FLOOD_OUTLINE_H
+#define JUMP_FLOOD_OUTLINE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+// Screen-space outlines around the objects marked in a mask, found with a jump flood: every
+// marked texel is a seed, and log2(thickness) passes that each look at nine texels a shrinking
+// step apart leave every texel holding its nearest seed. The composite then shades the pixels
+// within thickness of a seed. The flood runs at a reduced resolution, so the cost is a fixed
+// number of small full-screen passes however many objects are outlined and however detailed they
+// are, and the width is in pixels rather than a scale of each object
+class JumpFloodOutline {
+public:
+	// width and height of the mask; thickness in its pixels; downscale is 1, 2 or 4
+	JumpFloodOutline(unsigned int width, unsigned int height, float thickness, unsigned int downscale = 2);
+	~JumpFloodOutline();
+
+	JumpFloodOutline(const JumpFloodOutline&) = delete;
+	JumpFloodOutline& operator=(const JumpFloodOutline&) = delete;
+
+	// Outlines every texel of mask whose red channel isn't zero, such as an R8 target the selected
+	// objects wrote their IDs to, blending the outline over the bound framebuffer, which has to be
+	// the size of the mask. Pixels inside the mask are left alone. Framebuffer, viewport, depth test
+	// and blending are restored afterwards; the blend function is left at the usual alpha blend
+	void draw(unsigned int mask, const vec3& color);
+
+	void setThickness(float thickness);
+	float getThickness() const;
+
+	// Full-screen passes per draw: the seeds, the flood steps and the composite
+	unsigned int passCount() const;
+
+private:
+	unsigned int width;
+	unsigned int height;
+	unsigned int downscale;
+	float thickness;
+	vector<int> steps;
+
+	unsigned int seedProgram;
+	unsigned int floodProgram;
+	unsigned int compositeProgram;
+	unsigned int framebuffers[2];
+	unsigned int textures[2];
+
+	void updateSteps();
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// OpenGL enums stored in the container. They are spelled out here so the container can be
+// written by tools that never create a GL context
+const unsigned int KTX_RED = 0x1903;
+const unsigned int KTX_RG = 0x8227;
+const unsigned int KTX_RGB = 0x1907;
+const unsigned int KTX_RGBA = 0x1908;
+const unsigned int KTX_SRGB = 0x8C40;
+const unsigned int KTX_SRGB_ALPHA = 0x8C42;
+const unsigned int KTX_UNSIGNED_BYTE = 0x1401;
+const unsigned int KTX_HALF_FLOAT = 0x140B;
+const unsigned int KTX_RGB16F = 0x881B;
+const unsigned int KTX_RGBA8 = 0x8058;
+const unsigned int KTX_SRGB8_ALPHA8 = 0x8C43;
+const unsigned int KTX_COMPRESSED_RGBA_S3TC_DXT1 = 0x83F1;
+const unsigned int KTX_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+const unsigned int KTX_COMPRESSED_SRGB_ALPHA_S3TC_DXT1 = 0x8C4D;
+const unsigned int KTX_COMPRESSED_SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
+const unsigned int KTX_COMPRESSED_RED_RGTC1 = 0x8DBB;
+const unsigned int KTX_COMPRESSED_RG_RGTC2 = 0x8DBD;
+
+// In-memory copy of a KTX 1.1 texture. Every mip level holds the image data of all its
+// faces back to back (one face for 2D textures, six for cubemaps)
+struct KtxTexture {
+	unsigned int glType = 0; // 0 for compressed data
+	unsigned int glTypeSize = 1;
+	unsigned int glFormat = 0; // 0 for compressed data
+	unsigned int glInternalFormat = 0;
+	unsigned int glBaseInternalFormat = 0;
+	int width = 0;
+	int height = 0;
+	unsigned int faces = 1;
+	vector<vector<unsigned char>> levels;
+
+	bool isCompressed() const { return glType == 0; }
+	unsigned int levelCount() const { return (unsigned int)levels.size(); }
+	int levelWidth(unsigned int level) const { return width >> level > 0 ? width >> level : 1; }
+	int levelHeight(unsigned int level) const { return height >> level > 0 ? height >> level : 1; }
+};
+
+// Writes the texture to disk. Returns false if the file could not be written
+bool writeKtx(const string& path, const KtxTexture& texture);
+
+// Reads a texture from disk. Returns false if the file is missing or is not a KTX 1.1 file
+bool readKtx(const string& path, KtxTexture& texture);
+
+// Reads only the header and finds where each mip level is stored, so single levels can be read
+// later with readKtxLevel. The levels of the texture are left empty
+bool readKtxIndex(const string& path, KtxTexture& texture, vector<size_t>& levelOffsets, vector<size_t>& levelSizes);
+
+// Reads one mip level (all of its faces) at an offset found by readKtxIndex
+bool readKtxLevel(const string& path, size_t offset, size_t size, unsigned int faces, vector<unsigned char>& data);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MIP_GENERATOR_H
+#define MIP_GENERATOR_H
+
+#include <vector>
+
+using namespace std;
+
+// Downsampling filters for building mip levels
+enum Mip_Filter {
+	MIP_FILTER_BOX,   // 2x2 average, cheapest, slightly blurry on odd sizes
+	MIP_FILTER_KAISER // Kaiser windowed sinc, keeps more detail in the smaller levels
+};
+
+struct Mip_Settings {
+	Mip_Filter filter = MIP_FILTER_KAISER;
+	bool srgb = false;                  // Filter in linear space and re-encode to sRGB
+	bool wrap = true;                   // Filter across the edges, for GL_REPEAT textures
+	bool preserveAlphaCoverage = false; // Keep the alpha tested area constant for cutout textures
+	float alphaCutoff = 0.5f;           // The alpha test threshold the shader uses
+	unsigned int threadCount = 0;       // 0 uses one thread per core
+};
+
+// Builds the complete mip chain of a tightly packed RGBA8 image, down to 1x1. Level 0 is a copy
+// of the input. Every level is filtered from the full precision level above it
+vector<vector<unsigned char>> generateMipChain(const unsigned char* rgba, int width, int height, const Mip_Settings& settings);
+
+// Number of levels in a full mip chain of the given size
+unsigned int mipLevelCount(int width, int height);
+
+#endif
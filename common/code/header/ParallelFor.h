@@ -0,0 +1,42 @@
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// Splits the range [0, count) into contiguous chunks and runs the body for each chunk on its
+// own thread. The body receives the [begin, end) of its chunk. Passing 0 as threadCount uses
+// one thread per hardware core
+inline void parallelFor(int count, const function<void(int, int)>& body, unsigned int threadCount = 0) {
+	if (count <= 0) {
+		return;
+	}
+
+	if (threadCount == 0) {
+		threadCount = max(1u, thread::hardware_concurrency());
+	}
+	threadCount = min(threadCount, (unsigned int)count);
+
+	// Not worth spinning up threads for a single chunk
+	if (threadCount == 1) {
+		body(0, count);
+		return;
+	}
+
+	vector<thread> workers;
+	int chunk = (count + threadCount - 1) / threadCount;
+	for (int begin = 0; begin < count; begin += chunk) {
+		int end = min(begin + chunk, count);
+		workers.push_back(thread(body, begin, end));
+	}
+
+	for (unsigned int i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+}
+
+#endif
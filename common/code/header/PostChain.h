@@ -0,0 +1,92 @@
+#ifndef POST_CHAIN_H
+#define POST_CHAIN_H
+
+#include <glad/glad.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+enum Post_Effect_Type {
+	POINT_EFFECT,   // Each pixel from the same pixel of its input
+	KERNEL_EFFECT   // Each pixel from a weighted square of input pixels around it
+};
+
+struct Post_Effect {
+	string name;
+	Post_Effect_Type type;
+	string uniforms;            // Point effects: declarations of the uniforms the code reads
+	string code;                // Point effects: GLSL statements that change vec3 color in place
+	vector<float> kernel;       // Kernel effects: size * size weights, row by row from the top
+	unsigned int size;
+	float spacing;              // Kernel effects: texels between taps
+};
+
+// One full-screen pass of a compiled chain: an optional kernel or one axis of it, with the point
+// effects before it applied to every tap it reads and the ones after it applied to its result
+struct Post_Pass {
+	vector<int> prologue;
+	int kernel = -1;            // Index of the kernel effect, or -1 for point effects only
+	int axis = -1;              // 0 or 1 for the horizontal or vertical half of a separated kernel
+	vector<float> weights;
+	vector<int> epilogue;
+	unsigned int program = 0;
+};
+
+// A post-processing chain that compiles its effects into as few full-screen passes as it can.
+// Every pass reads and writes the whole screen, so on most GPUs the number of passes costs more
+// than the arithmetic in them. Runs of point effects generate one shader together and ride along
+// with a neighboring kernel pass: after the kernel, where they are free, or before it for the
+// first run, applied to each tap. Kernels whose weights factor into a column times a row, such
+// as a box or Gaussian blur, are split into a horizontal and a vertical pass, which takes 2n
+// taps instead of n * n
+class PostChain {
+public:
+	PostChain(unsigned int width, unsigned int height);
+	~PostChain();
+
+	PostChain(const PostChain&) = delete;
+	PostChain& operator=(const PostChain&) = delete;
+
+	// uniforms are declarations such as "uniform float exposure;"; effects that share a uniform
+	// name share its value
+	void addPointEffect(const string& name, const string& code, const string& uniforms = "");
+
+	// kernel holds an odd square number of weights, row by row from the top
+	void addKernelEffect(const string& name, const vector<float>& kernel, float spacing = 1.0f);
+
+	// Plans the passes and generates and compiles their shaders. Without fuse every effect gets a
+	// full pass of its own, as separate shaders would, to compare against
+	void compile(bool fuse = true);
+
+	// Runs the chain on source. The last pass draws into the bound framebuffer and viewport; the
+	// ones before it into half float targets owned by the chain. Depth test and blending are
+	// restored afterwards
+	void apply(unsigned int source);
+
+	void setFloat(const string& name, float value);
+
+	unsigned int passCount() const;
+
+	// The passes in order, such as "exposure > blur (x) | blur (y) | edges > invert"
+	string describe() const;
+
+private:
+	unsigned int width;
+	unsigned int height;
+	vector<Post_Effect> effects;
+	vector<Post_Pass> passes;
+	map<string, float> floatUniforms;
+	unsigned int framebuffers[2];
+	unsigned int textures[2];
+
+	void deletePrograms();
+	string shaderSource(const Post_Pass& pass) const;
+};
+
+// Splits kernel into column * row when its weights allow it, within a small tolerance
+bool separateKernel(const vector<float>& kernel, unsigned int size, vector<float>& column, vector<float>& row);
+
+#endif
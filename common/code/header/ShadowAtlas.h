@@ -0,0 +1,110 @@
+#ifndef SHADOW_ATLAS_H
+#define SHADOW_ATLAS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <map>
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+enum Shadow_Light_Type {
+	SPOT_SHADOW,
+	POINT_SHADOW,           // Six tiles, one per cube face in the order of the cubemap targets
+	DIRECTIONAL_SHADOW
+};
+
+// Where one shadow map lives in the atlas, in texels
+struct Shadow_Tile {
+	unsigned int x;
+	unsigned int y;
+	unsigned int size;
+};
+
+// A light whose tiles are to be drawn this frame
+struct Shadow_Update {
+	unsigned int light;
+	vector<Shadow_Tile> tiles;
+};
+
+// Shares one large depth texture between the shadow maps of many lights. Every light gets square
+// tiles whose size follows how large the light appears on screen, handed out by a buddy allocator
+// so tiles of all sizes pack without fragmenting the atlas. Point lights take six tiles of the
+// same size instead of a cubemap, so every light type is sampled from the one texture.
+// Only a budget of tiles is drawn each frame: lights that moved come first, nearer ones before
+// farther ones, and a light that waits longer gains priority. Lights that haven't changed keep
+// their tiles as they are
+class ShadowAtlas {
+public:
+	// Tiles are powers of two from minTileSize to maxTileSize; at most tilesPerFrame tiles are
+	// drawn each frame, except that the most urgent light is always drawn
+	ShadowAtlas(unsigned int atlasSize = 4096, unsigned int maxTileSize = 1024, unsigned int minTileSize = 64, unsigned int tilesPerFrame = 8);
+	~ShadowAtlas();
+
+	ShadowAtlas(const ShadowAtlas&) = delete;
+	ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+	unsigned int addLight(Shadow_Light_Type type);
+	void removeLight(unsigned int light);
+
+	// Records the light for this frame: pixels is its on-screen footprint, distance is from the
+	// camera and movement is how far the light, or anything in its range, moved since last frame
+	void updateLight(unsigned int light, float pixels, float distance, float movement);
+
+	// Resizes tiles to the recorded footprints and picks the lights to draw this frame. Their
+	// tiles are in use from now on, so every update has to be drawn before the atlas is sampled
+	vector<Shadow_Update> schedule();
+
+	// Binds the atlas framebuffer with the viewport and scissor on the tile and clears it
+	void beginTile(const Shadow_Tile& tile);
+	void endTiles();
+
+	// Tiles the light is sampled from; empty until it has been drawn once
+	const vector<Shadow_Tile>& getTiles(unsigned int light) const;
+
+	// Scale in xy and offset in zw that map the [0, 1] coordinates of a tile into the atlas
+	vec4 tileTransform(const Shadow_Tile& tile) const;
+
+	void setTilesPerFrame(unsigned int tilesPerFrame);
+	unsigned int getTilesPerFrame() const;
+
+	// Texels held by tiles, as a fraction of the atlas
+	float occupancy() const;
+
+	unsigned int texture() const;
+
+private:
+	struct AtlasLight {
+		Shadow_Light_Type type;
+		vector<Shadow_Tile> tiles;          // Sampled this frame
+		vector<Shadow_Tile> pendingTiles;   // Allocated at a new size, not drawn yet
+		float pixels;
+		float distance;
+		float movement;                     // Summed since the light was last drawn
+		unsigned int framesWaiting;
+	};
+
+	unsigned int atlasSize;
+	unsigned int maxTileSize;
+	unsigned int minTileSize;
+	unsigned int tilesPerFrame;
+	unsigned int depthTexture;
+	unsigned int framebuffer;
+
+	map<unsigned int, AtlasLight> lights;
+	unsigned int nextLight;
+	vector<vector<Shadow_Tile>> freeTiles;  // One list per size, largest first
+	unsigned long long usedTexels;
+
+	unsigned int level(unsigned int tileSize) const;
+	unsigned int tileSizeFor(const AtlasLight& light) const;
+	unsigned int allocatedSize(const AtlasLight& light) const;     // Of the newest tiles, 0 without any
+	bool allocate(unsigned int tileSize, Shadow_Tile& tile);
+	void release(const Shadow_Tile& tile);
+	bool allocateTiles(unsigned int tileSize, unsigned int count, vector<Shadow_Tile>& tiles);
+	void releaseTiles(vector<Shadow_Tile>& tiles);
+};
+
+#endif
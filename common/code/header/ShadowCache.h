@@ -0,0 +1,54 @@
+#ifndef SHADOW_CACHE_H
+#define SHADOW_CACHE_H
+
+#include <glad/glad.h>
+
+using namespace std;
+
+// Keeps the static casters of a shadow map in a map of their own, so they only have to be drawn
+// again when their light or one of them changes. Each frame the cached layers are copied into the
+// shadow map that gets sampled and only the dynamic casters are drawn on top. A copy costs a
+// fraction of drawing the casters, since it moves each texel once without any geometry.
+// The map is layered: the six faces of a cube map or the layers of a 2D array texture, each of
+// which can be marked dirty on its own
+class ShadowCache {
+public:
+	// target is GL_TEXTURE_CUBE_MAP or GL_TEXTURE_2D_ARRAY; internalFormat has to match the
+	// shadow map the cache is copied into
+	ShadowCache(GLenum target, unsigned int size, unsigned int layers, GLenum internalFormat = GL_DEPTH_COMPONENT);
+	~ShadowCache();
+
+	ShadowCache(const ShadowCache&) = delete;
+	ShadowCache& operator=(const ShadowCache&) = delete;
+
+	// Marks every layer, or one layer, to be drawn again
+	void invalidate();
+	void invalidate(unsigned int layer);
+
+	// Layers that need drawing, one bit each
+	unsigned int dirtyMask() const;
+
+	// Binds the cache for drawing static casters, after clearing the dirty layers. Draw into the
+	// dirty layers only and call endRebuild() after
+	void beginRebuild();
+	void endRebuild();
+
+	// Copies every layer into shadowMap, which has to have the same target, size and format
+	void copyTo(unsigned int shadowMap);
+
+	unsigned int texture() const;
+
+private:
+	GLenum target;
+	unsigned int size;
+	unsigned int layers;
+	unsigned int cacheTexture;
+	unsigned int layeredFramebuffer;
+	unsigned int layerFramebuffers[2];
+	unsigned int dirty;
+
+	// Attaches one layer of texture to the framebuffer bound to framebufferTarget
+	void attachLayer(GLenum framebufferTarget, unsigned int texture, unsigned int layer);
+};
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef TANGENT_GENERATOR_H
+#define TANGENT_GENERATOR_H
+
+#include <vector>
+
+using namespace std;
+
+// The vertex and index arrays of one mesh. Every array is read with its own stride in floats, so
+// the fields of an interleaved vertex struct can be pointed at directly
+struct Tangent_Mesh {
+	const float* positions = nullptr;      // xyz
+	const float* normals = nullptr;        // xyz, need not be normalized
+	const float* texCoords = nullptr;      // uv
+	unsigned int positionStride = 3;
+	unsigned int normalStride = 3;
+	unsigned int texCoordStride = 2;
+	unsigned int vertexCount = 0;
+
+	const unsigned int* indices = nullptr; // Triangle list; without one every three vertices are a triangle
+	unsigned int indexCount = 0;
+
+	float* tangents = nullptr;             // Output: the tangent in xyz and the sign of the bitangent in w
+	unsigned int tangentStride = 4;
+};
+
+// Generates per vertex tangents the way MikkTSpace does, so normal maps baked against MikkTSpace
+// shade without seams: every face's direction of increasing u is projected onto the tangent plane
+// of each of its vertex normals and summed, weighted by the angle of the face at that vertex. The
+// bitangent is sign * cross(normal, tangent), which the shader rebuilds from the one vec4.
+// MikkTSpace splits a vertex whose faces disagree on the texture's orientation, as on a mirrored
+// seam. The vertices here are fixed, so such a vertex takes the orientation covering more of it.
+// The faces are processed four at a time with SSE2 where the compiler has it
+void generateTangents(const Tangent_Mesh& mesh);
+
+// Generates the tangents of several meshes, one mesh per thread (0 uses one thread per core)
+void generateTangents(const vector<Tangent_Mesh>& meshes, unsigned int threadCount = 0);
+
+#endif
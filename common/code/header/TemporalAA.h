@@ -0,0 +1,50 @@
+#ifndef TEMPORAL_AA_H
+#define TEMPORAL_AA_H
+
+#include <glad/glad.h>
+
+using namespace std;
+
+// Temporal anti-aliasing: every frame is rendered with its projection shifted by a different
+// sub-pixel offset and blended into a history of the frames before it. The history is first
+// moved to where this frame sees it, through a velocity buffer, then clamped to the colors
+// around the pixel in this frame, so what was uncovered or changed doesn't leave ghosts. The
+// history settles on the average of many offsets, which smooths edges, and of many frames, which
+// lets noisy effects such as a rotated PCF kernel take fewer samples each frame
+class TemporalAA {
+public:
+	// feedback is how much of the history each frame keeps; 0.9 averages roughly the last 10 frames
+	TemporalAA(unsigned int width, unsigned int height, float feedback = 0.9f);
+	~TemporalAA();
+
+	TemporalAA(const TemporalAA&) = delete;
+	TemporalAA& operator=(const TemporalAA&) = delete;
+
+	// Blends current, this frame's color, into the history and returns the texture holding the
+	// result, which becomes the history of the next frame. velocity holds, in RG, how far each
+	// pixel moved since the last frame in texture coordinates, measured without the jitter.
+	// Framebuffer, viewport, depth test and blending are restored afterwards
+	unsigned int resolve(unsigned int current, unsigned int velocity);
+
+	// The framebuffer the last resolve wrote to, to blit the result from
+	unsigned int resultFramebuffer() const;
+
+	// Drops the history, for when it no longer matches the frames to come
+	void reset();
+
+	void setFeedback(float feedback);
+	float getFeedback() const;
+
+private:
+	unsigned int width;
+	unsigned int height;
+	float feedback;
+	bool hasHistory;
+	unsigned int latest;    // The history target the last resolve wrote to
+
+	unsigned int program;
+	unsigned int framebuffers[2];
+	unsigned int textures[2];
+};
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <string>
+
+#include "KtxFile.h"
+#include "TextureCompressor.h"
+
+using namespace std;
+
+// What a texture is used for decides which block format it is compressed to
+enum Texture_Usage {
+	TEXTURE_COLOR,  // BC1, or BC3 when the image has alpha
+	TEXTURE_NORMAL, // BC5, the shader reconstructs z from x and y
+	TEXTURE_HEIGHT, // BC4
+	TEXTURE_CUTOUT  // BC3, alpha tested (grass, foliage); mips keep the alpha coverage of the top level
+};
+
+// Compressed textures are cached next to the source image, e.g. "wood.png" loaded as sRGB color
+// becomes "wood.png.color.srgb.ktx". The cache holds every mip level so nothing is generated at
+// load time, and the block format is recorded in the file itself
+string textureCachePath(const string& sourcePath, Texture_Usage usage, bool srgb);
+
+// Builds the mip chain of a decoded RGBA8 image (filtered in linear space for sRGB images) and
+// stores it in the cache, block compressed unless compress is false. When psnr is given, it
+// receives the quality of the top level measured against the source image
+bool buildTextureCache(const string& sourcePath, const unsigned char* rgba, int width, int height, Texture_Usage usage, bool srgb, bool compress = true, double* psnr = nullptr);
+
+// True if the source image has a cache entry that is at least as new as the image
+bool textureCacheIsCurrent(const string& sourcePath, Texture_Usage usage, bool srgb);
+
+// True if the cache file exists and is at least as new as the file it was built from
+bool cacheFileIsCurrent(const string& cachePath, const string& sourcePath);
+
+// True if the driver can sample the format the cache entry is stored in
+bool textureCacheFormatSupported(const KtxTexture& texture);
+
+// Creates a texture from the cache entry of the source image, uploading the stored mips without
+// generating any. Returns 0 if there is no entry,
+// the entry is older than the source, or the driver doesn't support the block format, in which
+// case the caller falls back to uploading the uncompressed image
+unsigned int loadCachedTexture(const string& sourcePath, Texture_Usage usage, bool srgb);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef TEXTURE_COMPRESSOR_H
+#define TEXTURE_COMPRESSOR_H
+
+#include <vector>
+
+using namespace std;
+
+// Block compressed formats the CPU encoder can produce. Every format stores 4x4 pixel blocks
+enum Texture_Compression {
+	COMPRESSION_BC1, // RGB, 8 bytes per block
+	COMPRESSION_BC3, // RGBA, 16 bytes per block
+	COMPRESSION_BC4, // Single channel (height maps), 8 bytes per block
+	COMPRESSION_BC5  // Two channels (tangent space normal maps), 16 bytes per block
+};
+
+// Returns the number of bytes of a single 4x4 block
+unsigned int blockSize(Texture_Compression format);
+
+// Returns the number of bytes the compressed image of the given size takes up
+size_t compressedSize(int width, int height, Texture_Compression format);
+
+// Compresses a tightly packed RGBA8 image. The rows of blocks are split across threadCount
+// threads (0 uses one per core). BC4 encodes the red channel and BC5 the red and green channels
+vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, Texture_Compression format, unsigned int threadCount = 0);
+
+// Decodes a compressed image back into tightly packed RGBA8 pixels. Channels the format does
+// not store are written as 0 (alpha as 255)
+vector<unsigned char> decompressImage(const unsigned char* blocks, int width, int height, Texture_Compression format);
+
+// Peak signal-to-noise ratio in dB between two RGBA8 images over the first `channels` channels
+double computePSNR(const unsigned char* reference, const unsigned char* test, int width, int height, int channels);
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TextureCache.h"
+
+using namespace std;
+
+class TextureUploader;
+class TextureStreamer;
+
+// How a texture is created from an image file. The defaults give a trilinear, repeating, linear
+// color texture with a full mip chain, which is what most demos want
+struct Texture_Options {
+	Texture_Usage usage = TEXTURE_COLOR;  // Also picks the shared sampler and the cache format
+	bool srgb = false;                    // Color stored in sRGB, decoded to linear when sampled
+	bool useCache = true;                 // Use the compressed cache entry of the image when there is one
+	TextureUploader* uploader = nullptr;  // Streams the pixels in over several frames instead of uploading now
+	TextureStreamer* streamer = nullptr;  // Keeps only the cached mip levels the view needs resident
+};
+
+// Frees pixels decoded by stb_image
+struct Image_Deleter {
+	void operator()(unsigned char* pixels) const;
+};
+
+// An image decoded on the CPU, ready to be turned into a texture
+struct Texture_Image {
+	unique_ptr<unsigned char[], Image_Deleter> pixels;
+	int width = 0;
+	int height = 0;
+	int nrComponents = 0;
+};
+
+// Decodes an image file without touching OpenGL, so it can run on any thread. Follows the
+// stbi_set_flip_vertically_on_load setting of the demo
+bool decodeImage(const string& path, Texture_Image& image);
+
+// Creates a texture with a full mip chain from a decoded image
+unsigned int createTexture(const Texture_Image& image, const Texture_Options& options);
+
+// Creates a texture from an image file, preferring the cache entry of the image when there is one.
+// Prints an error and returns a texture with no image if the file can't be read
+unsigned int loadTexture(const string& path, const Texture_Options& options);
+unsigned int loadTexture(const string& path, Texture_Usage usage = TEXTURE_COLOR, bool srgb = false);
+
+// Loads several textures, decoding all the images at once on worker threads before uploading
+vector<unsigned int> loadTextures(const vector<string>& paths, const vector<Texture_Options>& options);
+
+// Allocates every mip level of the bound 2D texture, as immutable storage (glTexStorage2D) when
+// the driver has it, so the driver never has to check the levels for completeness at draw time
+void allocateTextureStorage(int width, int height, int levels, unsigned int internalFormat);
+
+// The sampler shared by every texture of a usage: trilinear and anisotropic, repeating except
+// for cutouts, which clamp so their transparent borders don't pick up texels from the opposite edge
+unsigned int textureSampler(Texture_Usage usage);
+
+// Anisotropy of the shared samplers, clamped to what the driver supports. 1 turns it off
+void setTextureAnisotropy(float anisotropy);
+
+// Binds a texture to a texture unit together with the shared sampler of its usage. Textures that
+// weren't created here, such as framebuffer attachments, are bound without a sampler so their
+// own parameters apply, as are textures a TextureUploader is still streaming in
+void bindTexture(unsigned int unit, unsigned int texture);
+
+// Called by TextureUploader once every pixel and mip of a texture is in place. From then on a
+// texture loaded through an uploader binds with the sampler of its usage
+void finishTextureUpload(unsigned int texture);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "KtxFile.h"
+#include "TextureCache.h"
+
+using namespace std;
+using namespace glm;
+
+// Keeps only the mip levels of cached textures that the current view actually needs resident.
+// Textures start out with just their small levels; every frame the draws record how large each
+// texture appears on screen, and the streamer reads finer levels from the cache file on a worker
+// thread and uploads them one level at a time, while levels that are no longer needed are dropped.
+// The visible range of a texture is clamped with GL_TEXTURE_BASE_LEVEL/GL_TEXTURE_MAX_LEVEL.
+class TextureStreamer {
+public:
+	// budgetBytes caps the memory of all streamed levels; levels no larger than residentSize are
+	// always kept; at most levelsPerFrame levels are uploaded each frame
+	TextureStreamer(size_t budgetBytes = 256 << 20, int residentSize = 64, unsigned int levelsPerFrame = 2);
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// Creates a texture from the cache entry of the source image with only its small levels
+	// uploaded. Returns 0 if there is no cache entry
+	unsigned int load(const string& sourcePath, Texture_Usage usage, bool srgb);
+
+	// Records that a draw this frame used the texture across about `pixels` screen pixels
+	void recordUsage(unsigned int texture, float pixels);
+
+	// Starts reads for levels that are needed, uploads the ones that finished, and drops levels
+	// that no draw needs anymore. Call once per frame after recording the frame's usage
+	void update();
+
+	// Memory taken up by the resident levels of every texture
+	size_t residentBytes() const;
+
+	// Approximate on-screen diameter in pixels of a bounding sphere given in view space
+	static float screenFootprint(const vec3& viewCenter, float radius, float fovY, int viewportHeight);
+
+private:
+	struct StreamedTexture {
+		string cachePath;
+		KtxTexture info;            // Header of the cache entry, levels left empty
+		vector<size_t> levelOffsets;
+		vector<size_t> levelSizes;
+		int residentLevel;          // Finest level uploaded, also the texture's base level
+		int coarsestStreamedLevel;  // Levels past this one are always resident
+		int requestedLevel;         // Finest level any draw asked for this frame
+		int pendingLevel;           // Level being read on the worker thread, -1 if none
+		future<vector<unsigned char>> pendingData;
+	};
+
+	map<unsigned int, StreamedTexture> textures;
+	size_t budgetBytes;
+	int residentSize;
+	unsigned int levelsPerFrame;
+	size_t usedBytes;
+
+	void uploadLevel(unsigned int id, StreamedTexture& texture, int level, const vector<unsigned char>& data);
+	void dropLevel(unsigned int id, StreamedTexture& texture);
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+#include <glad/glad.h>
+
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+// Streams texture data to the GPU in the background of the render loop. Pixels are staged in a
+// small ring of pixel unpack buffers and copied into the texture from there, so glTexSubImage2D
+// returns immediately instead of blocking while the driver copies from client memory. Every
+// frame at most frameBudget bytes are staged, and a staging buffer is only reused once the
+// fence placed after its last copy has signaled, so uploads never stall the frame.
+class TextureUploader {
+public:
+	// ringSize staging buffers of slotBytes each; images larger than a slot go up in row bands
+	TextureUploader(unsigned int ringSize = 3, unsigned int slotBytes = 4 << 20, unsigned int frameBudget = 8 << 20);
+	~TextureUploader();
+
+	TextureUploader(const TextureUploader&) = delete;
+	TextureUploader& operator=(const TextureUploader&) = delete;
+
+	// Creates the texture right away and queues its pixels (copied, the caller may free them).
+	// RGB images are expanded to RGBA while staging. Until the upload completes the texture shows
+	// the rows that have arrived so far, and the rest of its storage is undefined, not black. Only
+	// the top level is sampled until then; mipmaps are generated once the last row is in, if requested
+	unsigned int queueTexture(const unsigned char* pixels, int width, int height, int nrComponents, bool srgb, bool generateMipmaps = true);
+
+	// Stages and copies queued data up to the frame budget. Call once per frame
+	void update();
+
+	// True once every queued texture is fully uploaded
+	bool isIdle() const;
+
+	// Bytes still waiting to be staged
+	size_t pendingBytes() const;
+
+	// Bytes staged in the last call to update()
+	size_t bytesLastFrame() const;
+
+private:
+	struct UploadJob {
+		unsigned int texture;
+		int width;
+		int height;
+		int nrComponents;   // Channels of the source pixels
+		GLenum format;      // Format the rows are staged in
+		bool generateMipmaps;
+		int nextRow;
+		vector<unsigned char> pixels;
+	};
+
+	struct StagingSlot {
+		unsigned int buffer;
+		GLsync fence;
+	};
+
+	vector<StagingSlot> slots;
+	unsigned int nextSlot;
+	unsigned int slotBytes;
+	unsigned int frameBudget;
+	size_t stagedLastFrame;
+	deque<UploadJob> jobs;
+
+	// Bytes per row once staged (RGB rows grow to RGBA)
+	static size_t stagedRowBytes(const UploadJob& job);
+
+	// Copies source rows into staging memory, expanding RGB to RGBA on the way
+	static void stageRows(const UploadJob& job, int firstRow, int rowCount, unsigned char* destination);
+};
+
+#endif
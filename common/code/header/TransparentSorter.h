@@ -0,0 +1,48 @@
+#ifndef TRANSPARENT_SORTER_H
+#define TRANSPARENT_SORTER_H
+
+#include <cstdint>
+#include <vector>
+
+using namespace std;
+
+// How a sort went
+enum Sort_Path {
+	COHERENT_SORT,  // An insertion sort fixed up last frame's order
+	RADIX_SORT
+};
+
+// Orders transparent objects back to front for blending. Every object gets a 64-bit key: its
+// depth, with the bits of the float turned so they sort as integers, above its index. Objects at
+// the same depth keep distinct keys and draw in index order instead of being dropped.
+// The view changes little between frames, so last frame's order is almost right: the keys are
+// laid out in that order and an insertion sort fixes them up in close to linear time. When too
+// much has moved, or the objects changed, an LSD radix sort runs instead, skipping the digits all
+// keys share. Every buffer is kept between frames, so sorting doesn't allocate once the largest
+// count has been seen
+class TransparentSorter {
+public:
+	TransparentSorter();
+
+	// Returns the indices [0, count) ordered by depth, farthest first. depths[i] is the view depth
+	// of object i; any float sorts, including negative depths behind the camera
+	const vector<unsigned int>& sortBackToFront(const float* depths, unsigned int count);
+
+	// Forgets last frame's order, for when the objects behind the indices changed
+	void reset();
+
+	Sort_Path lastPath() const;
+
+private:
+	vector<uint64_t> keys;
+	vector<uint64_t> scratch;
+	vector<unsigned int> order;
+	bool hasOrder;       // order holds last frame's result
+	Sort_Path path;
+
+	static uint64_t makeKey(float depth, unsigned int index);
+	bool insertionSort(unsigned int count, size_t maxMoves);
+	void radixSort(unsigned int count);
+};
+
+#endif
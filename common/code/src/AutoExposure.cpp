@@ -0,0 +1,174 @@
+#include "../header/AutoExposure.h"
+#include "../header/FullscreenPass.h"
+#include "../header/TextureLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+	// Averages the log luminance of four bilinear taps spread over the footprint of the target
+	// texel, so the reduction doesn't skip most of a source that is larger than the target
+	const char* LOG_LUMINANCE_SHADER =
+		"#version 330 core\n"
+		"out float FragColor;\n"
+		"in vec2 TexCoords;\n"
+		"uniform sampler2D hdrBuffer;\n"
+		"uniform vec2 targetTexel;\n"
+		"float logLuminance(vec2 uv) {\n"
+		"    float luminance = dot(texture(hdrBuffer, uv).rgb, vec3(0.2126, 0.7152, 0.0722));\n"
+		"    return log(max(luminance, 0.0001));\n"
+		"}\n"
+		"void main() {\n"
+		"    vec2 spread = targetTexel * 0.25;\n"
+		"    FragColor = 0.25 * (logLuminance(TexCoords + vec2(-spread.x, -spread.y))\n"
+		"                      + logLuminance(TexCoords + vec2( spread.x, -spread.y))\n"
+		"                      + logLuminance(TexCoords + vec2(-spread.x,  spread.y))\n"
+		"                      + logLuminance(TexCoords + vec2( spread.x,  spread.y)));\n"
+		"}\n";
+}
+
+AutoExposure::AutoExposure(const Exposure_Settings& settings, unsigned int size, unsigned int readbackLatency)
+	: settings(settings), size(max(1u, size)), next(0), measured(false), measuredLogLuminance(0.0f), adaptedLogLuminance(0.0f) {
+	levels = 1;
+	while ((this->size >> levels) > 0) {
+		levels++;
+	}
+
+	program = compileProgram(FULLSCREEN_VERTEX_SHADER, LOG_LUMINANCE_SHADER, "AUTO_EXPOSURE");
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "hdrBuffer"), 0);
+	glUniform2f(glGetUniformLocation(program, "targetTexel"), 1.0f / this->size, 1.0f / this->size);
+
+	// 32-bit float keeps the mip averages of the logs exact enough all the way down
+	glGenTextures(1, &luminanceTexture);
+	glBindTexture(GL_TEXTURE_2D, luminanceTexture);
+	allocateTextureStorage(this->size, this->size, levels, GL_R32F);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, luminanceTexture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "ERROR::AUTO_EXPOSURE::FRAMEBUFFER_NOT_COMPLETE" << endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	readbackBuffers.resize(max(1u, readbackLatency));
+	fences.resize(readbackBuffers.size(), nullptr);
+	glGenBuffers((GLsizei)readbackBuffers.size(), readbackBuffers.data());
+	for (unsigned int buffer : readbackBuffers) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
+		glBufferData(GL_PIXEL_PACK_BUFFER, sizeof(float), NULL, GL_STREAM_READ);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+AutoExposure::~AutoExposure() {
+	for (GLsync fence : fences) {
+		if (fence) {
+			glDeleteSync(fence);
+		}
+	}
+	glDeleteBuffers((GLsizei)readbackBuffers.size(), readbackBuffers.data());
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &luminanceTexture);
+	glDeleteProgram(program);
+}
+
+void AutoExposure::update(unsigned int hdrTexture, float deltaTime) {
+	collectReadbacks();
+	measure(hdrTexture);
+
+	if (!measured) {
+		return;
+	}
+
+	// Adapt in log space, so a step from 1 to 10 takes as long as one from 10 to 100
+	float speed = measuredLogLuminance > adaptedLogLuminance ? settings.speedUp : settings.speedDown;
+	adaptedLogLuminance += (measuredLogLuminance - adaptedLogLuminance) * (1.0f - exp(-deltaTime * speed));
+}
+
+float AutoExposure::getExposure() const {
+	float exposure = settings.keyValue / getAdaptedLuminance();
+	return min(max(exposure, settings.minExposure), settings.maxExposure);
+}
+
+float AutoExposure::getAdaptedLuminance() const {
+	return measured ? exp(adaptedLogLuminance) : settings.keyValue;
+}
+
+void AutoExposure::measure(unsigned int hdrTexture) {
+	// A measurement still in flight in this slot is skipped rather than waited on
+	if (fences[next]) {
+		return;
+	}
+
+	GLint previousFramebuffer;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(0, 0, size, size);
+	glUseProgram(program);
+	bindTexture(0, hdrTexture);
+	drawFullscreenTriangle();
+
+	// Average down to one texel, then copy it into the pack buffer without waiting for it
+	glBindTexture(GL_TEXTURE_2D, luminanceTexture);
+	glGenerateMipmap(GL_TEXTURE_2D);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[next]);
+	glGetTexImage(GL_TEXTURE_2D, levels - 1, GL_RED, GL_FLOAT, (void*)0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	fences[next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	next = (next + 1) % readbackBuffers.size();
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (blend) {
+		glEnable(GL_BLEND);
+	}
+}
+
+void AutoExposure::collectReadbacks() {
+	// Walk the slots from oldest to newest, so the last one read is the most recent result
+	for (unsigned int i = 0; i < readbackBuffers.size(); i++) {
+		unsigned int slot = (next + i) % readbackBuffers.size();
+		if (!fences[slot]) {
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(fences[slot], 0, 0);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			continue;
+		}
+		glDeleteSync(fences[slot]);
+		fences[slot] = nullptr;
+
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffers[slot]);
+		float* logLuminance = (float*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, sizeof(float), GL_MAP_READ_BIT);
+		if (logLuminance) {
+			measuredLogLuminance = *logLuminance;
+			glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+			// Start fully adapted to the first measurement instead of fading in from nothing
+			if (!measured) {
+				adaptedLogLuminance = measuredLogLuminance;
+				measured = true;
+			}
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	}
+}
@@ -0,0 +1,119 @@
+#include <glad/glad.h>
+
+#include "../header/ColorGrading.h"
+#include "../header/TextureLoader.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+	float linearToSrgb(float value) {
+		value = min(max(value, 0.0f), 1.0f);
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	float srgbToLinear(float value) {
+		value = min(max(value, 0.0f), 1.0f);
+		return value <= 0.04045f ? value / 12.92f : pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// Trilinear lookup into a strip grade image at an sRGB color
+	void sampleGrade(const Texture_Image& grade, int gradeSize, const float color[3], float result[3]) {
+		float position[3];
+		int low[3];
+		int high[3];
+		float fraction[3];
+		for (int c = 0; c < 3; c++) {
+			position[c] = min(max(color[c], 0.0f), 1.0f) * (gradeSize - 1);
+			low[c] = (int)position[c];
+			high[c] = min(low[c] + 1, gradeSize - 1);
+			fraction[c] = position[c] - low[c];
+		}
+
+		for (int c = 0; c < 3; c++) {
+			result[c] = 0.0f;
+		}
+		for (int corner = 0; corner < 8; corner++) {
+			int r = corner & 1 ? high[0] : low[0];
+			int g = corner & 2 ? high[1] : low[1];
+			int b = corner & 4 ? high[2] : low[2];
+			float weight = (corner & 1 ? fraction[0] : 1.0f - fraction[0])
+				* (corner & 2 ? fraction[1] : 1.0f - fraction[1])
+				* (corner & 4 ? fraction[2] : 1.0f - fraction[2]);
+
+			const unsigned char* texel = grade.pixels.get() + ((size_t)g * grade.width + (size_t)b * gradeSize + r) * grade.nrComponents;
+			for (int c = 0; c < 3; c++) {
+				result[c] += weight * texel[c] / 255.0f;
+			}
+		}
+	}
+}
+
+unsigned int createColorLut(const string& gradePath, bool encodeSrgb, unsigned int size) {
+	size = max(2u, size);
+
+	Texture_Image grade;
+	int gradeSize = 0;
+	if (!gradePath.empty()) {
+		if (!decodeImage(gradePath, grade) || grade.nrComponents < 3 || grade.width != grade.height * grade.height) {
+			cout << "Color grade " << gradePath << " is not a size * size by size strip, using a neutral grade" << endl;
+			grade.pixels.reset();
+		} else {
+			gradeSize = grade.height;
+		}
+	}
+
+	vector<float> table((size_t)size * size * size * 3);
+	float* cell = table.data();
+	for (unsigned int b = 0; b < size; b++) {
+		for (unsigned int g = 0; g < size; g++) {
+			for (unsigned int r = 0; r < size; r++, cell += 3) {
+				// The cell's index is the square root of the linear color it stands for
+				unsigned int index[3] = { r, g, b };
+				float color[3];
+				for (int c = 0; c < 3; c++) {
+					float root = (float)index[c] / (size - 1);
+					color[c] = linearToSrgb(root * root);
+				}
+
+				if (grade.pixels) {
+					float graded[3];
+					sampleGrade(grade, gradeSize, color, graded);
+					copy(graded, graded + 3, color);
+				}
+
+				for (int c = 0; c < 3; c++) {
+					cell[c] = encodeSrgb ? color[c] : srgbToLinear(color[c]);
+				}
+			}
+		}
+	}
+
+	unsigned int lut;
+	glGenTextures(1, &lut);
+	glBindTexture(GL_TEXTURE_3D, lut);
+	glTexImage3D(GL_TEXTURE_3D, 0, GL_RGB16F, size, size, size, 0, GL_RGB, GL_FLOAT, table.data());
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_3D, 0);
+	return lut;
+}
+
+bool enableSrgbFramebuffer() {
+	GLint encoding = GL_LINEAR;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_BACK_LEFT, GL_FRAMEBUFFER_ATTACHMENT_COLOR_ENCODING, &encoding);
+	if (encoding != GL_SRGB) {
+		return false;
+	}
+	glEnable(GL_FRAMEBUFFER_SRGB);
+	return true;
+}
@@ -0,0 +1,144 @@
+#include "../header/ConeStepMap.h"
+#include "../header/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+// The depth map in floats, read with bilinear filtering like the texture the shader marches. It
+// is stored with a border as wide as the search window, filled by wrapping or clamping, so the
+// search never has to check the edges
+struct DepthField {
+	int width = 0;
+	int border = 0;
+	vector<float> depths;
+
+	DepthField(const unsigned char* pixels, int width, int height, int components, int border, bool wrap)
+		: width(width + 2 * border), border(border) {
+		depths.resize((size_t)this->width * (height + 2 * border));
+		for (int y = -border; y < height + border; y++) {
+			for (int x = -border; x < width + border; x++) {
+				int sourceX = wrap ? ((x % width) + width) % width : clamp(x, 0, width - 1);
+				int sourceY = wrap ? ((y % height) + height) % height : clamp(y, 0, height - 1);
+				depths[(size_t)(y + border) * this->width + x + border] = pixels[((size_t)sourceY * width + sourceX) * components] / 255.0f;
+			}
+		}
+	}
+
+	float texel(int x, int y) const {
+		return depths[(size_t)(y + border) * width + x + border];
+	}
+
+	// x and y in texels, with texel centers at whole numbers
+	float sample(float x, float y) const {
+		float x0 = floor(x);
+		float y0 = floor(y);
+		float fx = x - x0;
+		float fy = y - y0;
+		const float* row = &depths[(size_t)((int)y0 + border) * width + (int)x0 + border];
+
+		float top = row[0] * (1.0f - fx) + row[1] * fx;
+		float bottom = row[width] * (1.0f - fx) + row[width + 1] * fx;
+		return top * (1.0f - fy) + bottom * fy;
+	}
+};
+
+struct WindowOffset {
+	int x;
+	int y;
+	float distance;
+};
+
+// Offsets of the search window, nearest first, so the search can stop at the first one that is
+// too far away to narrow the cone any more
+static vector<WindowOffset> windowOffsets(int radius) {
+	vector<WindowOffset> offsets;
+	for (int y = -radius; y <= radius; y++) {
+		for (int x = -radius; x <= radius; x++) {
+			float distance = sqrt((float)(x * x + y * y));
+			if ((x != 0 || y != 0) && distance <= radius) {
+				offsets.push_back({ x, y, distance });
+			}
+		}
+	}
+	sort(offsets.begin(), offsets.end(), [](const WindowOffset& a, const WindowOffset& b) {
+		return a.distance < b.distance;
+	});
+	return offsets;
+}
+
+vector<unsigned char> generateConeStepMap(const unsigned char* pixels, int width, int height, int components, const Cone_Step_Settings& settings) {
+	// The walks stay within the window, and bilinear filtering reads one texel further
+	int radius = max(1, settings.searchRadius);
+	vector<WindowOffset> offsets = windowOffsets(radius);
+	DepthField field(pixels, width, height, components, radius + 2, settings.wrap);
+
+	// Ratios are found in texels per unit of depth. Across the larger side a texel is the smaller
+	// step in texture coordinates, so dividing by it never widens a cone
+	float texelsPerUnit = (float)max(width, height);
+	float maxRatio = clamp(settings.maxConeRatio, 0.0f, 1.0f) * texelsPerUnit;
+
+	vector<unsigned char> coneMap((size_t)width * height * 2);
+	parallelFor(height, [&](int begin, int end) {
+		for (int y = begin; y < end; y++) {
+			for (int x = 0; x < width; x++) {
+				float sourceDepth = field.texel(x, y);
+
+				// A cone that reaches past the window before it reaches the surface would cover
+				// texels nobody looked at
+				float ratio = maxRatio;
+				if (sourceDepth > 0.0f) {
+					ratio = min(ratio, radius / sourceDepth);
+				}
+
+				for (const WindowOffset& offset : offsets) {
+					// A ray leaves the depth map only past the texel it passed through, so from
+					// here on no texel can narrow the cone below its current ratio
+					if (offset.distance >= ratio * sourceDepth) {
+						break;
+					}
+
+					// A ray from the surface through a texel on the surface never enters the map, and
+					// one that comes out deeper than the source texel doesn't narrow its cone
+					float targetDepth = field.texel(x + offset.x, y + offset.y);
+					if (targetDepth <= 0.0f || targetDepth >= sourceDepth) {
+						continue;
+					}
+
+					// Follow the ray from the source texel at the surface through the target texel
+					// on to where it comes out of the depth map again, a texel at a time. The walk
+					// ends at the depth of the source texel, or earlier where it leaves the window
+					float directionX = offset.x / targetDepth;
+					float directionY = offset.y / targetDepth;
+					float endDepth = min(sourceDepth, radius * targetDepth / offset.distance);
+					int steps = max(1, (int)ceil((endDepth - targetDepth) * offset.distance / targetDepth));
+					float stepDepth = (endDepth - targetDepth) / steps;
+
+					float exitDepth = -1.0f;
+					for (int i = 1; i <= steps; i++) {
+						float rayDepth = targetDepth + stepDepth * i;
+						if (field.sample(x + directionX * rayDepth, y + directionY * rayDepth) > rayDepth) {
+							exitDepth = rayDepth;
+							break;
+						}
+					}
+
+					// The cone has to stop short of where the ray comes out above the source texel,
+					// so the ray can't cross the depth map a second time inside it
+					if (exitDepth >= 0.0f) {
+						float exitDistance = offset.distance * exitDepth / targetDepth;
+						ratio = min(ratio, exitDistance / (sourceDepth - exitDepth));
+					}
+				}
+
+				// Rounded down so the stored cone is never wider than the one found
+				size_t index = (size_t)y * width + x;
+				float encoded = sqrt(ratio / texelsPerUnit);
+				coneMap[index * 2] = pixels[index * components];
+				coneMap[index * 2 + 1] = (unsigned char)min(255.0f, floor(encoded * 255.0f));
+			}
+		}
+	}, settings.threadCount);
+	return coneMap;
+}
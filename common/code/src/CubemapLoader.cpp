@@ -0,0 +1,315 @@
+#include <glad/glad.h>
+
+#include "../header/CubemapLoader.h"
+#include "../header/KtxFile.h"
+#include "../header/ParallelFor.h"
+#include "../header/TextureCache.h"
+#include "../header/stb_image.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CUBEMAP_LOADER_SSE2
+#endif
+
+using namespace std;
+
+static const float PI = 3.14159265358979f;
+
+// A face texel at (s, t) in [-1, 1] looks along major + s * sAxis + t * tAxis. Row 0 of every
+// face is its top row, following the OpenGL cube map face layout
+struct Face_Axes {
+	float major[3];
+	float sAxis[3];
+	float tAxis[3];
+};
+
+static const Face_Axes faceAxes[6] = {
+	{ {  1,  0,  0 }, {  0,  0, -1 }, { 0, -1,  0 } }, // +X
+	{ { -1,  0,  0 }, {  0,  0,  1 }, { 0, -1,  0 } }, // -X
+	{ {  0,  1,  0 }, {  1,  0,  0 }, { 0,  0,  1 } }, // +Y
+	{ {  0, -1,  0 }, {  1,  0,  0 }, { 0,  0, -1 } }, // -Y
+	{ {  0,  0,  1 }, {  1,  0,  0 }, { 0, -1,  0 } }, // +Z
+	{ {  0,  0, -1 }, { -1,  0,  0 }, { 0, -1,  0 } }  // -Z
+};
+
+unsigned int loadCubemap(const vector<string>& faces) {
+	struct Face_Image {
+		unsigned char* data = nullptr;
+		int width = 0;
+		int height = 0;
+		int nrChannels = 0;
+	};
+
+	// One thread per face; stb_image keeps no shared state while decoding
+	vector<Face_Image> images(faces.size());
+	parallelFor((int)faces.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			images[i].data = stbi_load(faces[i].c_str(), &images[i].width, &images[i].height, &images[i].nrChannels, 0);
+		}
+	}, (unsigned int)faces.size());
+
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	for (unsigned int i = 0; i < faces.size(); i++) {
+		if (images[i].data) {
+			GLenum format = GL_RGB;
+			if (images[i].nrChannels == 1) {
+				format = GL_RED;
+			} else if (images[i].nrChannels == 4) {
+				format = GL_RGBA;
+			}
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, format, images[i].width, images[i].height, 0, format, GL_UNSIGNED_BYTE, images[i].data);
+		} else {
+			cout << "Cubemap texture failed to load at path: " << faces[i] << endl;
+		}
+		stbi_image_free(images[i].data);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	return textureID;
+}
+
+// Bilinear lookup in the panorama; longitude wraps around, latitude stops at the poles
+static void samplePanorama(const float* rgb, int width, int height, float u, float v, float* out) {
+	float x = u * width - 0.5f;
+	float y = v * height - 0.5f;
+	int x0 = (int)floor(x);
+	int y0 = (int)floor(y);
+	float fx = x - x0;
+	float fy = y - y0;
+
+	int x1 = ((x0 + 1) % width + width) % width;
+	x0 = (x0 % width + width) % width;
+	int y1 = min(y0 + 1, height - 1);
+	y0 = clamp(y0, 0, height - 1);
+
+	const float* p00 = rgb + ((size_t)y0 * width + x0) * 3;
+	const float* p10 = rgb + ((size_t)y0 * width + x1) * 3;
+	const float* p01 = rgb + ((size_t)y1 * width + x0) * 3;
+	const float* p11 = rgb + ((size_t)y1 * width + x1) * 3;
+
+#ifdef CUBEMAP_LOADER_SSE2
+	__m128 a = _mm_set_ps(0.0f, p00[2], p00[1], p00[0]);
+	__m128 b = _mm_set_ps(0.0f, p10[2], p10[1], p10[0]);
+	__m128 c = _mm_set_ps(0.0f, p01[2], p01[1], p01[0]);
+	__m128 d = _mm_set_ps(0.0f, p11[2], p11[1], p11[0]);
+	__m128 wx = _mm_set1_ps(fx);
+	__m128 top = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), wx));
+	__m128 bottom = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(d, c), wx));
+	__m128 result = _mm_add_ps(top, _mm_mul_ps(_mm_sub_ps(bottom, top), _mm_set1_ps(fy)));
+	float values[4];
+	_mm_storeu_ps(values, result);
+	out[0] = values[0];
+	out[1] = values[1];
+	out[2] = values[2];
+#else
+	for (int channel = 0; channel < 3; channel++) {
+		float top = p00[channel] + (p10[channel] - p00[channel]) * fx;
+		float bottom = p01[channel] + (p11[channel] - p01[channel]) * fx;
+		out[channel] = top + (bottom - top) * fy;
+	}
+#endif
+}
+
+#ifdef CUBEMAP_LOADER_SSE2
+static inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// atan2 of four values at once. The angle is folded into [0, 1] where a minimax polynomial is
+// accurate to about 1e-5 radians, far below a texel of any practical panorama
+static __m128 atan2SSE(__m128 y, __m128 x) {
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	__m128 absX = _mm_andnot_ps(signMask, x);
+	__m128 absY = _mm_andnot_ps(signMask, y);
+	__m128 a = _mm_div_ps(_mm_min_ps(absX, absY), _mm_max_ps(_mm_max_ps(absX, absY), _mm_set1_ps(1e-30f)));
+	__m128 s = _mm_mul_ps(a, a);
+
+	__m128 poly = _mm_set1_ps(-0.01172120f);
+	poly = _mm_add_ps(_mm_mul_ps(poly, s), _mm_set1_ps(0.05265332f));
+	poly = _mm_add_ps(_mm_mul_ps(poly, s), _mm_set1_ps(-0.11643287f));
+	poly = _mm_add_ps(_mm_mul_ps(poly, s), _mm_set1_ps(0.19354346f));
+	poly = _mm_add_ps(_mm_mul_ps(poly, s), _mm_set1_ps(-0.33262347f));
+	poly = _mm_add_ps(_mm_mul_ps(poly, s), _mm_set1_ps(0.99997726f));
+	__m128 angle = _mm_mul_ps(a, poly);
+
+	angle = select(_mm_cmpgt_ps(absY, absX), _mm_sub_ps(_mm_set1_ps(PI * 0.5f), angle), angle);
+	angle = select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), angle), angle);
+	return _mm_or_ps(angle, _mm_and_ps(y, signMask));
+}
+#endif
+
+vector<float> equirectangularToCubemap(const float* rgb, int width, int height, int faceSize, unsigned int threadCount) {
+	vector<float> faces((size_t)6 * faceSize * faceSize * 3);
+
+	parallelFor(6 * faceSize, [&](int begin, int end) {
+		for (int row = begin; row < end; row++) {
+			const Face_Axes& axes = faceAxes[row / faceSize];
+			float t = 2.0f * (row % faceSize + 0.5f) / faceSize - 1.0f;
+			float* out = &faces[(size_t)row * faceSize * 3];
+			int x = 0;
+
+#ifdef CUBEMAP_LOADER_SSE2
+			// Four texels at a time: direction, then longitude and latitude of the direction
+			const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 texelScale = _mm_set1_ps(2.0f / faceSize);
+			__m128 baseX = _mm_set1_ps(axes.major[0] + t * axes.tAxis[0]);
+			__m128 baseY = _mm_set1_ps(axes.major[1] + t * axes.tAxis[1]);
+			__m128 baseZ = _mm_set1_ps(axes.major[2] + t * axes.tAxis[2]);
+			for (; x + 4 <= faceSize; x += 4) {
+				__m128 s = _mm_sub_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)x), offsets), texelScale), _mm_set1_ps(1.0f));
+				__m128 dx = _mm_add_ps(baseX, _mm_mul_ps(s, _mm_set1_ps(axes.sAxis[0])));
+				__m128 dy = _mm_add_ps(baseY, _mm_mul_ps(s, _mm_set1_ps(axes.sAxis[1])));
+				__m128 dz = _mm_add_ps(baseZ, _mm_mul_ps(s, _mm_set1_ps(axes.sAxis[2])));
+
+				// acos(y) written as atan2(sqrt(x^2 + z^2), y) stays accurate near the poles
+				__m128 horizontal = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dz, dz)));
+				__m128 u = _mm_add_ps(_mm_mul_ps(atan2SSE(dz, dx), _mm_set1_ps(0.5f / PI)), _mm_set1_ps(0.5f));
+				__m128 v = _mm_mul_ps(atan2SSE(horizontal, dy), _mm_set1_ps(1.0f / PI));
+
+				float us[4], vs[4];
+				_mm_storeu_ps(us, u);
+				_mm_storeu_ps(vs, v);
+				for (int k = 0; k < 4; k++) {
+					samplePanorama(rgb, width, height, us[k], vs[k], out + (x + k) * 3);
+				}
+			}
+#endif
+
+			for (; x < faceSize; x++) {
+				float s = 2.0f * (x + 0.5f) / faceSize - 1.0f;
+				float dx = axes.major[0] + s * axes.sAxis[0] + t * axes.tAxis[0];
+				float dy = axes.major[1] + s * axes.sAxis[1] + t * axes.tAxis[1];
+				float dz = axes.major[2] + s * axes.sAxis[2] + t * axes.tAxis[2];
+				float u = atan2(dz, dx) * (0.5f / PI) + 0.5f;
+				float v = atan2(sqrt(dx * dx + dz * dz), dy) / PI;
+				samplePanorama(rgb, width, height, u, v, out + x * 3);
+			}
+		}
+	}, threadCount);
+
+	return faces;
+}
+
+// Rounds to the nearest half float; values past the half range are clamped to its largest value
+static unsigned short floatToHalf(float value) {
+	value = clamp(value, -65504.0f, 65504.0f);
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	int exponent = (int)((bits >> 23) & 0xFF) - 127 + 15;
+	unsigned int mantissa = bits & 0x7FFFFF;
+
+	if (exponent <= 0) { // Subnormal half, or zero
+		if (exponent < -10) {
+			return (unsigned short)sign;
+		}
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1))) {
+			half++;
+		}
+		return (unsigned short)(sign | half);
+	}
+
+	unsigned int half = sign | ((unsigned int)exponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1))) {
+		half++; // A carry out of the mantissa correctly bumps the exponent
+	}
+	return (unsigned short)half;
+}
+
+unsigned int loadEquirectangularCubemap(const string& path, int faceSize) {
+	// The face size is part of the cache name, so the panorama's header is read to pick a default
+	if (faceSize <= 0) {
+		int width, height, nrComponents;
+		if (!stbi_info(path.c_str(), &width, &height, &nrComponents)) {
+			cout << "Panorama failed to load at path: " << path << endl;
+			return 0;
+		}
+		faceSize = max(1, width / 4);
+	}
+
+	string cachePath = path + ".cube" + to_string(faceSize) + ".ktx";
+	KtxTexture cube;
+	bool cached = cacheFileIsCurrent(cachePath, path) && readKtx(cachePath, cube)
+		&& cube.faces == 6 && cube.width == faceSize && cube.glInternalFormat == KTX_RGB16F && cube.levelCount() > 0;
+
+	if (!cached) {
+		int width, height, nrComponents;
+		float* data = stbi_loadf(path.c_str(), &width, &height, &nrComponents, 3);
+		if (!data) {
+			cout << "Panorama failed to load at path: " << path << endl;
+			return 0;
+		}
+
+		auto start = chrono::high_resolution_clock::now();
+		vector<float> faces = equirectangularToCubemap(data, width, height, faceSize);
+		stbi_image_free(data);
+
+		// Half floats keep the HDR range at half the memory of the float faces
+		vector<unsigned char> halves(faces.size() * sizeof(unsigned short));
+		unsigned short* halfData = (unsigned short*)halves.data();
+		parallelFor(6 * faceSize, [&](int begin, int end) {
+			for (size_t i = (size_t)begin * faceSize * 3; i < (size_t)end * faceSize * 3; i++) {
+				halfData[i] = floatToHalf(faces[i]);
+			}
+		});
+		auto end = chrono::high_resolution_clock::now();
+		cout << "Converted panorama to " << faceSize << "x" << faceSize << " cubemap in "
+			<< chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+
+		cube = KtxTexture();
+		cube.glType = KTX_HALF_FLOAT;
+		cube.glTypeSize = 2;
+		cube.glFormat = KTX_RGB;
+		cube.glInternalFormat = KTX_RGB16F;
+		cube.glBaseInternalFormat = KTX_RGB;
+		cube.width = faceSize;
+		cube.height = faceSize;
+		cube.faces = 6;
+		cube.levels.push_back(move(halves));
+		if (!writeKtx(cachePath, cube)) {
+			cout << "Cubemap cache failed to write at path: " << cachePath << endl;
+		}
+	}
+
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t faceBytes = cube.levels[0].size() / 6;
+	for (unsigned int i = 0; i < 6; i++) {
+		glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, faceSize, faceSize, 0, GL_RGB, GL_HALF_FLOAT, cube.levels[0].data() + i * faceBytes);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+
+	return textureID;
+}
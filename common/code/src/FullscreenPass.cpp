@@ -0,0 +1,67 @@
+#include <glad/glad.h>
+
+#include "../header/FullscreenPass.h"
+
+#include <iostream>
+
+using namespace std;
+
+const char* FULLSCREEN_VERTEX_SHADER =
+	"#version 330 core\n"
+	"out vec2 TexCoords;\n"
+	"void main() {\n"
+	"    vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+	"    TexCoords = position;\n"
+	"    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+	"}\n";
+
+namespace {
+
+	unsigned int compileStage(GLenum type, const string& source, const string& name) {
+		unsigned int shader = glCreateShader(type);
+		const char* code = source.c_str();
+		glShaderSource(shader, 1, &code, NULL);
+		glCompileShader(shader);
+
+		int success;
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			char infoLog[1024];
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			cout << "ERROR::" << name << "::SHADER_COMPILATION_FAILED\n" << infoLog << endl;
+		}
+		return shader;
+	}
+}
+
+unsigned int compileProgram(const string& vertexSource, const string& fragmentSource, const string& name) {
+	unsigned int vertex = compileStage(GL_VERTEX_SHADER, vertexSource, name);
+	unsigned int fragment = compileStage(GL_FRAGMENT_SHADER, fragmentSource, name);
+
+	unsigned int program = glCreateProgram();
+	glAttachShader(program, vertex);
+	glAttachShader(program, fragment);
+	glLinkProgram(program);
+
+	int success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success) {
+		char infoLog[1024];
+		glGetProgramInfoLog(program, 1024, NULL, infoLog);
+		cout << "ERROR::" << name << "::PROGRAM_LINKING_FAILED\n" << infoLog << endl;
+	}
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	return program;
+}
+
+void drawFullscreenTriangle() {
+	// Core profile still needs a vertex array bound to draw, even an empty one
+	static unsigned int vao = 0;
+	if (vao == 0) {
+		glGenVertexArrays(1, &vao);
+	}
+	glBindVertexArray(vao);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glBindVertexArray(0);
+}
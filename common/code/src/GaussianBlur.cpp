@@ -0,0 +1,243 @@
+#include "../header/GaussianBlur.h"
+#include "../header/TextureLoader.h"
+#include "../header/FullscreenPass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+namespace {
+
+	// One program per tap count, shared by every blur
+	map<unsigned int, unsigned int> blurPrograms;
+
+	unsigned int blurProgram(unsigned int tapCount) {
+		auto found = blurPrograms.find(tapCount);
+		if (found != blurPrograms.end()) {
+			return found->second;
+		}
+
+		unsigned int program = compileProgram(FULLSCREEN_VERTEX_SHADER, blurShaderSource(tapCount), "BLUR");
+		glUseProgram(program);
+		glUniform1i(glGetUniformLocation(program, "image"), 0);
+
+		blurPrograms[tapCount] = program;
+		return program;
+	}
+
+	// Averages a downscale x downscale block of source texels into each target texel. Each tap
+	// sits on the corner of four source texels, so the bilinear filter averages them; for an even
+	// downscale the taps tile the block exactly and every source texel counts once
+	const char* DOWNSAMPLE_FRAGMENT_SHADER =
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"in vec2 TexCoords;\n"
+		"uniform sampler2D image;\n"
+		"uniform vec2 sourceTexel; // One source texel, in texture coordinates\n"
+		"uniform int taps;         // Taps along each axis, downscale / 2\n"
+		"void main() {\n"
+		"    vec4 result = vec4(0.0);\n"
+		"    for (int y = 0; y < taps; y++) {\n"
+		"        for (int x = 0; x < taps; x++) {\n"
+		"            vec2 offset = vec2(x, y) * 2.0 - float(taps - 1);\n"
+		"            result += texture(image, TexCoords + offset * sourceTexel);\n"
+		"        }\n"
+		"    }\n"
+		"    FragColor = result / float(taps * taps);\n"
+		"}\n";
+
+	unsigned int downsampleProgram() {
+		static unsigned int program = 0;
+		if (program == 0) {
+			program = compileProgram(FULLSCREEN_VERTEX_SHADER, DOWNSAMPLE_FRAGMENT_SHADER, "BLUR_DOWNSAMPLE");
+			glUseProgram(program);
+			glUniform1i(glGetUniformLocation(program, "image"), 0);
+		}
+		return program;
+	}
+}
+
+Blur_Kernel gaussianKernel(float sigma, int radius) {
+	sigma = max(sigma, 0.1f);
+	if (radius <= 0) {
+		radius = max(1, (int)ceil(3.0f * sigma));
+	}
+
+	// Discrete weights of one side, normalized over both sides
+	vector<float> discrete(radius + 1);
+	float sum = 0.0f;
+	for (int i = 0; i <= radius; i++) {
+		discrete[i] = exp(-(float)(i * i) / (2.0f * sigma * sigma));
+		sum += i == 0 ? discrete[i] : 2.0f * discrete[i];
+	}
+	for (float& weight : discrete) {
+		weight /= sum;
+	}
+
+	// Sampling between texels i and i + 1 at the point that splits them in the ratio of their
+	// weights makes the bilinear filter return exactly w(i) * t(i) + w(i + 1) * t(i + 1)
+	Blur_Kernel kernel;
+	kernel.offsets.push_back(0.0f);
+	kernel.weights.push_back(discrete[0]);
+	for (int i = 1; i <= radius; i += 2) {
+		float first = discrete[i];
+		float second = i + 1 <= radius ? discrete[i + 1] : 0.0f;
+		float weight = first + second;
+
+		kernel.offsets.push_back((i * first + (i + 1) * second) / weight);
+		kernel.weights.push_back(weight);
+	}
+	return kernel;
+}
+
+string blurShaderSource(unsigned int tapCount) {
+	string taps = to_string(max(1u, tapCount));
+	return
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"in vec2 TexCoords;\n"
+		"uniform sampler2D image;\n"
+		"uniform vec2 direction; // One target texel along the blur axis, in texture coordinates\n"
+		"uniform float offsets[" + taps + "];\n"
+		"uniform float weights[" + taps + "];\n"
+		"void main() {\n"
+		"    vec4 result = texture(image, TexCoords) * weights[0];\n"
+		"    for (int i = 1; i < " + taps + "; i++) {\n"
+		"        result += texture(image, TexCoords + direction * offsets[i]) * weights[i];\n"
+		"        result += texture(image, TexCoords - direction * offsets[i]) * weights[i];\n"
+		"    }\n"
+		"    FragColor = result;\n"
+		"}\n";
+}
+
+GaussianBlur::GaussianBlur(unsigned int width, unsigned int height, float sigma, unsigned int downscale, GLenum internalFormat)
+	: width(width), height(height), internalFormat(internalFormat), sigma(sigma), downscale(max(1u, downscale)), program(0) {
+	glGenFramebuffers(2, framebuffers);
+	createTargets();
+	updateKernel();
+}
+
+GaussianBlur::~GaussianBlur() {
+	deleteTargets();
+	glDeleteFramebuffers(2, framebuffers);
+}
+
+unsigned int GaussianBlur::apply(unsigned int source, unsigned int passes) {
+	GLint previousFramebuffer;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	unsigned int targetWidth = max(1u, width / downscale);
+	unsigned int targetHeight = max(1u, height / downscale);
+	glViewport(0, 0, targetWidth, targetHeight);
+
+	// The kernel is built for target texels, so a smaller target is filled with the box filtered
+	// source first. Blurring straight from the source would step over source texels
+	unsigned int input = source;
+	if (downscale > 1) {
+		unsigned int downsample = downsampleProgram();
+		glUseProgram(downsample);
+		glUniform2f(glGetUniformLocation(downsample, "sourceTexel"), 1.0f / width, 1.0f / height);
+		glUniform1i(glGetUniformLocation(downsample, "taps"), max(1, (int)downscale / 2));
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[1]);
+		bindTexture(0, source);
+		drawFullscreenTriangle();
+		input = textures[1];
+	}
+
+	glUseProgram(program);
+	glUniform1fv(glGetUniformLocation(program, "offsets"), (GLsizei)kernel.offsets.size(), kernel.offsets.data());
+	glUniform1fv(glGetUniformLocation(program, "weights"), (GLsizei)kernel.weights.size(), kernel.weights.data());
+	int directionLocation = glGetUniformLocation(program, "direction");
+
+	for (unsigned int i = 0; i < max(1u, passes); i++) {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+		bindTexture(0, i == 0 ? input : textures[1]);
+		glUniform2f(directionLocation, 1.0f / targetWidth, 0.0f);
+		drawFullscreenTriangle();
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[1]);
+		bindTexture(0, textures[0]);
+		glUniform2f(directionLocation, 0.0f, 1.0f / targetHeight);
+		drawFullscreenTriangle();
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (blend) {
+		glEnable(GL_BLEND);
+	}
+	return textures[1];
+}
+
+void GaussianBlur::setSigma(float sigma) {
+	if (sigma != this->sigma) {
+		this->sigma = sigma;
+		updateKernel();
+	}
+}
+
+void GaussianBlur::setDownscale(unsigned int downscale) {
+	downscale = max(1u, downscale);
+	if (downscale != this->downscale) {
+		this->downscale = downscale;
+		deleteTargets();
+		createTargets();
+		updateKernel();
+	}
+}
+
+float GaussianBlur::getSigma() const {
+	return sigma;
+}
+
+unsigned int GaussianBlur::getDownscale() const {
+	return downscale;
+}
+
+unsigned int GaussianBlur::fetchesPerPass() const {
+	return 2 * (unsigned int)kernel.offsets.size() - 1;
+}
+
+void GaussianBlur::createTargets() {
+	unsigned int targetWidth = max(1u, width / downscale);
+	unsigned int targetHeight = max(1u, height / downscale);
+
+	glGenTextures(2, textures);
+	for (unsigned int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, targetWidth, targetHeight, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "ERROR::BLUR::FRAMEBUFFER_NOT_COMPLETE" << endl;
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void GaussianBlur::deleteTargets() {
+	glDeleteTextures(2, textures);
+}
+
+void GaussianBlur::updateKernel() {
+	// The target texels are downscale times larger, so the same blur needs a smaller sigma
+	kernel = gaussianKernel(sigma / downscale);
+	program = blurProgram((unsigned int)kernel.offsets.size());
+}
@@ -0,0 +1,65 @@
+#include <glad/glad.h>
+
+#include "../header/GpuTimer.h"
+
+#include <algorithm>
+
+using namespace std;
+
+GpuTimer::GpuTimer(unsigned int latency)
+	: next(0), last(0.0f), average(0.0f), hasAverage(false) {
+	queries.resize(max(1u, latency));
+	pending.resize(queries.size(), false);
+	glGenQueries((GLsizei)queries.size(), queries.data());
+}
+
+GpuTimer::~GpuTimer() {
+	glDeleteQueries((GLsizei)queries.size(), queries.data());
+}
+
+void GpuTimer::begin() {
+	// The slot's previous result has had `latency` frames to arrive; wait if it still hasn't
+	if (pending[next]) {
+		collect(next, true);
+	}
+	glBeginQuery(GL_TIME_ELAPSED, queries[next]);
+}
+
+void GpuTimer::end() {
+	glEndQuery(GL_TIME_ELAPSED);
+	pending[next] = true;
+	next = (next + 1) % queries.size();
+
+	// Pick up every result that is ready without waiting
+	for (unsigned int i = 0; i < queries.size(); i++) {
+		if (pending[i]) {
+			collect(i, false);
+		}
+	}
+}
+
+float GpuTimer::milliseconds() const {
+	return last;
+}
+
+float GpuTimer::averageMilliseconds() const {
+	return average;
+}
+
+void GpuTimer::collect(unsigned int slot, bool wait) {
+	if (!wait) {
+		GLint available = 0;
+		glGetQueryObjectiv(queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			return;
+		}
+	}
+
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	pending[slot] = false;
+
+	last = nanoseconds / 1000000.0f;
+	average = hasAverage ? average + (last - average) / 30.0f : last;
+	hasAverage = true;
+}
@@ -1,2 +1,2 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
\ No newline at end of file
+#define STB_IMAGE_IMPLEMENTATION
+#include "../header/stb_image.h"
@@ -0,0 +1,218 @@
+#include "../header/JumpFloodOutline.h"
+#include "../header/TextureLoader.h"
+#include "../header/FullscreenPass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+	// Seeds are stored as whole texel coordinates of the flood target, which half floats hold
+	// exactly up to 2048. A texel without a seed holds -1
+	const char* SEED_SHADER =
+		"#version 330 core\n"
+		"out vec2 FragColor;\n"
+		"uniform sampler2D mask;\n"
+		"uniform int downscale;\n"
+		"void main() {\n"
+		"    // A flood texel is a seed if any mask texel it covers is marked, so thin parts survive the downscale\n"
+		"    ivec2 texel = ivec2(gl_FragCoord.xy);\n"
+		"    ivec2 last = textureSize(mask, 0) - 1;\n"
+		"    for (int y = 0; y < downscale; y++) {\n"
+		"        for (int x = 0; x < downscale; x++) {\n"
+		"            if (texelFetch(mask, min(texel * downscale + ivec2(x, y), last), 0).r > 0.0) {\n"
+		"                FragColor = vec2(texel);\n"
+		"                return;\n"
+		"            }\n"
+		"        }\n"
+		"    }\n"
+		"    FragColor = vec2(-1.0);\n"
+		"}\n";
+
+	const char* FLOOD_SHADER =
+		"#version 330 core\n"
+		"out vec2 FragColor;\n"
+		"uniform sampler2D seeds;\n"
+		"uniform int step;\n"
+		"void main() {\n"
+		"    ivec2 texel = ivec2(gl_FragCoord.xy);\n"
+		"    ivec2 size = textureSize(seeds, 0);\n"
+		"    vec2 nearest = vec2(-1.0);\n"
+		"    float nearestDistance = 1e20;\n"
+		"    for (int y = -1; y <= 1; y++) {\n"
+		"        for (int x = -1; x <= 1; x++) {\n"
+		"            ivec2 neighbor = texel + ivec2(x, y) * step;\n"
+		"            if (any(lessThan(neighbor, ivec2(0))) || any(greaterThanEqual(neighbor, size)))\n"
+		"                continue;\n"
+		"            vec2 seed = texelFetch(seeds, neighbor, 0).xy;\n"
+		"            vec2 offset = seed - vec2(texel);\n"
+		"            float distance = dot(offset, offset);\n"
+		"            if (seed.x >= 0.0 && distance < nearestDistance) {\n"
+		"                nearest = seed;\n"
+		"                nearestDistance = distance;\n"
+		"            }\n"
+		"        }\n"
+		"    }\n"
+		"    FragColor = nearest;\n"
+		"}\n";
+
+	const char* COMPOSITE_SHADER =
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"uniform sampler2D mask;\n"
+		"uniform sampler2D seeds;\n"
+		"uniform int downscale;\n"
+		"uniform float thickness;\n"
+		"uniform vec3 color;\n"
+		"void main() {\n"
+		"    ivec2 pixel = ivec2(gl_FragCoord.xy);\n"
+		"    if (texelFetch(mask, pixel, 0).r > 0.0)\n"
+		"        discard;\n"
+		"    vec2 seed = texelFetch(seeds, min(pixel / downscale, textureSize(seeds, 0) - 1), 0).xy;\n"
+		"    if (seed.x < 0.0)\n"
+		"        discard;\n"
+		"    // From the pixel to the edge of the block of mask pixels the seed stands for, with a one\n"
+		"    // pixel falloff to smooth the outer edge\n"
+		"    float distance = max(length(gl_FragCoord.xy - (seed + 0.5) * float(downscale)) - 0.5 * float(downscale), 0.0);\n"
+		"    float coverage = clamp(thickness - distance + 0.5, 0.0, 1.0);\n"
+		"    if (coverage <= 0.0)\n"
+		"        discard;\n"
+		"    FragColor = vec4(color, coverage);\n"
+		"}\n";
+}
+
+JumpFloodOutline::JumpFloodOutline(unsigned int width, unsigned int height, float thickness, unsigned int downscale)
+	: width(width), height(height), downscale(max(1u, downscale)), thickness(thickness) {
+	seedProgram = compileProgram(FULLSCREEN_VERTEX_SHADER, SEED_SHADER, "OUTLINE_SEED");
+	glUseProgram(seedProgram);
+	glUniform1i(glGetUniformLocation(seedProgram, "mask"), 0);
+	glUniform1i(glGetUniformLocation(seedProgram, "downscale"), (int)this->downscale);
+
+	floodProgram = compileProgram(FULLSCREEN_VERTEX_SHADER, FLOOD_SHADER, "OUTLINE_FLOOD");
+	glUseProgram(floodProgram);
+	glUniform1i(glGetUniformLocation(floodProgram, "seeds"), 0);
+
+	compositeProgram = compileProgram(FULLSCREEN_VERTEX_SHADER, COMPOSITE_SHADER, "OUTLINE_COMPOSITE");
+	glUseProgram(compositeProgram);
+	glUniform1i(glGetUniformLocation(compositeProgram, "mask"), 0);
+	glUniform1i(glGetUniformLocation(compositeProgram, "seeds"), 1);
+	glUniform1i(glGetUniformLocation(compositeProgram, "downscale"), (int)this->downscale);
+
+	// Rounded up so the flood covers every mask texel
+	unsigned int targetWidth = max(1u, (width + this->downscale - 1) / this->downscale);
+	unsigned int targetHeight = max(1u, (height + this->downscale - 1) / this->downscale);
+
+	glGenFramebuffers(2, framebuffers);
+	glGenTextures(2, textures);
+	for (unsigned int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, targetWidth, targetHeight, 0, GL_RG, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "ERROR::OUTLINE::FRAMEBUFFER_NOT_COMPLETE" << endl;
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	updateSteps();
+}
+
+JumpFloodOutline::~JumpFloodOutline() {
+	glDeleteProgram(seedProgram);
+	glDeleteProgram(floodProgram);
+	glDeleteProgram(compositeProgram);
+	glDeleteTextures(2, textures);
+	glDeleteFramebuffers(2, framebuffers);
+}
+
+void JumpFloodOutline::draw(unsigned int mask, const vec3& color) {
+	GLint previousFramebuffer;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	unsigned int targetWidth = max(1u, (width + downscale - 1) / downscale);
+	unsigned int targetHeight = max(1u, (height + downscale - 1) / downscale);
+	glViewport(0, 0, targetWidth, targetHeight);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[0]);
+	glUseProgram(seedProgram);
+	bindTexture(0, mask);
+	drawFullscreenTriangle();
+
+	// Each step reads the target the last one wrote
+	glUseProgram(floodProgram);
+	int stepLocation = glGetUniformLocation(floodProgram, "step");
+	unsigned int current = 0;
+	for (int step : steps) {
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[1 - current]);
+		bindTexture(0, textures[current]);
+		glUniform1i(stepLocation, step);
+		drawFullscreenTriangle();
+		current = 1 - current;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(0, 0, width, height);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glUseProgram(compositeProgram);
+	glUniform1f(glGetUniformLocation(compositeProgram, "thickness"), thickness);
+	glUniform3f(glGetUniformLocation(compositeProgram, "color"), color.x, color.y, color.z);
+	bindTexture(0, mask);
+	bindTexture(1, textures[current]);
+	drawFullscreenTriangle();
+
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (!blend) {
+		glDisable(GL_BLEND);
+	}
+}
+
+void JumpFloodOutline::setThickness(float thickness) {
+	if (thickness != this->thickness) {
+		this->thickness = thickness;
+		updateSteps();
+	}
+}
+
+float JumpFloodOutline::getThickness() const {
+	return thickness;
+}
+
+unsigned int JumpFloodOutline::passCount() const {
+	return (unsigned int)steps.size() + 2;
+}
+
+void JumpFloodOutline::updateSteps() {
+	// Only seeds within thickness matter, so the flood starts at the smallest power of two whose
+	// steps add up to that far, instead of half the screen. It ends with an extra step of 1, which
+	// fixes most of the texels the plain flood gets wrong
+	int reach = max(1, (int)ceil(thickness / downscale) + 1);
+	int step = 1;
+	while (step * 2 - 1 < reach) {
+		step *= 2;
+	}
+
+	steps.clear();
+	for (; step >= 1; step /= 2) {
+		steps.push_back(step);
+	}
+	steps.push_back(1);
+}
@@ -0,0 +1,158 @@
+#include "../header/KtxFile.h"
+
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+
+// Every KTX 1.1 file starts with this identifier
+static const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+static const unsigned int KTX_ENDIANNESS = 0x04030201;
+
+// Header that follows the identifier, thirteen 32-bit fields in file order
+struct KtxHeader {
+	unsigned int endianness;
+	unsigned int glType;
+	unsigned int glTypeSize;
+	unsigned int glFormat;
+	unsigned int glInternalFormat;
+	unsigned int glBaseInternalFormat;
+	unsigned int pixelWidth;
+	unsigned int pixelHeight;
+	unsigned int pixelDepth;
+	unsigned int numberOfArrayElements;
+	unsigned int numberOfFaces;
+	unsigned int numberOfMipmapLevels;
+	unsigned int bytesOfKeyValueData;
+};
+
+// Image data is padded so each face and level starts on a 4 byte boundary
+static unsigned int paddingFor(size_t size) {
+	return (unsigned int)((4 - size % 4) % 4);
+}
+
+bool writeKtx(const string& path, const KtxTexture& texture) {
+	ofstream file(path, ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	KtxHeader header;
+	header.endianness = KTX_ENDIANNESS;
+	header.glType = texture.glType;
+	header.glTypeSize = texture.glTypeSize;
+	header.glFormat = texture.glFormat;
+	header.glInternalFormat = texture.glInternalFormat;
+	header.glBaseInternalFormat = texture.glBaseInternalFormat;
+	header.pixelWidth = texture.width;
+	header.pixelHeight = texture.height;
+	header.pixelDepth = 0;
+	header.numberOfArrayElements = 0;
+	header.numberOfFaces = texture.faces;
+	header.numberOfMipmapLevels = texture.levelCount();
+	header.bytesOfKeyValueData = 0;
+
+	file.write((const char*)KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+	file.write((const char*)&header, sizeof(header));
+
+	const char zeros[4] = { 0, 0, 0, 0 };
+	for (unsigned int level = 0; level < texture.levelCount(); level++) {
+		// imageSize is the size of a single face; for cubemaps each face is padded separately
+		const vector<unsigned char>& data = texture.levels[level];
+		unsigned int faceSize = (unsigned int)(data.size() / texture.faces);
+		file.write((const char*)&faceSize, sizeof(faceSize));
+
+		for (unsigned int face = 0; face < texture.faces; face++) {
+			file.write((const char*)data.data() + face * faceSize, faceSize);
+			file.write(zeros, paddingFor(faceSize));
+		}
+	}
+
+	return (bool)file;
+}
+
+// Reads and checks the identifier and header, leaving the file at the first level
+static bool readHeader(ifstream& file, KtxTexture& texture) {
+	unsigned char identifier[12];
+	KtxHeader header;
+	file.read((char*)identifier, sizeof(identifier));
+	file.read((char*)&header, sizeof(header));
+	if (!file || memcmp(identifier, KTX_IDENTIFIER, sizeof(identifier)) != 0 || header.endianness != KTX_ENDIANNESS) {
+		return false;
+	}
+
+	texture.glType = header.glType;
+	texture.glTypeSize = header.glTypeSize;
+	texture.glFormat = header.glFormat;
+	texture.glInternalFormat = header.glInternalFormat;
+	texture.glBaseInternalFormat = header.glBaseInternalFormat;
+	texture.width = header.pixelWidth;
+	texture.height = header.pixelHeight;
+	texture.faces = header.numberOfFaces;
+	texture.levels.assign(header.numberOfMipmapLevels > 0 ? header.numberOfMipmapLevels : 1, vector<unsigned char>());
+
+	// We don't write any key/value data, but skip it in files that came from other tools
+	file.seekg(header.bytesOfKeyValueData, ios::cur);
+	return (bool)file;
+}
+
+bool readKtx(const string& path, KtxTexture& texture) {
+	ifstream file(path, ios::binary);
+	if (!file || !readHeader(file, texture)) {
+		return false;
+	}
+
+	for (unsigned int level = 0; level < texture.levelCount(); level++) {
+		unsigned int faceSize = 0;
+		file.read((char*)&faceSize, sizeof(faceSize));
+
+		vector<unsigned char>& data = texture.levels[level];
+		data.resize((size_t)faceSize * texture.faces);
+		for (unsigned int face = 0; face < texture.faces; face++) {
+			file.read((char*)data.data() + face * faceSize, faceSize);
+			file.seekg(paddingFor(faceSize), ios::cur);
+		}
+	}
+
+	return (bool)file;
+}
+
+bool readKtxIndex(const string& path, KtxTexture& texture, vector<size_t>& levelOffsets, vector<size_t>& levelSizes) {
+	ifstream file(path, ios::binary);
+	if (!file || !readHeader(file, texture)) {
+		return false;
+	}
+
+	levelOffsets.clear();
+	levelSizes.clear();
+	for (unsigned int level = 0; level < texture.levelCount(); level++) {
+		unsigned int faceSize = 0;
+		file.read((char*)&faceSize, sizeof(faceSize));
+		if (!file) {
+			return false;
+		}
+
+		levelOffsets.push_back((size_t)file.tellg());
+		levelSizes.push_back((size_t)faceSize * texture.faces);
+		file.seekg((streamoff)(faceSize + paddingFor(faceSize)) * texture.faces, ios::cur);
+	}
+
+	return true;
+}
+
+bool readKtxLevel(const string& path, size_t offset, size_t size, unsigned int faces, vector<unsigned char>& data) {
+	ifstream file(path, ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	size_t faceSize = size / faces;
+	data.resize(size);
+	file.seekg((streamoff)offset);
+	for (unsigned int face = 0; face < faces; face++) {
+		file.read((char*)data.data() + face * faceSize, faceSize);
+		file.seekg(paddingFor(faceSize), ios::cur);
+	}
+
+	return (bool)file;
+}
@@ -0,0 +1,264 @@
+#include "../header/MipGenerator.h"
+#include "../header/ParallelFor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIP_GENERATOR_SSE2
+#endif
+
+using namespace std;
+
+// Linear RGBA image in full float precision, the space all filtering happens in
+struct FloatImage {
+	int width = 0;
+	int height = 0;
+	vector<float> pixels;
+};
+
+// A resampling filter for one axis: every output pixel reads tapCount source pixels
+struct Filter1D {
+	int tapCount = 0;
+	vector<int> indices;
+	vector<float> weights;
+};
+
+static const double PI = 3.14159265358979323846;
+
+// The conversion tables are built on first use; static locals are thread safe to initialize
+static float srgbToLinear(unsigned char value) {
+	static const vector<float> table = []() {
+		vector<float> values(256);
+		for (int i = 0; i < 256; i++) {
+			double c = i / 255.0;
+			values[i] = (float)(c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4));
+		}
+		return values;
+	}();
+	return table[value];
+}
+
+static unsigned char linearToSrgb(float value) {
+	// 4096 entries keep the rounding error below one step of the 8-bit output
+	static const vector<unsigned char> table = []() {
+		vector<unsigned char> values(4096);
+		for (int i = 0; i < 4096; i++) {
+			double c = i / 4095.0;
+			double s = c <= 0.0031308 ? c * 12.92 : 1.055 * pow(c, 1.0 / 2.4) - 0.055;
+			values[i] = (unsigned char)(s * 255.0 + 0.5);
+		}
+		return values;
+	}();
+	return table[(int)(clamp(value, 0.0f, 1.0f) * 4095.0f + 0.5f)];
+}
+
+// Zeroth order modified Bessel function of the first kind, used by the Kaiser window
+static double besselI0(double x) {
+	double sum = 1.0, term = 1.0;
+	for (int k = 1; k < 32; k++) {
+		term *= (x / (2.0 * k)) * (x / (2.0 * k));
+		sum += term;
+		if (term < sum * 1e-12) {
+			break;
+		}
+	}
+	return sum;
+}
+
+static double filterWeight(Mip_Filter filter, double distance, double scale) {
+	if (filter == MIP_FILTER_BOX) {
+		return fabs(distance) <= scale * 0.5 ? 1.0 : 0.0;
+	}
+
+	// Sinc low-pass at the destination's Nyquist rate, windowed over 3 destination pixels
+	const double alpha = 4.0;
+	double radius = 1.5 * scale;
+	double x = distance / radius;
+	if (fabs(x) >= 1.0) {
+		return 0.0;
+	}
+
+	double t = distance / scale;
+	double sinc = fabs(t) < 1e-6 ? 1.0 : sin(PI * t) / (PI * t);
+	return sinc * besselI0(alpha * sqrt(1.0 - x * x)) / besselI0(alpha);
+}
+
+static int addressPixel(int index, int size, bool wrap) {
+	if (wrap) {
+		return ((index % size) + size) % size;
+	}
+	return clamp(index, 0, size - 1);
+}
+
+// Precomputes the taps for resampling srcSize pixels down to dstSize pixels
+static Filter1D buildFilter(int srcSize, int dstSize, const Mip_Settings& settings) {
+	double scale = (double)srcSize / dstSize;
+	double support = settings.filter == MIP_FILTER_BOX ? scale * 0.5 : scale * 1.5;
+
+	Filter1D filter;
+	filter.tapCount = (int)ceil(support * 2.0) + 1;
+	filter.indices.resize((size_t)dstSize * filter.tapCount);
+	filter.weights.resize((size_t)dstSize * filter.tapCount);
+
+	for (int i = 0; i < dstSize; i++) {
+		double center = (i + 0.5) * scale;
+		int first = (int)floor(center - support);
+
+		double total = 0.0;
+		for (int tap = 0; tap < filter.tapCount; tap++) {
+			int source = first + tap;
+			double weight = filterWeight(settings.filter, source + 0.5 - center, scale);
+			filter.indices[i * filter.tapCount + tap] = addressPixel(source, srcSize, settings.wrap);
+			filter.weights[i * filter.tapCount + tap] = (float)weight;
+			total += weight;
+		}
+
+		// Normalize so flat areas keep their brightness
+		for (int tap = 0; tap < filter.tapCount; tap++) {
+			filter.weights[i * filter.tapCount + tap] = (float)(filter.weights[i * filter.tapCount + tap] / total);
+		}
+	}
+
+	return filter;
+}
+
+// Accumulates weighted RGBA pixels; stride is the distance between taps in floats
+static inline void accumulate(const float* source, const int* indices, const float* weights, int tapCount, int stride, float* out) {
+#ifdef MIP_GENERATOR_SSE2
+	__m128 sum = _mm_setzero_ps();
+	for (int tap = 0; tap < tapCount; tap++) {
+		__m128 pixel = _mm_loadu_ps(source + (size_t)indices[tap] * stride);
+		sum = _mm_add_ps(sum, _mm_mul_ps(pixel, _mm_set1_ps(weights[tap])));
+	}
+	_mm_storeu_ps(out, sum);
+#else
+	float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int tap = 0; tap < tapCount; tap++) {
+		const float* pixel = source + (size_t)indices[tap] * stride;
+		for (int c = 0; c < 4; c++) {
+			sum[c] += pixel[c] * weights[tap];
+		}
+	}
+	memcpy(out, sum, sizeof(sum));
+#endif
+}
+
+// Separable downsample: rows first into a temporary image, then columns
+static FloatImage downsample(const FloatImage& source, const Mip_Settings& settings) {
+	int dstWidth = max(1, source.width / 2);
+	int dstHeight = max(1, source.height / 2);
+	Filter1D horizontal = buildFilter(source.width, dstWidth, settings);
+	Filter1D vertical = buildFilter(source.height, dstHeight, settings);
+
+	vector<float> rows((size_t)dstWidth * source.height * 4);
+	parallelFor(source.height, [&](int begin, int end) {
+		for (int y = begin; y < end; y++) {
+			const float* sourceRow = &source.pixels[(size_t)y * source.width * 4];
+			for (int x = 0; x < dstWidth; x++) {
+				accumulate(sourceRow, &horizontal.indices[x * horizontal.tapCount], &horizontal.weights[x * horizontal.tapCount],
+					horizontal.tapCount, 4, &rows[((size_t)y * dstWidth + x) * 4]);
+			}
+		}
+	}, settings.threadCount);
+
+	FloatImage result;
+	result.width = dstWidth;
+	result.height = dstHeight;
+	result.pixels.resize((size_t)dstWidth * dstHeight * 4);
+	parallelFor(dstHeight, [&](int begin, int end) {
+		for (int y = begin; y < end; y++) {
+			const int* indices = &vertical.indices[y * vertical.tapCount];
+			const float* weights = &vertical.weights[y * vertical.tapCount];
+			for (int x = 0; x < dstWidth; x++) {
+				accumulate(&rows[(size_t)x * 4], indices, weights, vertical.tapCount, dstWidth * 4, &result.pixels[((size_t)y * dstWidth + x) * 4]);
+			}
+		}
+	}, settings.threadCount);
+
+	return result;
+}
+
+// Fraction of pixels that pass the alpha test once alpha is multiplied by scale
+static float alphaCoverage(const FloatImage& image, float scale, float cutoff) {
+	size_t pixelCount = (size_t)image.width * image.height;
+	size_t covered = 0;
+	for (size_t i = 0; i < pixelCount; i++) {
+		if (image.pixels[i * 4 + 3] * scale > cutoff) {
+			covered++;
+		}
+	}
+	return (float)covered / pixelCount;
+}
+
+// Finds the alpha scale that gives the level the same coverage as the top level. Coverage
+// only grows with the scale, so a bisection converges
+static float coverageScale(const FloatImage& image, float targetCoverage, float cutoff) {
+	float low = 0.0f, high = 4.0f;
+	for (int iteration = 0; iteration < 16; iteration++) {
+		float middle = (low + high) * 0.5f;
+		if (alphaCoverage(image, middle, cutoff) < targetCoverage) {
+			low = middle;
+		} else {
+			high = middle;
+		}
+	}
+	return (low + high) * 0.5f;
+}
+
+static vector<unsigned char> encodeLevel(const FloatImage& image, bool srgb, float alphaScale) {
+	size_t pixelCount = (size_t)image.width * image.height;
+	vector<unsigned char> rgba(pixelCount * 4);
+	for (size_t i = 0; i < pixelCount; i++) {
+		const float* pixel = &image.pixels[i * 4];
+		for (int c = 0; c < 3; c++) {
+			rgba[i * 4 + c] = srgb ? linearToSrgb(pixel[c]) : (unsigned char)(clamp(pixel[c], 0.0f, 1.0f) * 255.0f + 0.5f);
+		}
+		rgba[i * 4 + 3] = (unsigned char)(clamp(pixel[3] * alphaScale, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+	return rgba;
+}
+
+unsigned int mipLevelCount(int width, int height) {
+	unsigned int levels = 1;
+	while (width > 1 || height > 1) {
+		width = max(1, width / 2);
+		height = max(1, height / 2);
+		levels++;
+	}
+	return levels;
+}
+
+vector<vector<unsigned char>> generateMipChain(const unsigned char* rgba, int width, int height, const Mip_Settings& settings) {
+	vector<vector<unsigned char>> levels;
+	levels.push_back(vector<unsigned char>(rgba, rgba + (size_t)width * height * 4));
+
+	// Decode the top level into linear floats; alpha is always linear
+	FloatImage level;
+	level.width = width;
+	level.height = height;
+	level.pixels.resize((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++) {
+		for (int c = 0; c < 3; c++) {
+			level.pixels[i * 4 + c] = settings.srgb ? srgbToLinear(rgba[i * 4 + c]) : rgba[i * 4 + c] / 255.0f;
+		}
+		level.pixels[i * 4 + 3] = rgba[i * 4 + 3] / 255.0f;
+	}
+
+	float targetCoverage = settings.preserveAlphaCoverage ? alphaCoverage(level, 1.0f, settings.alphaCutoff) : 0.0f;
+
+	while (level.width > 1 || level.height > 1) {
+		level = downsample(level, settings);
+
+		// The chain keeps filtering the unscaled alpha, only the stored level is rescaled
+		float alphaScale = 1.0f;
+		if (settings.preserveAlphaCoverage) {
+			alphaScale = coverageScale(level, targetCoverage, settings.alphaCutoff);
+		}
+		levels.push_back(encodeLevel(level, settings.srgb, alphaScale));
+	}
+
+	return levels;
+}
@@ -0,0 +1,333 @@
+#include "../header/PostChain.h"
+#include "../header/TextureLoader.h"
+#include "../header/FullscreenPass.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+using namespace std;
+
+namespace {
+
+	// Point effects before a kernel run once per tap when fused into it. Past this many taps a pass
+	// of their own is cheaper
+	const unsigned int MAX_PROLOGUE_TAPS = 9;
+
+	// GLSL wants a decimal point in a float literal
+	string floatLiteral(float value) {
+		ostringstream literal;
+		literal << showpoint << setprecision(9) << value;
+		return literal.str();
+	}
+
+	unsigned int tapCount(const Post_Pass& pass, const vector<Post_Effect>& effects) {
+		if (pass.kernel < 0) {
+			return 1;
+		}
+		return pass.axis < 0 ? effects[pass.kernel].size * effects[pass.kernel].size : effects[pass.kernel].size;
+	}
+}
+
+bool separateKernel(const vector<float>& kernel, unsigned int size, vector<float>& column, vector<float>& row) {
+	// The largest weight is the safest to divide by
+	unsigned int pivot = 0;
+	for (unsigned int i = 1; i < size * size; i++) {
+		if (fabs(kernel[i]) > fabs(kernel[pivot])) {
+			pivot = i;
+		}
+	}
+	float largest = fabs(kernel[pivot]);
+	if (largest == 0.0f) {
+		return false;
+	}
+
+	// A separable kernel has rank one: every row is a multiple of the pivot's row, by the weight in
+	// the pivot's column
+	unsigned int pivotRow = pivot / size;
+	unsigned int pivotColumn = pivot % size;
+	column.resize(size);
+	row.resize(size);
+	for (unsigned int i = 0; i < size; i++) {
+		column[i] = kernel[i * size + pivotColumn];
+		row[i] = kernel[pivotRow * size + i] / kernel[pivot];
+	}
+
+	for (unsigned int y = 0; y < size; y++) {
+		for (unsigned int x = 0; x < size; x++) {
+			if (fabs(kernel[y * size + x] - column[y] * row[x]) > 1e-5f * largest) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+PostChain::PostChain(unsigned int width, unsigned int height)
+	: width(width), height(height) {
+	glGenFramebuffers(2, framebuffers);
+	glGenTextures(2, textures);
+	for (unsigned int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "ERROR::POST_CHAIN::FRAMEBUFFER_NOT_COMPLETE" << endl;
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+PostChain::~PostChain() {
+	deletePrograms();
+	glDeleteTextures(2, textures);
+	glDeleteFramebuffers(2, framebuffers);
+}
+
+void PostChain::addPointEffect(const string& name, const string& code, const string& uniforms) {
+	Post_Effect effect;
+	effect.name = name;
+	effect.type = POINT_EFFECT;
+	effect.uniforms = uniforms;
+	effect.code = code;
+	effect.size = 1;
+	effect.spacing = 1.0f;
+	effects.push_back(effect);
+}
+
+void PostChain::addKernelEffect(const string& name, const vector<float>& kernel, float spacing) {
+	unsigned int size = (unsigned int)round(sqrt((float)kernel.size()));
+	if (size * size != kernel.size() || size % 2 == 0) {
+		cout << "ERROR::POST_CHAIN::KERNEL_NOT_ODD_SQUARE: " << name << endl;
+		return;
+	}
+
+	Post_Effect effect;
+	effect.name = name;
+	effect.type = KERNEL_EFFECT;
+	effect.kernel = kernel;
+	effect.size = size;
+	effect.spacing = spacing;
+	effects.push_back(effect);
+}
+
+void PostChain::compile(bool fuse) {
+	deletePrograms();
+	passes.clear();
+
+	// Point effects waiting for a pass, only ever those before the first kernel
+	vector<int> pending;
+	for (int i = 0; i < (int)effects.size(); i++) {
+		const Post_Effect& effect = effects[i];
+		if (effect.type == POINT_EFFECT) {
+			if (!fuse) {
+				Post_Pass pass;
+				pass.epilogue.push_back(i);
+				passes.push_back(pass);
+			}
+			else if (!passes.empty()) {
+				// Free after a kernel: the pass has the color in hand already
+				passes.back().epilogue.push_back(i);
+			}
+			else {
+				pending.push_back(i);
+			}
+			continue;
+		}
+
+		vector<float> column;
+		vector<float> row;
+		if (fuse && separateKernel(effect.kernel, effect.size, column, row)) {
+			Post_Pass horizontal;
+			horizontal.kernel = i;
+			horizontal.axis = 0;
+			horizontal.weights = row;
+			passes.push_back(horizontal);
+
+			Post_Pass vertical;
+			vertical.kernel = i;
+			vertical.axis = 1;
+			vertical.weights = column;
+			passes.push_back(vertical);
+		}
+		else {
+			Post_Pass pass;
+			pass.kernel = i;
+			pass.weights = effect.kernel;
+			passes.push_back(pass);
+		}
+
+		// The leading point effects go into the first pass of the first kernel when it reads few
+		// enough taps, and before it on their own otherwise
+		if (!pending.empty()) {
+			Post_Pass& first = passes[passes.size() - (passes.back().axis == 1 ? 2 : 1)];
+			if (tapCount(first, effects) <= MAX_PROLOGUE_TAPS) {
+				first.prologue = pending;
+			}
+			else {
+				Post_Pass pass;
+				pass.epilogue = pending;
+				passes.insert(passes.begin(), pass);
+			}
+			pending.clear();
+		}
+	}
+
+	// A chain of point effects only is a single pass
+	if (!pending.empty()) {
+		Post_Pass pass;
+		pass.epilogue = pending;
+		passes.push_back(pass);
+	}
+
+	for (Post_Pass& pass : passes) {
+		pass.program = compileProgram(FULLSCREEN_VERTEX_SHADER, shaderSource(pass), "POST_CHAIN");
+		glUseProgram(pass.program);
+		glUniform1i(glGetUniformLocation(pass.program, "image"), 0);
+	}
+}
+
+void PostChain::apply(unsigned int source) {
+	if (passes.empty()) {
+		return;
+	}
+
+	GLint previousFramebuffer;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	for (size_t i = 0; i < passes.size(); i++) {
+		const Post_Pass& pass = passes[i];
+		if (i + 1 < passes.size()) {
+			glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i % 2]);
+			glViewport(0, 0, width, height);
+		}
+		else {
+			glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+			glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+		}
+
+		glUseProgram(pass.program);
+		glUniform2f(glGetUniformLocation(pass.program, "texelSize"), 1.0f / width, 1.0f / height);
+		for (const auto& uniform : floatUniforms) {
+			glUniform1f(glGetUniformLocation(pass.program, uniform.first.c_str()), uniform.second);
+		}
+		bindTexture(0, i == 0 ? source : textures[(i - 1) % 2]);
+		drawFullscreenTriangle();
+	}
+
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (blend) {
+		glEnable(GL_BLEND);
+	}
+}
+
+void PostChain::setFloat(const string& name, float value) {
+	floatUniforms[name] = value;
+}
+
+unsigned int PostChain::passCount() const {
+	return (unsigned int)passes.size();
+}
+
+string PostChain::describe() const {
+	const char* AXIS_NAMES[] = { " (x)", " (y)" };
+
+	string description;
+	for (size_t i = 0; i < passes.size(); i++) {
+		const Post_Pass& pass = passes[i];
+		vector<string> names;
+		for (int effect : pass.prologue) {
+			names.push_back(effects[effect].name);
+		}
+		if (pass.kernel >= 0) {
+			names.push_back(effects[pass.kernel].name + (pass.axis < 0 ? "" : AXIS_NAMES[pass.axis]));
+		}
+		for (int effect : pass.epilogue) {
+			names.push_back(effects[effect].name);
+		}
+
+		if (i > 0) {
+			description += " | ";
+		}
+		for (size_t j = 0; j < names.size(); j++) {
+			description += (j > 0 ? " > " : "") + names[j];
+		}
+	}
+	return description;
+}
+
+void PostChain::deletePrograms() {
+	for (Post_Pass& pass : passes) {
+		glDeleteProgram(pass.program);
+		pass.program = 0;
+	}
+}
+
+string PostChain::shaderSource(const Post_Pass& pass) const {
+	string source =
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"in vec2 TexCoords;\n"
+		"uniform sampler2D image;\n"
+		"uniform vec2 texelSize;\n";
+
+	// Effects declaring the same uniforms share one declaration
+	set<string> declared;
+	for (const vector<int>* stage : { &pass.prologue, &pass.epilogue }) {
+		for (int effect : *stage) {
+			if (!effects[effect].uniforms.empty() && declared.insert(effects[effect].uniforms).second) {
+				source += effects[effect].uniforms + "\n";
+			}
+		}
+	}
+
+	// Every effect in a scope of its own, so their local names can't clash
+	for (const vector<int>* stage : { &pass.prologue, &pass.epilogue }) {
+		source += stage == &pass.prologue ? "vec3 prologue(vec3 color) {\n" : "vec3 epilogue(vec3 color) {\n";
+		for (int effect : *stage) {
+			source += "    { // " + effects[effect].name + "\n" + effects[effect].code + "\n    }\n";
+		}
+		source += "    return color;\n}\n";
+	}
+
+	source += "void main() {\n";
+	if (pass.kernel < 0) {
+		source += "    vec3 color = texture(image, TexCoords).rgb;\n";
+	}
+	else {
+		// Taps unrolled with their weights and offsets as constants; taps of weight 0 are skipped
+		const Post_Effect& kernel = effects[pass.kernel];
+		int half = (int)kernel.size / 2;
+		source += "    vec3 color = vec3(0.0);\n";
+		for (size_t i = 0; i < pass.weights.size(); i++) {
+			if (pass.weights[i] == 0.0f) {
+				continue;
+			}
+
+			// Rows run from the top, and texture coordinates up
+			int x = pass.axis < 0 ? (int)(i % kernel.size) - half : pass.axis == 0 ? (int)i - half : 0;
+			int y = pass.axis < 0 ? half - (int)(i / kernel.size) : pass.axis == 1 ? half - (int)i : 0;
+			source += "    color += prologue(texture(image, TexCoords + vec2(" + floatLiteral(x * kernel.spacing) + ", "
+				+ floatLiteral(y * kernel.spacing) + ") * texelSize).rgb) * " + floatLiteral(pass.weights[i]) + ";\n";
+		}
+	}
+	source += "    FragColor = vec4(epilogue(color), 1.0);\n}\n";
+	return source;
+}
@@ -0,0 +1,309 @@
+#include "../header/ShadowAtlas.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+ShadowAtlas::ShadowAtlas(unsigned int atlasSize, unsigned int maxTileSize, unsigned int minTileSize, unsigned int tilesPerFrame)
+	: atlasSize(atlasSize), maxTileSize(min(maxTileSize, atlasSize)), minTileSize(min(minTileSize, maxTileSize)),
+	  tilesPerFrame(max(1u, tilesPerFrame)), nextLight(0), usedTexels(0) {
+	glGenTextures(1, &depthTexture);
+	glBindTexture(GL_TEXTURE_2D, depthTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, atlasSize, atlasSize, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "ERROR::SHADOW_ATLAS::FRAMEBUFFER_NOT_COMPLETE" << endl;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	// The atlas starts out as a grid of free tiles of the largest size
+	freeTiles.resize(level(this->minTileSize) + 1);
+	for (unsigned int y = 0; y + this->maxTileSize <= atlasSize; y += this->maxTileSize) {
+		for (unsigned int x = 0; x + this->maxTileSize <= atlasSize; x += this->maxTileSize) {
+			freeTiles[0].push_back({ x, y, this->maxTileSize });
+		}
+	}
+}
+
+ShadowAtlas::~ShadowAtlas() {
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteTextures(1, &depthTexture);
+}
+
+unsigned int ShadowAtlas::addLight(Shadow_Light_Type type) {
+	AtlasLight light;
+	light.type = type;
+	light.pixels = 0.0f;
+	light.distance = 0.0f;
+	light.movement = 0.0f;
+	light.framesWaiting = 0;
+
+	lights[nextLight] = light;
+	return nextLight++;
+}
+
+void ShadowAtlas::removeLight(unsigned int light) {
+	auto found = lights.find(light);
+	if (found == lights.end()) {
+		return;
+	}
+
+	releaseTiles(found->second.tiles);
+	releaseTiles(found->second.pendingTiles);
+	lights.erase(found);
+}
+
+void ShadowAtlas::updateLight(unsigned int light, float pixels, float distance, float movement) {
+	auto found = lights.find(light);
+	if (found == lights.end()) {
+		return;
+	}
+
+	found->second.pixels = pixels;
+	found->second.distance = distance;
+	found->second.movement += movement;
+}
+
+vector<Shadow_Update> ShadowAtlas::schedule() {
+	// Move lights to new tiles where their footprint has outgrown or shrunk away from the old ones.
+	// The old tiles stay in use until the new ones are drawn
+	for (auto& entry : lights) {
+		AtlasLight& light = entry.second;
+		unsigned int count = light.type == POINT_SHADOW ? 6 : 1;
+		unsigned int size = tileSizeFor(light);
+		if (size == allocatedSize(light)) {
+			continue;
+		}
+
+		// Back at the size it is drawn at, the light doesn't need new tiles after all
+		releaseTiles(light.pendingTiles);
+		if (!light.tiles.empty() && size == light.tiles[0].size) {
+			continue;
+		}
+		if (allocateTiles(size, count, light.pendingTiles) || !light.tiles.empty()) {
+			continue;
+		}
+
+		// A light without any shadow yet takes the largest tiles that still fit
+		for (size /= 2; size >= minTileSize; size /= 2) {
+			if (allocateTiles(size, count, light.pendingTiles)) {
+				break;
+			}
+		}
+	}
+
+	// Lights on new tiles first, then the ones that moved most, nearest and longest waiting first
+	vector<pair<float, unsigned int>> queue;
+	for (auto& entry : lights) {
+		AtlasLight& light = entry.second;
+		bool resized = !light.pendingTiles.empty();
+		if (!resized && (light.movement <= 0.0f || light.tiles.empty())) {
+			continue;
+		}
+
+		float priority = (1.0f + light.framesWaiting) * (1.0f + light.movement) / (1.0f + light.distance);
+		queue.push_back({ resized ? priority + 1.0e6f : priority, entry.first });
+	}
+	sort(queue.begin(), queue.end(), [](const pair<float, unsigned int>& a, const pair<float, unsigned int>& b) {
+		return a.first > b.first;
+	});
+
+	vector<Shadow_Update> updates;
+	unsigned int drawnTiles = 0;
+	bool full = false;
+	for (const pair<float, unsigned int>& item : queue) {
+		AtlasLight& light = lights[item.second];
+		unsigned int count = light.type == POINT_SHADOW ? 6 : 1;
+
+		// Stop at the first light that doesn't fit, so a point light's six tiles aren't starved
+		// by single tiles that always fit in behind it
+		full = full || (!updates.empty() && drawnTiles + count > tilesPerFrame);
+		if (full) {
+			light.framesWaiting++;
+			continue;
+		}
+
+		if (!light.pendingTiles.empty()) {
+			releaseTiles(light.tiles);
+			light.tiles.swap(light.pendingTiles);
+		}
+		updates.push_back({ item.second, light.tiles });
+		light.movement = 0.0f;
+		light.framesWaiting = 0;
+		drawnTiles += count;
+	}
+	return updates;
+}
+
+void ShadowAtlas::beginTile(const Shadow_Tile& tile) {
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glViewport(tile.x, tile.y, tile.size, tile.size);
+
+	// The clear would wipe the whole atlas without the scissor
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(tile.x, tile.y, tile.size, tile.size);
+	glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+void ShadowAtlas::endTiles() {
+	glDisable(GL_SCISSOR_TEST);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+const vector<Shadow_Tile>& ShadowAtlas::getTiles(unsigned int light) const {
+	static const vector<Shadow_Tile> none;
+	auto found = lights.find(light);
+	return found != lights.end() ? found->second.tiles : none;
+}
+
+vec4 ShadowAtlas::tileTransform(const Shadow_Tile& tile) const {
+	float scale = (float)tile.size / atlasSize;
+	return vec4(scale, scale, (float)tile.x / atlasSize, (float)tile.y / atlasSize);
+}
+
+void ShadowAtlas::setTilesPerFrame(unsigned int tilesPerFrame) {
+	this->tilesPerFrame = max(1u, tilesPerFrame);
+}
+
+unsigned int ShadowAtlas::getTilesPerFrame() const {
+	return tilesPerFrame;
+}
+
+float ShadowAtlas::occupancy() const {
+	return (float)((double)usedTexels / ((double)atlasSize * atlasSize));
+}
+
+unsigned int ShadowAtlas::texture() const {
+	return depthTexture;
+}
+
+unsigned int ShadowAtlas::level(unsigned int tileSize) const {
+	unsigned int result = 0;
+	for (unsigned int size = maxTileSize; size > tileSize && size > minTileSize; size /= 2) {
+		result++;
+	}
+	return result;
+}
+
+unsigned int ShadowAtlas::tileSizeFor(const AtlasLight& light) const {
+	// A directional light covers the whole view
+	if (light.type == DIRECTIONAL_SHADOW) {
+		return maxTileSize;
+	}
+
+	// About half of a point light's footprint falls into any one of its faces
+	float wanted = light.type == POINT_SHADOW ? light.pixels * 0.5f : light.pixels;
+
+	// Keep the size while the footprint stays between half and twice of it, so a light close to
+	// a boundary doesn't jump between sizes every frame
+	unsigned int current = allocatedSize(light);
+	if (current != 0 && wanted >= current * 0.5f && wanted < current * 2.0f) {
+		return current;
+	}
+
+	unsigned int size = minTileSize;
+	while (size * 2 <= maxTileSize && size * 2 <= wanted) {
+		size *= 2;
+	}
+	return size;
+}
+
+unsigned int ShadowAtlas::allocatedSize(const AtlasLight& light) const {
+	if (!light.pendingTiles.empty()) {
+		return light.pendingTiles[0].size;
+	}
+	return light.tiles.empty() ? 0 : light.tiles[0].size;
+}
+
+bool ShadowAtlas::allocate(unsigned int tileSize, Shadow_Tile& tile) {
+	// The smallest free tile at least as large, split down to the size asked for
+	int wanted = (int)level(tileSize);
+	int found = wanted;
+	while (found >= 0 && freeTiles[found].empty()) {
+		found--;
+	}
+	if (found < 0) {
+		return false;
+	}
+
+	tile = freeTiles[found].back();
+	freeTiles[found].pop_back();
+	for (; found < wanted; found++) {
+		unsigned int half = tile.size / 2;
+		freeTiles[found + 1].push_back({ tile.x + half, tile.y, half });
+		freeTiles[found + 1].push_back({ tile.x, tile.y + half, half });
+		freeTiles[found + 1].push_back({ tile.x + half, tile.y + half, half });
+		tile.size = half;
+	}
+
+	usedTexels += (unsigned long long)tile.size * tile.size;
+	return true;
+}
+
+void ShadowAtlas::release(const Shadow_Tile& released) {
+	usedTexels -= (unsigned long long)released.size * released.size;
+
+	// Merge the tile with its three buddies into their parent for as long as they are all free
+	Shadow_Tile tile = released;
+	unsigned int tileLevel = level(tile.size);
+	while (tileLevel > 0) {
+		unsigned int parentSize = tile.size * 2;
+		unsigned int parentX = tile.x - tile.x % parentSize;
+		unsigned int parentY = tile.y - tile.y % parentSize;
+
+		vector<Shadow_Tile>& list = freeTiles[tileLevel];
+		vector<unsigned int> buddies;
+		for (unsigned int i = 0; i < list.size(); i++) {
+			bool inParent = list[i].x >= parentX && list[i].x < parentX + parentSize && list[i].y >= parentY && list[i].y < parentY + parentSize;
+			if (inParent) {
+				buddies.push_back(i);
+			}
+		}
+		if (buddies.size() < 3) {
+			break;
+		}
+
+		// Erase from the back so the other indices stay valid
+		for (int i = (int)buddies.size() - 1; i >= 0; i--) {
+			list.erase(list.begin() + buddies[i]);
+		}
+		tile = { parentX, parentY, parentSize };
+		tileLevel--;
+	}
+	freeTiles[tileLevel].push_back(tile);
+}
+
+bool ShadowAtlas::allocateTiles(unsigned int tileSize, unsigned int count, vector<Shadow_Tile>& tiles) {
+	vector<Shadow_Tile> allocated;
+	for (unsigned int i = 0; i < count; i++) {
+		Shadow_Tile tile;
+		if (!allocate(tileSize, tile)) {
+			releaseTiles(allocated);
+			return false;
+		}
+		allocated.push_back(tile);
+	}
+
+	tiles = allocated;
+	return true;
+}
+
+void ShadowAtlas::releaseTiles(vector<Shadow_Tile>& tiles) {
+	for (const Shadow_Tile& tile : tiles) {
+		release(tile);
+	}
+	tiles.clear();
+}
@@ -0,0 +1,125 @@
+#include "../header/ShadowCache.h"
+
+#include <iostream>
+
+using namespace std;
+
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_copy_image)
+static bool copyImageSupported() {
+#ifdef GL_VERSION_4_3
+	if (GLAD_GL_VERSION_4_3) {
+		return true;
+	}
+#endif
+#ifdef GL_ARB_copy_image
+	if (GLAD_GL_ARB_copy_image) {
+		return true;
+	}
+#endif
+	return false;
+}
+#endif
+
+ShadowCache::ShadowCache(GLenum target, unsigned int size, unsigned int layers, GLenum internalFormat)
+	: target(target), size(size), layers(layers), dirty(0) {
+	glGenTextures(1, &cacheTexture);
+	glBindTexture(target, cacheTexture);
+	if (target == GL_TEXTURE_CUBE_MAP) {
+		for (unsigned int face = 0; face < 6; face++) {
+			glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, internalFormat, size, size, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+		}
+	} else {
+		glTexImage3D(target, 0, internalFormat, size, size, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	}
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(target, 0);
+
+	glGenFramebuffers(1, &layeredFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, layeredFramebuffer);
+	glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, cacheTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		cout << "ERROR::SHADOW_CACHE::FRAMEBUFFER_NOT_COMPLETE" << endl;
+	}
+
+	// Single-layer framebuffers for clearing one layer and for copying without copy image support
+	glGenFramebuffers(2, layerFramebuffers);
+	for (unsigned int i = 0; i < 2; i++) {
+		glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffers[i]);
+		glDrawBuffer(GL_NONE);
+		glReadBuffer(GL_NONE);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	invalidate();
+}
+
+ShadowCache::~ShadowCache() {
+	glDeleteFramebuffers(2, layerFramebuffers);
+	glDeleteFramebuffers(1, &layeredFramebuffer);
+	glDeleteTextures(1, &cacheTexture);
+}
+
+void ShadowCache::invalidate() {
+	dirty = (1u << layers) - 1;
+}
+
+void ShadowCache::invalidate(unsigned int layer) {
+	dirty |= 1u << layer;
+}
+
+unsigned int ShadowCache::dirtyMask() const {
+	return dirty;
+}
+
+void ShadowCache::beginRebuild() {
+	glViewport(0, 0, size, size);
+
+	// glClear on the layered framebuffer would clear the clean layers too
+	glBindFramebuffer(GL_FRAMEBUFFER, layerFramebuffers[0]);
+	for (unsigned int layer = 0; layer < layers; layer++) {
+		if (dirty & (1u << layer)) {
+			attachLayer(GL_FRAMEBUFFER, cacheTexture, layer);
+			glClear(GL_DEPTH_BUFFER_BIT);
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, layeredFramebuffer);
+}
+
+void ShadowCache::endRebuild() {
+	dirty = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void ShadowCache::copyTo(unsigned int shadowMap) {
+#if defined(GL_VERSION_4_3) || defined(GL_ARB_copy_image)
+	if (copyImageSupported()) {
+		glCopyImageSubData(cacheTexture, target, 0, 0, 0, 0, shadowMap, target, 0, 0, 0, 0, size, size, layers);
+		return;
+	}
+#endif
+
+	// Depth blits only copy one layer each
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, layerFramebuffers[0]);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, layerFramebuffers[1]);
+	for (unsigned int layer = 0; layer < layers; layer++) {
+		attachLayer(GL_READ_FRAMEBUFFER, cacheTexture, layer);
+		attachLayer(GL_DRAW_FRAMEBUFFER, shadowMap, layer);
+		glBlitFramebuffer(0, 0, size, size, 0, 0, size, size, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+unsigned int ShadowCache::texture() const {
+	return cacheTexture;
+}
+
+void ShadowCache::attachLayer(GLenum framebufferTarget, unsigned int texture, unsigned int layer) {
+	if (target == GL_TEXTURE_CUBE_MAP) {
+		glFramebufferTexture2D(framebufferTarget, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + layer, texture, 0);
+	} else {
+		glFramebufferTextureLayer(framebufferTarget, GL_DEPTH_ATTACHMENT, texture, 0, layer);
+	}
+}
@@ -0,0 +1,255 @@
+#include "../header/TangentGenerator.h"
+#include "../header/ParallelFor.h"
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TANGENT_GENERATOR_SSE2
+#endif
+
+using namespace std;
+using namespace glm;
+
+static const float PI = 3.14159265358979f;
+
+// Per vertex sums for faces that keep the texture's orientation in [0, 4) and for mirrored faces
+// in [4, 8): the weighted tangent in xyz and the total weight in w
+static const unsigned int sumStride = 8;
+
+static unsigned int vertexOf(const Tangent_Mesh& mesh, size_t corner) {
+	return mesh.indices != nullptr ? mesh.indices[corner] : (unsigned int)corner;
+}
+
+// The SIMD and scalar paths do the same operations per corner, so their tangents only differ by
+// the order the corners are summed in. A length of zero stays zero, as in MikkTSpace
+static vec3 normalizeOrZero(const vec3& v) {
+	float length = sqrt(dot(v, v));
+	return length > 0.0f ? v * (1.0f / length) : vec3(0.0f);
+}
+
+static vec3 projectOnPlane(const vec3& v, const vec3& normal) {
+	return v - normal * dot(normal, v);
+}
+
+// acos to within 7e-5 radians (Abramowitz and Stegun 4.4.45), which is plenty for a weight and
+// has a SIMD form
+static float approximateAcos(float x) {
+	float a = fabs(x);
+	float result = sqrt(1.0f - a) * (1.5707288f + a * (-0.2121144f + a * (0.0742610f + a * -0.0187293f)));
+	return x < 0.0f ? PI - result : result;
+}
+
+static void accumulateFace(const Tangent_Mesh& mesh, size_t face, float* sums) {
+	unsigned int vertices[3];
+	vec3 positions[3];
+	vec3 normals[3];
+	vec2 texCoords[3];
+	for (unsigned int k = 0; k < 3; k++) {
+		vertices[k] = vertexOf(mesh, face * 3 + k);
+		const float* position = mesh.positions + (size_t)vertices[k] * mesh.positionStride;
+		const float* normal = mesh.normals + (size_t)vertices[k] * mesh.normalStride;
+		const float* texCoord = mesh.texCoords + (size_t)vertices[k] * mesh.texCoordStride;
+		positions[k] = vec3(position[0], position[1], position[2]);
+		normals[k] = vec3(normal[0], normal[1], normal[2]);
+		texCoords[k] = vec2(texCoord[0], texCoord[1]);
+	}
+
+	// The direction of increasing u on the face, normalized. A face whose texture coordinates
+	// have no area has no tangent and adds nothing
+	vec3 d1 = positions[1] - positions[0];
+	vec3 d2 = positions[2] - positions[0];
+	vec2 t21 = texCoords[1] - texCoords[0];
+	vec2 t31 = texCoords[2] - texCoords[0];
+	float area = t21.x * t31.y - t21.y * t31.x;
+	vec3 os = d1 * t31.y - d2 * t21.y;
+	float length = sqrt(dot(os, os));
+	if (area == 0.0f || !(length > 0.0f)) {
+		return;
+	}
+	bool preserving = area > 0.0f;
+	vec3 faceTangent = os * ((preserving ? 1.0f : -1.0f) * (1.0f / length));
+
+	for (unsigned int k = 0; k < 3; k++) {
+		vec3 normal = normalizeOrZero(normals[k]);
+		vec3 tangent = normalizeOrZero(projectOnPlane(faceTangent, normal));
+		vec3 edge1 = normalizeOrZero(projectOnPlane(positions[(k + 1) % 3] - positions[k], normal));
+		vec3 edge2 = normalizeOrZero(projectOnPlane(positions[(k + 2) % 3] - positions[k], normal));
+		float angle = approximateAcos(glm::min(glm::max(dot(edge1, edge2), -1.0f), 1.0f));
+
+		float* sum = sums + (size_t)vertices[k] * sumStride + (preserving ? 0 : 4);
+		sum[0] += tangent.x * angle;
+		sum[1] += tangent.y * angle;
+		sum[2] += tangent.z * angle;
+		sum[3] += angle;
+	}
+}
+
+#ifdef TANGENT_GENERATOR_SSE2
+// Four faces side by side, one in each lane
+struct Lanes3 {
+	__m128 x;
+	__m128 y;
+	__m128 z;
+};
+
+static inline Lanes3 gather3(const float* base, unsigned int stride, const unsigned int* vertices) {
+	const float* a = base + (size_t)vertices[0] * stride;
+	const float* b = base + (size_t)vertices[1] * stride;
+	const float* c = base + (size_t)vertices[2] * stride;
+	const float* d = base + (size_t)vertices[3] * stride;
+	return { _mm_setr_ps(a[0], b[0], c[0], d[0]), _mm_setr_ps(a[1], b[1], c[1], d[1]), _mm_setr_ps(a[2], b[2], c[2], d[2]) };
+}
+
+static inline Lanes3 sub(const Lanes3& a, const Lanes3& b) {
+	return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+}
+
+static inline Lanes3 scale(const Lanes3& v, __m128 s) {
+	return { _mm_mul_ps(v.x, s), _mm_mul_ps(v.y, s), _mm_mul_ps(v.z, s) };
+}
+
+static inline __m128 dot(const Lanes3& a, const Lanes3& b) {
+	return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+}
+
+static inline Lanes3 normalizeOrZero(const Lanes3& v) {
+	__m128 length = _mm_sqrt_ps(dot(v, v));
+	__m128 inverse = _mm_and_ps(_mm_cmpgt_ps(length, _mm_setzero_ps()), _mm_div_ps(_mm_set1_ps(1.0f), length));
+	return scale(v, inverse);
+}
+
+static inline Lanes3 projectOnPlane(const Lanes3& v, const Lanes3& normal) {
+	return sub(v, scale(normal, dot(normal, v)));
+}
+
+static inline __m128 approximateAcos(__m128 x) {
+	__m128 a = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+	__m128 polynomial = _mm_add_ps(_mm_set1_ps(0.0742610f), _mm_mul_ps(a, _mm_set1_ps(-0.0187293f)));
+	polynomial = _mm_add_ps(_mm_set1_ps(-0.2121144f), _mm_mul_ps(a, polynomial));
+	polynomial = _mm_add_ps(_mm_set1_ps(1.5707288f), _mm_mul_ps(a, polynomial));
+	__m128 result = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(_mm_set1_ps(1.0f), a)), polynomial);
+	__m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(PI), result)), _mm_andnot_ps(negative, result));
+}
+
+// accumulateFace for four faces at once. Only the gathers and the final sums touch one face at a time
+static void accumulateFaces(const Tangent_Mesh& mesh, size_t firstFace, float* sums) {
+	unsigned int vertices[3][4];
+	for (unsigned int lane = 0; lane < 4; lane++) {
+		for (unsigned int k = 0; k < 3; k++) {
+			vertices[k][lane] = vertexOf(mesh, (firstFace + lane) * 3 + k);
+		}
+	}
+
+	Lanes3 positions[3];
+	Lanes3 normals[3];
+	__m128 u[3];
+	__m128 v[3];
+	for (unsigned int k = 0; k < 3; k++) {
+		positions[k] = gather3(mesh.positions, mesh.positionStride, vertices[k]);
+		normals[k] = gather3(mesh.normals, mesh.normalStride, vertices[k]);
+		const float* a = mesh.texCoords + (size_t)vertices[k][0] * mesh.texCoordStride;
+		const float* b = mesh.texCoords + (size_t)vertices[k][1] * mesh.texCoordStride;
+		const float* c = mesh.texCoords + (size_t)vertices[k][2] * mesh.texCoordStride;
+		const float* d = mesh.texCoords + (size_t)vertices[k][3] * mesh.texCoordStride;
+		u[k] = _mm_setr_ps(a[0], b[0], c[0], d[0]);
+		v[k] = _mm_setr_ps(a[1], b[1], c[1], d[1]);
+	}
+
+	Lanes3 d1 = sub(positions[1], positions[0]);
+	Lanes3 d2 = sub(positions[2], positions[0]);
+	__m128 t21x = _mm_sub_ps(u[1], u[0]);
+	__m128 t21y = _mm_sub_ps(v[1], v[0]);
+	__m128 t31x = _mm_sub_ps(u[2], u[0]);
+	__m128 t31y = _mm_sub_ps(v[2], v[0]);
+	__m128 area = _mm_sub_ps(_mm_mul_ps(t21x, t31y), _mm_mul_ps(t21y, t31x));
+	Lanes3 os = sub(scale(d1, t31y), scale(d2, t21y));
+	__m128 length = _mm_sqrt_ps(dot(os, os));
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 valid = _mm_and_ps(_mm_cmpneq_ps(area, zero), _mm_cmpgt_ps(length, zero));
+	__m128 preserving = _mm_cmpgt_ps(area, zero);
+	__m128 sign = _mm_or_ps(_mm_and_ps(preserving, _mm_set1_ps(1.0f)), _mm_andnot_ps(preserving, _mm_set1_ps(-1.0f)));
+	Lanes3 faceTangent = scale(os, _mm_and_ps(valid, _mm_mul_ps(sign, _mm_div_ps(_mm_set1_ps(1.0f), length))));
+	int validMask = _mm_movemask_ps(valid);
+	int preservingMask = _mm_movemask_ps(preserving);
+
+	for (unsigned int k = 0; k < 3; k++) {
+		Lanes3 normal = normalizeOrZero(normals[k]);
+		Lanes3 tangent = normalizeOrZero(projectOnPlane(faceTangent, normal));
+		Lanes3 edge1 = normalizeOrZero(projectOnPlane(sub(positions[(k + 1) % 3], positions[k]), normal));
+		Lanes3 edge2 = normalizeOrZero(projectOnPlane(sub(positions[(k + 2) % 3], positions[k]), normal));
+		__m128 cosine = _mm_min_ps(_mm_max_ps(dot(edge1, edge2), _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+		__m128 angle = approximateAcos(cosine);
+
+		alignas(16) float x[4], y[4], z[4], weight[4];
+		_mm_store_ps(x, _mm_mul_ps(tangent.x, angle));
+		_mm_store_ps(y, _mm_mul_ps(tangent.y, angle));
+		_mm_store_ps(z, _mm_mul_ps(tangent.z, angle));
+		_mm_store_ps(weight, angle);
+
+		for (unsigned int lane = 0; lane < 4; lane++) {
+			if ((validMask >> lane & 1) == 0) {
+				continue;
+			}
+			float* sum = sums + (size_t)vertices[k][lane] * sumStride + ((preservingMask >> lane & 1) ? 0 : 4);
+			sum[0] += x[lane];
+			sum[1] += y[lane];
+			sum[2] += z[lane];
+			sum[3] += weight[lane];
+		}
+	}
+}
+#endif
+
+void generateTangents(const Tangent_Mesh& mesh) {
+	if (mesh.positions == nullptr || mesh.normals == nullptr || mesh.texCoords == nullptr || mesh.tangents == nullptr) {
+		return;
+	}
+
+	vector<float> sums((size_t)mesh.vertexCount * sumStride, 0.0f);
+	size_t faceCount = (mesh.indices != nullptr ? mesh.indexCount : mesh.vertexCount) / 3;
+	size_t face = 0;
+#ifdef TANGENT_GENERATOR_SSE2
+	for (; face + 4 <= faceCount; face += 4) {
+		accumulateFaces(mesh, face, sums.data());
+	}
+#endif
+	for (; face < faceCount; face++) {
+		accumulateFace(mesh, face, sums.data());
+	}
+
+	for (unsigned int i = 0; i < mesh.vertexCount; i++) {
+		const float* sum = &sums[(size_t)i * sumStride];
+		bool preserving = sum[3] >= sum[7];
+		if (!preserving) {
+			sum += 4;
+		}
+
+		// A vertex without any usable face still gets a tangent on its plane
+		const float* n = mesh.normals + (size_t)i * mesh.normalStride;
+		vec3 normal = normalizeOrZero(vec3(n[0], n[1], n[2]));
+		vec3 tangent = normalizeOrZero(vec3(sum[0], sum[1], sum[2]));
+		if (tangent == vec3(0.0f)) {
+			vec3 axis = fabs(normal.x) < 0.9f ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f);
+			tangent = normalizeOrZero(projectOnPlane(axis, normal));
+		}
+
+		float* out = mesh.tangents + (size_t)i * mesh.tangentStride;
+		out[0] = tangent.x;
+		out[1] = tangent.y;
+		out[2] = tangent.z;
+		out[3] = preserving ? 1.0f : -1.0f;
+	}
+}
+
+void generateTangents(const vector<Tangent_Mesh>& meshes, unsigned int threadCount) {
+	parallelFor((int)meshes.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			generateTangents(meshes[i]);
+		}
+	}, threadCount);
+}
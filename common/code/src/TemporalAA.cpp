@@ -0,0 +1,135 @@
+#include "../header/TemporalAA.h"
+#include "../header/TextureLoader.h"
+#include "../header/FullscreenPass.h"
+
+#include <iostream>
+
+using namespace std;
+
+namespace {
+
+	const char* RESOLVE_SHADER =
+		"#version 330 core\n"
+		"out vec4 FragColor;\n"
+		"in vec2 TexCoords;\n"
+		"uniform sampler2D current;\n"
+		"uniform sampler2D history;\n"
+		"uniform sampler2D velocity;\n"
+		"uniform vec2 texelSize;\n"
+		"uniform float feedback;\n"
+		"uniform bool hasHistory;\n"
+		"// Luma and chroma separate, so the clamp box hugs the colors more tightly than in RGB\n"
+		"vec3 toYCoCg(vec3 c) {\n"
+		"    return vec3(0.25 * c.r + 0.5 * c.g + 0.25 * c.b, 0.5 * c.r - 0.5 * c.b, -0.25 * c.r + 0.5 * c.g - 0.25 * c.b);\n"
+		"}\n"
+		"vec3 toRgb(vec3 c) {\n"
+		"    return vec3(c.x + c.y - c.z, c.x + c.z, c.x - c.y - c.z);\n"
+		"}\n"
+		"void main() {\n"
+		"    vec3 color = texture(current, TexCoords).rgb;\n"
+		"    vec2 previousCoords = TexCoords - texture(velocity, TexCoords).rg;\n"
+		"    if (!hasHistory || any(lessThan(previousCoords, vec2(0.0))) || any(greaterThan(previousCoords, vec2(1.0)))) {\n"
+		"        FragColor = vec4(color, 1.0);\n"
+		"        return;\n"
+		"    }\n"
+		"    // The history may only hold what this frame's 3x3 neighborhood could have blended to\n"
+		"    vec3 center = toYCoCg(color);\n"
+		"    vec3 lowest = center;\n"
+		"    vec3 highest = center;\n"
+		"    for (int y = -1; y <= 1; y++) {\n"
+		"        for (int x = -1; x <= 1; x++) {\n"
+		"            vec3 neighbor = toYCoCg(texture(current, TexCoords + vec2(x, y) * texelSize).rgb);\n"
+		"            lowest = min(lowest, neighbor);\n"
+		"            highest = max(highest, neighbor);\n"
+		"        }\n"
+		"    }\n"
+		"    vec3 previous = toRgb(clamp(toYCoCg(texture(history, previousCoords).rgb), lowest, highest));\n"
+		"    FragColor = vec4(mix(color, previous, feedback), 1.0);\n"
+		"}\n";
+}
+
+TemporalAA::TemporalAA(unsigned int width, unsigned int height, float feedback)
+	: width(width), height(height), feedback(feedback), hasHistory(false), latest(0) {
+	program = compileProgram(FULLSCREEN_VERTEX_SHADER, RESOLVE_SHADER, "TEMPORAL_AA");
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "current"), 0);
+	glUniform1i(glGetUniformLocation(program, "history"), 1);
+	glUniform1i(glGetUniformLocation(program, "velocity"), 2);
+	glUniform2f(glGetUniformLocation(program, "texelSize"), 1.0f / width, 1.0f / height);
+
+	// Half floats, so the small steps of a long average aren't lost to rounding
+	glGenFramebuffers(2, framebuffers);
+	glGenTextures(2, textures);
+	for (unsigned int i = 0; i < 2; i++) {
+		glBindTexture(GL_TEXTURE_2D, textures[i]);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, width, height, 0, GL_RGBA, GL_FLOAT, NULL);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[i], 0);
+		if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+			cout << "ERROR::TEMPORAL_AA::FRAMEBUFFER_NOT_COMPLETE" << endl;
+		}
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+TemporalAA::~TemporalAA() {
+	glDeleteProgram(program);
+	glDeleteTextures(2, textures);
+	glDeleteFramebuffers(2, framebuffers);
+}
+
+unsigned int TemporalAA::resolve(unsigned int current, unsigned int velocity) {
+	GLint previousFramebuffer;
+	GLint previousViewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &previousFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, previousViewport);
+	GLboolean depthTest = glIsEnabled(GL_DEPTH_TEST);
+	GLboolean blend = glIsEnabled(GL_BLEND);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_BLEND);
+
+	// Read the last result as history and write over the one before it
+	unsigned int target = 1 - latest;
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffers[target]);
+	glViewport(0, 0, width, height);
+	glUseProgram(program);
+	glUniform1f(glGetUniformLocation(program, "feedback"), feedback);
+	glUniform1i(glGetUniformLocation(program, "hasHistory"), hasHistory);
+	bindTexture(0, current);
+	bindTexture(1, textures[latest]);
+	bindTexture(2, velocity);
+	drawFullscreenTriangle();
+	latest = target;
+	hasHistory = true;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+	glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+	if (depthTest) {
+		glEnable(GL_DEPTH_TEST);
+	}
+	if (blend) {
+		glEnable(GL_BLEND);
+	}
+	return textures[latest];
+}
+
+unsigned int TemporalAA::resultFramebuffer() const {
+	return framebuffers[latest];
+}
+
+void TemporalAA::reset() {
+	hasHistory = false;
+}
+
+void TemporalAA::setFeedback(float feedback) {
+	this->feedback = feedback;
+}
+
+float TemporalAA::getFeedback() const {
+	return feedback;
+}
@@ -0,0 +1,178 @@
+#include <glad/glad.h>
+
+#include "../header/TextureCache.h"
+#include "../header/KtxFile.h"
+#include "../header/MipGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+string textureCachePath(const string& sourcePath, Texture_Usage usage, bool srgb) {
+	static const char* usageNames[] = { "color", "normal", "height", "cutout" };
+	return sourcePath + "." + usageNames[usage] + (srgb ? ".srgb" : "") + ".ktx";
+}
+
+// Picks the block format for a texture; color images only pay for BC3 when alpha is used
+static Texture_Compression chooseCompression(const unsigned char* rgba, int width, int height, Texture_Usage usage) {
+	if (usage == TEXTURE_NORMAL) {
+		return COMPRESSION_BC5;
+	}
+	if (usage == TEXTURE_HEIGHT) {
+		return COMPRESSION_BC4;
+	}
+	if (usage == TEXTURE_CUTOUT) {
+		return COMPRESSION_BC3;
+	}
+
+	size_t pixelCount = (size_t)width * height;
+	for (size_t i = 0; i < pixelCount; i++) {
+		if (rgba[i * 4 + 3] != 255) {
+			return COMPRESSION_BC3;
+		}
+	}
+	return COMPRESSION_BC1;
+}
+
+// OpenGL formats the cache entry is uploaded with
+static void glFormatsFor(Texture_Compression format, bool srgb, unsigned int& internalFormat, unsigned int& baseFormat) {
+	if (format == COMPRESSION_BC1) {
+		internalFormat = srgb ? KTX_COMPRESSED_SRGB_ALPHA_S3TC_DXT1 : KTX_COMPRESSED_RGBA_S3TC_DXT1;
+		baseFormat = srgb ? KTX_SRGB_ALPHA : KTX_RGBA;
+	} else if (format == COMPRESSION_BC3) {
+		internalFormat = srgb ? KTX_COMPRESSED_SRGB_ALPHA_S3TC_DXT5 : KTX_COMPRESSED_RGBA_S3TC_DXT5;
+		baseFormat = srgb ? KTX_SRGB_ALPHA : KTX_RGBA;
+	} else if (format == COMPRESSION_BC4) {
+		internalFormat = KTX_COMPRESSED_RED_RGTC1;
+		baseFormat = KTX_RED;
+	} else {
+		internalFormat = KTX_COMPRESSED_RG_RGTC2;
+		baseFormat = KTX_RG;
+	}
+}
+
+bool buildTextureCache(const string& sourcePath, const unsigned char* rgba, int width, int height, Texture_Usage usage, bool srgb, bool compress, double* psnr) {
+	// Mips are filtered in linear space and re-encoded, rather than averaging sRGB values. Only
+	// color is ever stored as sRGB; data maps stay linear even when asked for sRGB
+	Mip_Settings settings;
+	settings.srgb = srgb && (usage == TEXTURE_COLOR || usage == TEXTURE_CUTOUT);
+	settings.preserveAlphaCoverage = usage == TEXTURE_CUTOUT;
+	settings.wrap = usage != TEXTURE_CUTOUT; // Cutouts are clamped to avoid bleeding across the border
+	vector<vector<unsigned char>> mips = generateMipChain(rgba, width, height, settings);
+
+	KtxTexture texture;
+	texture.width = width;
+	texture.height = height;
+
+	if (!compress) {
+		texture.glType = KTX_UNSIGNED_BYTE;
+		texture.glFormat = KTX_RGBA;
+		texture.glInternalFormat = settings.srgb ? KTX_SRGB8_ALPHA8 : KTX_RGBA8;
+		texture.glBaseInternalFormat = KTX_RGBA;
+		texture.levels = mips;
+		if (psnr != nullptr) {
+			*psnr = INFINITY;
+		}
+		return writeKtx(textureCachePath(sourcePath, usage, srgb), texture);
+	}
+
+	Texture_Compression format = chooseCompression(rgba, width, height, usage);
+	glFormatsFor(format, settings.srgb, texture.glInternalFormat, texture.glBaseInternalFormat);
+	for (unsigned int level = 0; level < mips.size(); level++) {
+		texture.levels.push_back(compressImage(mips[level].data(), texture.levelWidth(level), texture.levelHeight(level), format));
+	}
+
+	if (psnr != nullptr) {
+		static const int channels[] = { 3, 4, 1, 2 };
+		vector<unsigned char> decoded = decompressImage(texture.levels[0].data(), width, height, format);
+		*psnr = computePSNR(rgba, decoded.data(), width, height, channels[format]);
+	}
+
+	return writeKtx(textureCachePath(sourcePath, usage, srgb), texture);
+}
+
+bool textureCacheIsCurrent(const string& sourcePath, Texture_Usage usage, bool srgb) {
+	return cacheFileIsCurrent(textureCachePath(sourcePath, usage, srgb), sourcePath);
+}
+
+bool cacheFileIsCurrent(const string& cachePath, const string& sourcePath) {
+	// A cache entry older than its source image is stale
+	error_code error;
+	filesystem::file_time_type cacheTime = filesystem::last_write_time(cachePath, error);
+	if (error) {
+		return false;
+	}
+	filesystem::file_time_type sourceTime = filesystem::last_write_time(sourcePath, error);
+	if (!error && sourceTime > cacheTime) {
+		cout << "Texture cache is out of date: " << cachePath << endl;
+		return false;
+	}
+	return true;
+}
+
+// Checks the driver's list of compressed formats; S3TC is an extension on some platforms
+static bool compressedFormatSupported(unsigned int internalFormat) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+	vector<GLint> formats(count);
+	if (count > 0) {
+		glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+	}
+
+	// RGTC is core since OpenGL 3.0 and doesn't have to be listed
+	if (internalFormat == KTX_COMPRESSED_RED_RGTC1 || internalFormat == KTX_COMPRESSED_RG_RGTC2) {
+		return true;
+	}
+	return find(formats.begin(), formats.end(), (GLint)internalFormat) != formats.end();
+}
+
+bool textureCacheFormatSupported(const KtxTexture& texture) {
+	return !texture.isCompressed() || compressedFormatSupported(texture.glInternalFormat);
+}
+
+unsigned int loadCachedTexture(const string& sourcePath, Texture_Usage usage, bool srgb) {
+	if (!textureCacheIsCurrent(sourcePath, usage, srgb)) {
+		return 0;
+	}
+
+	string cachePath = textureCachePath(sourcePath, usage, srgb);
+	KtxTexture texture;
+	if (!readKtx(cachePath, texture)) {
+		cout << "Texture cache failed to load at path: " << cachePath << endl;
+		return 0;
+	}
+	if (!textureCacheFormatSupported(texture)) {
+		return 0;
+	}
+
+	unsigned int textureID;
+	glGenTextures(1, &textureID);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	// Upload every stored level as is; the mips were built offline
+	for (unsigned int level = 0; level < texture.levelCount(); level++) {
+		const vector<unsigned char>& data = texture.levels[level];
+		if (texture.isCompressed()) {
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, texture.glInternalFormat, texture.levelWidth(level), texture.levelHeight(level), 0, (GLsizei)data.size(), data.data());
+		} else {
+			glTexImage2D(GL_TEXTURE_2D, level, texture.glInternalFormat, texture.levelWidth(level), texture.levelHeight(level), 0, texture.glFormat, texture.glType, data.data());
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount() - 1);
+
+	// Cutouts are clamped so their transparent borders don't pick up texels from the opposite edge
+	GLint wrap = usage == TEXTURE_CUTOUT ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return textureID;
+}
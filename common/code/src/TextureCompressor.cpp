@@ -0,0 +1,460 @@
+#include "../header/TextureCompressor.h"
+#include "../header/ParallelFor.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TEXTURE_COMPRESSOR_SSE2
+#endif
+
+using namespace std;
+
+// Color block of 16 pixels stored as separate channel arrays so 4 pixels fit one SIMD register
+struct ColorBlock {
+	float r[16];
+	float g[16];
+	float b[16];
+};
+
+// Copies the 4x4 block at (blockX, blockY) out of the image. Blocks that hang over the edge
+// of the image repeat the last row/column
+static void fetchBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, unsigned char block[16][4]) {
+	for (int y = 0; y < 4; y++) {
+		int sy = min(blockY * 4 + y, height - 1);
+		for (int x = 0; x < 4; x++) {
+			int sx = min(blockX * 4 + x, width - 1);
+			memcpy(block[y * 4 + x], &rgba[((size_t)sy * width + sx) * 4], 4);
+		}
+	}
+}
+
+// Packs/unpacks an 8-bit color to and from the 5:6:5 endpoint format
+static unsigned short packColor565(float r, float g, float b) {
+	int r5 = (int)(clamp(r, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	int g6 = (int)(clamp(g, 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+	int b5 = (int)(clamp(b, 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+	return (unsigned short)((r5 << 11) | (g6 << 5) | b5);
+}
+
+static void unpackColor565(unsigned short color, float out[3]) {
+	int r5 = (color >> 11) & 31;
+	int g6 = (color >> 5) & 63;
+	int b5 = color & 31;
+	out[0] = (float)((r5 << 3) | (r5 >> 2));
+	out[1] = (float)((g6 << 2) | (g6 >> 4));
+	out[2] = (float)((b5 << 3) | (b5 >> 2));
+}
+
+// Builds the 4-entry palette of a BC1 block in four-color mode
+static void buildPalette(unsigned short color0, unsigned short color1, float palette[4][3]) {
+	unpackColor565(color0, palette[0]);
+	unpackColor565(color1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+		palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+	}
+}
+
+// Picks the nearest palette entry for each of the 16 pixels and returns the total squared error
+static float selectIndices(const ColorBlock& block, const float palette[4][3], unsigned char indices[16]) {
+#ifdef TEXTURE_COMPRESSOR_SSE2
+	__m128 totalError = _mm_setzero_ps();
+	for (int i = 0; i < 16; i += 4) {
+		__m128 r = _mm_loadu_ps(&block.r[i]);
+		__m128 g = _mm_loadu_ps(&block.g[i]);
+		__m128 b = _mm_loadu_ps(&block.b[i]);
+
+		__m128 bestError = _mm_set1_ps(FLT_MAX);
+		__m128i bestIndex = _mm_setzero_si128();
+		for (int p = 0; p < 4; p++) {
+			__m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[p][0]));
+			__m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[p][1]));
+			__m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[p][2]));
+			__m128 error = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+
+			// Without SSE4.1 blends the index is selected with and/andnot
+			__m128i closer = _mm_castps_si128(_mm_cmplt_ps(error, bestError));
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(p)), _mm_andnot_si128(closer, bestIndex));
+			bestError = _mm_min_ps(error, bestError);
+		}
+		totalError = _mm_add_ps(totalError, bestError);
+
+		int lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, bestIndex);
+		for (int lane = 0; lane < 4; lane++) {
+			indices[i + lane] = (unsigned char)lanes[lane];
+		}
+	}
+
+	float errors[4];
+	_mm_storeu_ps(errors, totalError);
+	return errors[0] + errors[1] + errors[2] + errors[3];
+#else
+	float totalError = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float bestError = FLT_MAX;
+		for (int p = 0; p < 4; p++) {
+			float dr = block.r[i] - palette[p][0];
+			float dg = block.g[i] - palette[p][1];
+			float db = block.b[i] - palette[p][2];
+			float error = dr * dr + dg * dg + db * db;
+			if (error < bestError) {
+				bestError = error;
+				indices[i] = (unsigned char)p;
+			}
+		}
+		totalError += bestError;
+	}
+	return totalError;
+#endif
+}
+
+// Finds a pair of endpoints along the principal axis of the block's colors
+static void principalEndpoints(const ColorBlock& block, float minColor[3], float maxColor[3]) {
+	float mean[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		mean[0] += block.r[i];
+		mean[1] += block.g[i];
+		mean[2] += block.b[i];
+	}
+	for (int c = 0; c < 3; c++) {
+		mean[c] /= 16.0f;
+	}
+
+	// Covariance matrix (symmetric, so only 6 entries)
+	float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		float r = block.r[i] - mean[0];
+		float g = block.g[i] - mean[1];
+		float b = block.b[i] - mean[2];
+		cov[0] += r * r;
+		cov[1] += r * g;
+		cov[2] += r * b;
+		cov[3] += g * g;
+		cov[4] += g * b;
+		cov[5] += b * b;
+	}
+
+	// A few power iterations are plenty to find the dominant eigenvector
+	float axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (int iteration = 0; iteration < 8; iteration++) {
+		float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+		float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+		float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+		float len = max(max(fabs(x), fabs(y)), fabs(z));
+		if (len < 1e-6f) {
+			break; // Solid color block
+		}
+		axis[0] = x / len;
+		axis[1] = y / len;
+		axis[2] = z / len;
+	}
+
+	float minT = FLT_MAX, maxT = -FLT_MAX;
+	for (int i = 0; i < 16; i++) {
+		float t = (block.r[i] - mean[0]) * axis[0] + (block.g[i] - mean[1]) * axis[1] + (block.b[i] - mean[2]) * axis[2];
+		minT = min(minT, t);
+		maxT = max(maxT, t);
+	}
+
+	float axisLength2 = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	if (axisLength2 > 0.0f) {
+		minT /= axisLength2;
+		maxT /= axisLength2;
+	}
+
+	for (int c = 0; c < 3; c++) {
+		minColor[c] = mean[c] + axis[c] * minT;
+		maxColor[c] = mean[c] + axis[c] * maxT;
+	}
+}
+
+// Solves for the endpoints that minimize the squared error for a fixed set of indices
+static bool refineEndpoints(const ColorBlock& block, const unsigned char indices[16], float color0[3], float color1[3]) {
+	static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[3] = { 0.0f, 0.0f, 0.0f };
+	float bx[3] = { 0.0f, 0.0f, 0.0f };
+	for (int i = 0; i < 16; i++) {
+		float a = weights[indices[i]];
+		float b = 1.0f - a;
+		float pixel[3] = { block.r[i], block.g[i], block.b[i] };
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < 3; c++) {
+			ax[c] += a * pixel[c];
+			bx[c] += b * pixel[c];
+		}
+	}
+
+	float det = aa * bb - ab * ab;
+	if (fabs(det) < 1e-6f) {
+		return false;
+	}
+
+	for (int c = 0; c < 3; c++) {
+		color0[c] = (ax[c] * bb - bx[c] * ab) / det;
+		color1[c] = (bx[c] * aa - ax[c] * ab) / det;
+	}
+	return true;
+}
+
+// Writes the 8 byte color block, always in four-color mode so it is also valid inside BC3
+static void writeColorBlock(unsigned short color0, unsigned short color1, unsigned char indices[16], unsigned char* out) {
+	if (color0 < color1) {
+		swap(color0, color1);
+		static const unsigned char swapped[4] = { 1, 0, 3, 2 };
+		for (int i = 0; i < 16; i++) {
+			indices[i] = swapped[indices[i]];
+		}
+	} else if (color0 == color1) {
+		memset(indices, 0, 16);
+	}
+
+	unsigned int bits = 0;
+	for (int i = 0; i < 16; i++) {
+		bits |= (unsigned int)indices[i] << (2 * i);
+	}
+
+	out[0] = color0 & 0xFF;
+	out[1] = color0 >> 8;
+	out[2] = color1 & 0xFF;
+	out[3] = color1 >> 8;
+	memcpy(out + 4, &bits, 4);
+}
+
+static void encodeColorBlock(const unsigned char pixels[16][4], unsigned char* out) {
+	ColorBlock block;
+	for (int i = 0; i < 16; i++) {
+		block.r[i] = pixels[i][0];
+		block.g[i] = pixels[i][1];
+		block.b[i] = pixels[i][2];
+	}
+
+	float minColor[3], maxColor[3];
+	principalEndpoints(block, minColor, maxColor);
+
+	unsigned short bestColor0 = packColor565(maxColor[0], maxColor[1], maxColor[2]);
+	unsigned short bestColor1 = packColor565(minColor[0], minColor[1], minColor[2]);
+	float palette[4][3];
+	unsigned char bestIndices[16];
+	buildPalette(bestColor0, bestColor1, palette);
+	float bestError = selectIndices(block, palette, bestIndices);
+
+	// Least squares refinement; keep it only when it actually lowers the error
+	for (int iteration = 0; iteration < 2 && bestError > 0.0f; iteration++) {
+		float color0[3], color1[3];
+		if (!refineEndpoints(block, bestIndices, color0, color1)) {
+			break;
+		}
+
+		unsigned short refined0 = packColor565(color0[0], color0[1], color0[2]);
+		unsigned short refined1 = packColor565(color1[0], color1[1], color1[2]);
+		unsigned char indices[16];
+		buildPalette(refined0, refined1, palette);
+		float error = selectIndices(block, palette, indices);
+		if (error >= bestError) {
+			break;
+		}
+
+		bestError = error;
+		bestColor0 = refined0;
+		bestColor1 = refined1;
+		memcpy(bestIndices, indices, 16);
+	}
+
+	writeColorBlock(bestColor0, bestColor1, bestIndices, out);
+}
+
+// Encodes one channel of the block in the 8 byte BC4 layout (also the BC3 alpha block)
+static void encodeChannelBlock(const unsigned char pixels[16][4], int channel, unsigned char* out) {
+	int minValue = 255, maxValue = 0;
+	for (int i = 0; i < 16; i++) {
+		minValue = min(minValue, (int)pixels[i][channel]);
+		maxValue = max(maxValue, (int)pixels[i][channel]);
+	}
+
+	// Eight value mode: endpoint 0 is the larger one, followed by 6 interpolated values
+	int palette[8];
+	palette[0] = maxValue;
+	palette[1] = minValue;
+	for (int i = 1; i < 7; i++) {
+		palette[i + 1] = ((7 - i) * maxValue + i * minValue) / 7;
+	}
+
+	unsigned long long bits = 0;
+	if (maxValue != minValue) {
+		for (int i = 0; i < 16; i++) {
+			int value = pixels[i][channel];
+			int bestIndex = 0, bestError = 256;
+			for (int p = 0; p < 8; p++) {
+				int error = abs(value - palette[p]);
+				if (error < bestError) {
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			bits |= (unsigned long long)bestIndex << (3 * i);
+		}
+	}
+
+	out[0] = (unsigned char)maxValue;
+	out[1] = (unsigned char)minValue;
+	for (int i = 0; i < 6; i++) {
+		out[2 + i] = (unsigned char)(bits >> (8 * i));
+	}
+}
+
+static void decodeColorBlock(const unsigned char* in, unsigned char pixels[16][4]) {
+	unsigned short color0 = (unsigned short)(in[0] | (in[1] << 8));
+	unsigned short color1 = (unsigned short)(in[2] | (in[3] << 8));
+	unsigned int bits;
+	memcpy(&bits, in + 4, 4);
+
+	float palette[4][3];
+	buildPalette(color0, color1, palette);
+	if (color0 <= color1) {
+		// Three-color mode with transparent black; our encoder never writes it, but other tools do
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2.0f;
+			palette[3][c] = 0.0f;
+		}
+	}
+
+	for (int i = 0; i < 16; i++) {
+		int index = (bits >> (2 * i)) & 3;
+		for (int c = 0; c < 3; c++) {
+			pixels[i][c] = (unsigned char)(palette[index][c] + 0.5f);
+		}
+	}
+}
+
+static void decodeChannelBlock(const unsigned char* in, int channel, unsigned char pixels[16][4]) {
+	int palette[8];
+	palette[0] = in[0];
+	palette[1] = in[1];
+	if (palette[0] > palette[1]) {
+		for (int i = 1; i < 7; i++) {
+			palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7;
+		}
+	} else {
+		for (int i = 1; i < 5; i++) {
+			palette[i + 1] = ((5 - i) * palette[0] + i * palette[1]) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	unsigned long long bits = 0;
+	for (int i = 0; i < 6; i++) {
+		bits |= (unsigned long long)in[2 + i] << (8 * i);
+	}
+
+	for (int i = 0; i < 16; i++) {
+		pixels[i][channel] = (unsigned char)palette[(bits >> (3 * i)) & 7];
+	}
+}
+
+unsigned int blockSize(Texture_Compression format) {
+	return (format == COMPRESSION_BC1 || format == COMPRESSION_BC4) ? 8 : 16;
+}
+
+size_t compressedSize(int width, int height, Texture_Compression format) {
+	size_t blocksX = (width + 3) / 4;
+	size_t blocksY = (height + 3) / 4;
+	return blocksX * blocksY * blockSize(format);
+}
+
+vector<unsigned char> compressImage(const unsigned char* rgba, int width, int height, Texture_Compression format, unsigned int threadCount) {
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	unsigned int size = blockSize(format);
+	vector<unsigned char> blocks(compressedSize(width, height, format));
+
+	// Each thread owns a band of block rows, so they never write to the same memory
+	parallelFor(blocksY, [&](int rowBegin, int rowEnd) {
+		unsigned char pixels[16][4];
+		for (int by = rowBegin; by < rowEnd; by++) {
+			for (int bx = 0; bx < blocksX; bx++) {
+				unsigned char* out = &blocks[((size_t)by * blocksX + bx) * size];
+				fetchBlock(rgba, width, height, bx, by, pixels);
+
+				if (format == COMPRESSION_BC1) {
+					encodeColorBlock(pixels, out);
+				} else if (format == COMPRESSION_BC3) {
+					encodeChannelBlock(pixels, 3, out);
+					encodeColorBlock(pixels, out + 8);
+				} else if (format == COMPRESSION_BC4) {
+					encodeChannelBlock(pixels, 0, out);
+				} else {
+					encodeChannelBlock(pixels, 0, out);
+					encodeChannelBlock(pixels, 1, out + 8);
+				}
+			}
+		}
+	}, threadCount);
+
+	return blocks;
+}
+
+vector<unsigned char> decompressImage(const unsigned char* blocks, int width, int height, Texture_Compression format) {
+	int blocksX = (width + 3) / 4;
+	int blocksY = (height + 3) / 4;
+	unsigned int size = blockSize(format);
+	vector<unsigned char> rgba((size_t)width * height * 4);
+
+	for (int by = 0; by < blocksY; by++) {
+		for (int bx = 0; bx < blocksX; bx++) {
+			const unsigned char* in = &blocks[((size_t)by * blocksX + bx) * size];
+			unsigned char pixels[16][4];
+			memset(pixels, 0, sizeof(pixels));
+			for (int i = 0; i < 16; i++) {
+				pixels[i][3] = 255;
+			}
+
+			if (format == COMPRESSION_BC1) {
+				decodeColorBlock(in, pixels);
+			} else if (format == COMPRESSION_BC3) {
+				decodeChannelBlock(in, 3, pixels);
+				decodeColorBlock(in + 8, pixels);
+			} else if (format == COMPRESSION_BC4) {
+				decodeChannelBlock(in, 0, pixels);
+			} else {
+				decodeChannelBlock(in, 0, pixels);
+				decodeChannelBlock(in + 8, 1, pixels);
+			}
+
+			// Only copy the pixels that lie inside the image
+			for (int y = 0; y < 4 && by * 4 + y < height; y++) {
+				for (int x = 0; x < 4 && bx * 4 + x < width; x++) {
+					memcpy(&rgba[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], pixels[y * 4 + x], 4);
+				}
+			}
+		}
+	}
+
+	return rgba;
+}
+
+double computePSNR(const unsigned char* reference, const unsigned char* test, int width, int height, int channels) {
+	double squaredError = 0.0;
+	size_t pixelCount = (size_t)width * height;
+	for (size_t i = 0; i < pixelCount; i++) {
+		for (int c = 0; c < channels; c++) {
+			double difference = (double)reference[i * 4 + c] - (double)test[i * 4 + c];
+			squaredError += difference * difference;
+		}
+	}
+
+	double meanSquaredError = squaredError / ((double)pixelCount * channels);
+	if (meanSquaredError == 0.0) {
+		return INFINITY; // Identical images
+	}
+	return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
@@ -0,0 +1,245 @@
+#include <glad/glad.h>
+
+#include "../header/TextureLoader.h"
+#include "../header/MipGenerator.h"
+#include "../header/ParallelFor.h"
+#include "../header/TextureStreamer.h"
+#include "../header/TextureUploader.h"
+#include "../header/stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <map>
+
+using namespace std;
+
+// Core since OpenGL 4.6, and the EXT/ARB extensions use the same values
+#ifndef GL_TEXTURE_MAX_ANISOTROPY
+#define GL_TEXTURE_MAX_ANISOTROPY 0x84FE
+#define GL_MAX_TEXTURE_MAX_ANISOTROPY 0x84FF
+#endif
+
+static const unsigned int usageCount = TEXTURE_CUTOUT + 1;
+
+// Usage of every texture created here, so bindTexture can pick its sampler
+static map<unsigned int, Texture_Usage> textureUsages;
+
+// Usage of textures still streaming in through a TextureUploader. They move to textureUsages once
+// their mips exist; until then the shared sampler would read levels that hold no pixels yet
+static map<unsigned int, Texture_Usage> uploadingUsages;
+static unsigned int samplers[usageCount] = {};
+static float anisotropy = 16.0f;
+
+void Image_Deleter::operator()(unsigned char* pixels) const {
+	stbi_image_free(pixels);
+}
+
+static bool extensionSupported(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension != NULL && strcmp(extension, name) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// glTexStorage2D only exists when the loader was generated for OpenGL 4.2 or the extension
+static bool textureStorageSupported() {
+#ifdef GL_VERSION_4_2
+	if (GLAD_GL_VERSION_4_2) {
+		return true;
+	}
+#endif
+#ifdef GL_ARB_texture_storage
+	if (GLAD_GL_ARB_texture_storage) {
+		return true;
+	}
+#endif
+	return false;
+}
+
+static float maxAnisotropy() {
+	static const float supported = []() {
+		if (!extensionSupported("GL_EXT_texture_filter_anisotropic") && !extensionSupported("GL_ARB_texture_filter_anisotropic")) {
+			return 1.0f;
+		}
+		GLfloat value = 1.0f;
+		glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY, &value);
+		return value;
+	}();
+	return supported;
+}
+
+static void applyAnisotropy(unsigned int sampler) {
+	if (maxAnisotropy() > 1.0f) {
+		glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY, clamp(anisotropy, 1.0f, maxAnisotropy()));
+	}
+}
+
+unsigned int textureSampler(Texture_Usage usage) {
+	if (samplers[usage] == 0) {
+		GLint wrap = usage == TEXTURE_CUTOUT ? GL_CLAMP_TO_EDGE : GL_REPEAT;
+		glGenSamplers(1, &samplers[usage]);
+		glSamplerParameteri(samplers[usage], GL_TEXTURE_WRAP_S, wrap);
+		glSamplerParameteri(samplers[usage], GL_TEXTURE_WRAP_T, wrap);
+		glSamplerParameteri(samplers[usage], GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glSamplerParameteri(samplers[usage], GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		applyAnisotropy(samplers[usage]);
+	}
+	return samplers[usage];
+}
+
+void setTextureAnisotropy(float value) {
+	anisotropy = value;
+	for (unsigned int i = 0; i < usageCount; i++) {
+		if (samplers[i] != 0) {
+			applyAnisotropy(samplers[i]);
+		}
+	}
+}
+
+void bindTexture(unsigned int unit, unsigned int texture) {
+	map<unsigned int, Texture_Usage>::iterator it = textureUsages.find(texture);
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glBindSampler(unit, it != textureUsages.end() ? textureSampler(it->second) : 0);
+}
+
+void finishTextureUpload(unsigned int texture) {
+	map<unsigned int, Texture_Usage>::iterator it = uploadingUsages.find(texture);
+	if (it != uploadingUsages.end()) {
+		textureUsages[texture] = it->second;
+		uploadingUsages.erase(it);
+	}
+}
+
+void allocateTextureStorage(int width, int height, int levels, unsigned int internalFormat) {
+#if defined(GL_VERSION_4_2) || defined(GL_ARB_texture_storage)
+	if (textureStorageSupported()) {
+		glTexStorage2D(GL_TEXTURE_2D, levels, internalFormat, width, height);
+		return;
+	}
+#endif
+
+	// Mutable fallback; with every level specified the texture is complete from the start
+	for (int level = 0; level < levels; level++) {
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormat, max(1, width >> level), max(1, height >> level), 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+bool decodeImage(const string& path, Texture_Image& image) {
+	image.pixels.reset(stbi_load(path.c_str(), &image.width, &image.height, &image.nrComponents, 0));
+	return image.pixels != nullptr;
+}
+
+// Tries the texture cache first, streamed or uploaded whole. Returns 0 if there is no usable entry
+static unsigned int loadFromCache(const string& path, const Texture_Options& options) {
+	if (!options.useCache) {
+		return 0;
+	}
+	if (options.streamer != nullptr) {
+		unsigned int texture = options.streamer->load(path, options.usage, options.srgb);
+		if (texture != 0) {
+			return texture;
+		}
+	}
+	return loadCachedTexture(path, options.usage, options.srgb);
+}
+
+unsigned int createTexture(const Texture_Image& image, const Texture_Options& options) {
+	bool srgb = options.srgb && (options.usage == TEXTURE_COLOR || options.usage == TEXTURE_CUTOUT);
+
+	if (options.uploader != nullptr) {
+		unsigned int texture = options.uploader->queueTexture(image.pixels.get(), image.width, image.height, image.nrComponents, srgb);
+		uploadingUsages[texture] = options.usage;
+		return texture;
+	}
+
+	GLenum internalFormat, format;
+	if (image.nrComponents == 1) {
+		internalFormat = GL_R8;
+		format = GL_RED;
+	} else if (image.nrComponents == 2) {
+		internalFormat = GL_RG8;
+		format = GL_RG;
+	} else if (image.nrComponents == 3) {
+		internalFormat = srgb ? GL_SRGB8 : GL_RGB8;
+		format = GL_RGB;
+	} else {
+		internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		format = GL_RGBA;
+	}
+
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D, texture);
+	allocateTextureStorage(image.width, image.height, mipLevelCount(image.width, image.height), internalFormat);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // RGB rows of odd widths aren't 4 byte aligned
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, format, GL_UNSIGNED_BYTE, image.pixels.get());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glGenerateMipmap(GL_TEXTURE_2D);
+
+	textureUsages[texture] = options.usage;
+	return texture;
+}
+
+unsigned int loadTexture(const string& path, const Texture_Options& options) {
+	unsigned int texture = loadFromCache(path, options);
+	if (texture != 0) {
+		textureUsages[texture] = options.usage;
+		return texture;
+	}
+
+	Texture_Image image;
+	if (!decodeImage(path, image)) {
+		cout << "Texture failed to load at path: " << path << endl;
+		glGenTextures(1, &texture);
+		return texture;
+	}
+	return createTexture(image, options);
+}
+
+unsigned int loadTexture(const string& path, Texture_Usage usage, bool srgb) {
+	Texture_Options options;
+	options.usage = usage;
+	options.srgb = srgb;
+	return loadTexture(path, options);
+}
+
+vector<unsigned int> loadTextures(const vector<string>& paths, const vector<Texture_Options>& options) {
+	// Cache entries are uploaded as they are; only the rest of the images need decoding
+	vector<unsigned int> textures(paths.size(), 0);
+	vector<int> decodeIndices;
+	for (unsigned int i = 0; i < paths.size(); i++) {
+		textures[i] = loadFromCache(paths[i], options[i]);
+		if (textures[i] != 0) {
+			textureUsages[textures[i]] = options[i].usage;
+		} else {
+			decodeIndices.push_back(i);
+		}
+	}
+
+	vector<Texture_Image> images(decodeIndices.size());
+	parallelFor((int)decodeIndices.size(), [&](int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			decodeImage(paths[decodeIndices[i]], images[i]);
+		}
+	}, (unsigned int)decodeIndices.size());
+
+	for (unsigned int i = 0; i < decodeIndices.size(); i++) {
+		int index = decodeIndices[i];
+		if (images[i].pixels != nullptr) {
+			textures[index] = createTexture(images[i], options[index]);
+		} else {
+			cout << "Texture failed to load at path: " << paths[index] << endl;
+			glGenTextures(1, &textures[index]);
+		}
+	}
+	return textures;
+}
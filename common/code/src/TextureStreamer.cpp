@@ -0,0 +1,181 @@
+#include "../header/TextureStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+TextureStreamer::TextureStreamer(size_t budgetBytes, int residentSize, unsigned int levelsPerFrame)
+	: budgetBytes(budgetBytes), residentSize(residentSize), levelsPerFrame(levelsPerFrame), usedBytes(0) {
+}
+
+unsigned int TextureStreamer::load(const string& sourcePath, Texture_Usage usage, bool srgb) {
+	if (!textureCacheIsCurrent(sourcePath, usage, srgb)) {
+		return 0;
+	}
+
+	StreamedTexture texture;
+	texture.cachePath = textureCachePath(sourcePath, usage, srgb);
+	if (!readKtxIndex(texture.cachePath, texture.info, texture.levelOffsets, texture.levelSizes) || !textureCacheFormatSupported(texture.info)) {
+		return 0;
+	}
+
+	// Only the levels that fit in residentSize are loaded up front
+	int levelCount = (int)texture.info.levelCount();
+	int firstLevel = 0;
+	while (firstLevel < levelCount - 1 && max(texture.info.levelWidth(firstLevel), texture.info.levelHeight(firstLevel)) > residentSize) {
+		firstLevel++;
+	}
+	texture.coarsestStreamedLevel = firstLevel;
+	texture.residentLevel = levelCount;
+	texture.requestedLevel = firstLevel;
+	texture.pendingLevel = -1;
+
+	unsigned int id;
+	glGenTextures(1, &id);
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, usage == TEXTURE_CUTOUT ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, usage == TEXTURE_CUTOUT ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	// Upload from the smallest level up, so the base level is valid after every step. A level
+	// that can't be read gives up on the cache entry, so the caller falls back to the source image
+	// instead of getting a texture without the levels the streamer counts on being resident
+	size_t uploadedBytes = 0;
+	for (int level = levelCount - 1; level >= firstLevel; level--) {
+		vector<unsigned char> data;
+		if (!readKtxLevel(texture.cachePath, texture.levelOffsets[level], texture.levelSizes[level], texture.info.faces, data)) {
+			cout << "Texture cache failed to load at path: " << texture.cachePath << endl;
+			glDeleteTextures(1, &id);
+			usedBytes -= uploadedBytes;
+			return 0;
+		}
+		uploadLevel(id, texture, level, data);
+		uploadedBytes += data.size();
+	}
+
+	textures[id] = move(texture);
+	return id;
+}
+
+void TextureStreamer::recordUsage(unsigned int texture, float pixels) {
+	map<unsigned int, StreamedTexture>::iterator it = textures.find(texture);
+	if (it == textures.end()) {
+		return;
+	}
+
+	// One texel per pixel is enough; every halving of the footprint allows one coarser level
+	StreamedTexture& streamed = it->second;
+	float size = (float)max(streamed.info.width, streamed.info.height);
+	int level = (int)floor(log2(size / max(pixels, 1.0f)));
+	level = clamp(level, 0, streamed.coarsestStreamedLevel);
+	streamed.requestedLevel = min(streamed.requestedLevel, level);
+}
+
+void TextureStreamer::update() {
+	unsigned int uploads = 0;
+	vector<pair<int, unsigned int>> wanted;
+
+	for (map<unsigned int, StreamedTexture>::iterator it = textures.begin(); it != textures.end(); it++) {
+		unsigned int id = it->first;
+		StreamedTexture& texture = it->second;
+
+		// Upload reads that finished, if the level is still the next one needed and fits the budget.
+		// Once this frame's uploads are used up, finished reads wait for the next frame instead of
+		// being thrown away and read again
+		if (texture.pendingLevel >= 0 && uploads < levelsPerFrame && texture.pendingData.wait_for(chrono::seconds(0)) == future_status::ready) {
+			vector<unsigned char> data = texture.pendingData.get();
+			int level = texture.pendingLevel;
+			texture.pendingLevel = -1;
+
+			bool stillNeeded = level == texture.residentLevel - 1 && texture.requestedLevel <= level;
+			if (stillNeeded && usedBytes + data.size() <= budgetBytes && !data.empty()) {
+				uploadLevel(id, texture, level, data);
+				uploads++;
+			}
+		}
+
+		// Levels finer than any draw asked for are released one per frame
+		if (texture.pendingLevel < 0 && texture.requestedLevel > texture.residentLevel) {
+			dropLevel(id, texture);
+		}
+
+		if (texture.pendingLevel < 0 && texture.requestedLevel < texture.residentLevel) {
+			wanted.push_back(make_pair(texture.residentLevel - texture.requestedLevel, id));
+		}
+	}
+
+	// Start reading the next level for the textures furthest from what they need
+	sort(wanted.begin(), wanted.end(), greater<pair<int, unsigned int>>());
+	for (unsigned int i = 0; i < wanted.size() && i < levelsPerFrame; i++) {
+		StreamedTexture& texture = textures[wanted[i].second];
+		int level = texture.residentLevel - 1;
+		if (usedBytes + texture.levelSizes[level] > budgetBytes) {
+			continue;
+		}
+
+		string path = texture.cachePath;
+		size_t offset = texture.levelOffsets[level];
+		size_t size = texture.levelSizes[level];
+		unsigned int faces = texture.info.faces;
+		texture.pendingLevel = level;
+		texture.pendingData = async(launch::async, [path, offset, size, faces]() {
+			vector<unsigned char> data;
+			if (!readKtxLevel(path, offset, size, faces, data)) {
+				data.clear();
+			}
+			return data;
+		});
+	}
+
+	// Draws have to ask again next frame; textures nobody draws drift back to their small levels
+	for (map<unsigned int, StreamedTexture>::iterator it = textures.begin(); it != textures.end(); it++) {
+		it->second.requestedLevel = it->second.coarsestStreamedLevel;
+	}
+}
+
+size_t TextureStreamer::residentBytes() const {
+	return usedBytes;
+}
+
+float TextureStreamer::screenFootprint(const vec3& viewCenter, float radius, float fovY, int viewportHeight) {
+	float distance = length(viewCenter);
+	if (distance <= radius) {
+		return (float)viewportHeight * 4.0f; // The camera is inside the bounds
+	}
+	return radius / (distance * tan(fovY * 0.5f)) * viewportHeight;
+}
+
+void TextureStreamer::uploadLevel(unsigned int id, StreamedTexture& texture, int level, const vector<unsigned char>& data) {
+	const KtxTexture& info = texture.info;
+	glBindTexture(GL_TEXTURE_2D, id);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (info.isCompressed()) {
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, info.glInternalFormat, info.levelWidth(level), info.levelHeight(level), 0, (GLsizei)data.size(), data.data());
+	} else {
+		glTexImage2D(GL_TEXTURE_2D, level, info.glInternalFormat, info.levelWidth(level), info.levelHeight(level), 0, info.glFormat, info.glType, data.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// The new level only becomes visible once the base level moves down to it
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+	texture.residentLevel = level;
+	usedBytes += data.size();
+}
+
+void TextureStreamer::dropLevel(unsigned int id, StreamedTexture& texture) {
+	int level = texture.residentLevel;
+	glBindTexture(GL_TEXTURE_2D, id);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level + 1);
+
+	// Respecifying the level with no size lets the driver release its memory. It lies outside the
+	// base/max range now, so it doesn't affect the completeness of the texture
+	glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, 0, 0, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	texture.residentLevel = level + 1;
+	usedBytes -= texture.levelSizes[level];
+}
@@ -0,0 +1,214 @@
+#include "../header/TextureUploader.h"
+#include "../header/MipGenerator.h"
+#include "../header/TextureLoader.h"
+
+#include <algorithm>
+#include <cstring>
+
+// The RGB to RGBA shuffle needs SSSE3. Builds that target it already skip the check; on other
+// x86-64 builds, including MSVC's default, which never defines __SSSE3__, the shuffle is compiled
+// for SSSE3 on its own and only runs when CPUID reports it
+#if defined(__SSSE3__) || defined(__AVX__)
+#include <tmmintrin.h>
+#define TEXTURE_UPLOADER_SSSE3
+#define TEXTURE_UPLOADER_SSSE3_TARGET
+static bool ssse3Supported() {
+	return true;
+}
+#elif defined(_M_X64) || defined(__x86_64__)
+#include <tmmintrin.h>
+#define TEXTURE_UPLOADER_SSSE3
+#ifdef _MSC_VER
+#include <intrin.h>
+#define TEXTURE_UPLOADER_SSSE3_TARGET
+static bool ssse3Supported() {
+	int info[4];
+	__cpuid(info, 1);
+	return (info[2] & (1 << 9)) != 0;
+}
+#else
+#define TEXTURE_UPLOADER_SSSE3_TARGET __attribute__((target("ssse3")))
+static bool ssse3Supported() {
+	return __builtin_cpu_supports("ssse3");
+}
+#endif
+#endif
+
+using namespace std;
+
+#ifdef TEXTURE_UPLOADER_SSSE3
+// Expands as many pixels as the shuffle can and returns how many. One shuffle moves 4 RGB pixels
+// (12 bytes) into their RGBA slots. A load reads 16 bytes, so stop while at least 6 pixels are
+// left to stay inside the source
+TEXTURE_UPLOADER_SSSE3_TARGET static size_t expandRGBToRGBASSSE3(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	size_t i = 0;
+	for (; i + 6 <= pixelCount; i += 4) {
+		__m128i source = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+		__m128i expanded = _mm_or_si128(_mm_shuffle_epi8(source, shuffle), alpha);
+		_mm_storeu_si128((__m128i*)(rgba + i * 4), expanded);
+	}
+	return i;
+}
+#endif
+
+// Expands tightly packed RGB pixels to RGBA with an opaque alpha
+static void expandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, size_t pixelCount) {
+	size_t i = 0;
+
+#ifdef TEXTURE_UPLOADER_SSSE3
+	static const bool ssse3 = ssse3Supported();
+	if (ssse3) {
+		i = expandRGBToRGBASSSE3(rgb, rgba, pixelCount);
+	}
+#endif
+
+	for (; i < pixelCount; i++) {
+		rgba[i * 4 + 0] = rgb[i * 3 + 0];
+		rgba[i * 4 + 1] = rgb[i * 3 + 1];
+		rgba[i * 4 + 2] = rgb[i * 3 + 2];
+		rgba[i * 4 + 3] = 255;
+	}
+}
+
+TextureUploader::TextureUploader(unsigned int ringSize, unsigned int slotBytes, unsigned int frameBudget)
+	: nextSlot(0), slotBytes(slotBytes), frameBudget(frameBudget), stagedLastFrame(0) {
+	slots.resize(max(1u, ringSize));
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		glGenBuffers(1, &slots[i].buffer);
+		slots[i].fence = 0;
+	}
+}
+
+TextureUploader::~TextureUploader() {
+	for (unsigned int i = 0; i < slots.size(); i++) {
+		if (slots[i].fence != 0) {
+			glDeleteSync(slots[i].fence);
+		}
+		glDeleteBuffers(1, &slots[i].buffer);
+	}
+}
+
+unsigned int TextureUploader::queueTexture(const unsigned char* pixels, int width, int height, int nrComponents, bool srgb, bool generateMipmaps) {
+	UploadJob job;
+	job.width = width;
+	job.height = height;
+	job.nrComponents = nrComponents;
+	job.generateMipmaps = generateMipmaps;
+	job.nextRow = 0;
+	job.pixels.assign(pixels, pixels + (size_t)width * height * nrComponents);
+
+	// Allocate the storage now, so the texture can be bound while its pixels are in flight
+	GLenum internalFormat;
+	if (nrComponents == 1) {
+		internalFormat = GL_R8;
+		job.format = GL_RED;
+	} else if (nrComponents == 2) {
+		internalFormat = GL_RG8;
+		job.format = GL_RG;
+	} else {
+		internalFormat = srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		job.format = GL_RGBA;
+	}
+
+	glGenTextures(1, &job.texture);
+	glBindTexture(GL_TEXTURE_2D, job.texture);
+	allocateTextureStorage(width, height, generateMipmaps ? mipLevelCount(width, height) : 1, internalFormat);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+	// The smaller levels hold no pixels until the mips are generated, so only sample the top one
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	unsigned int texture = job.texture;
+	jobs.push_back(move(job));
+	return texture;
+}
+
+void TextureUploader::update() {
+	stagedLastFrame = 0;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	while (!jobs.empty() && stagedLastFrame < frameBudget) {
+		// The slot is still being read by an earlier copy; try again next frame rather than wait
+		StagingSlot& slot = slots[nextSlot];
+		if (slot.fence != 0) {
+			GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+			if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+				break;
+			}
+			glDeleteSync(slot.fence);
+			slot.fence = 0;
+		}
+
+		UploadJob& job = jobs.front();
+		size_t rowBytes = stagedRowBytes(job);
+		size_t remainingBudget = frameBudget - stagedLastFrame;
+		int rowCount = (int)max((size_t)1, min((size_t)slotBytes, remainingBudget) / rowBytes);
+		rowCount = min(rowCount, job.height - job.nextRow);
+		size_t size = rowBytes * rowCount;
+
+		// Orphan the previous storage and write the rows straight into the new one
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.buffer);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+		unsigned char* destination = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (destination != NULL) {
+			stageRows(job, job.nextRow, rowCount, destination);
+		}
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// The data pointer is an offset into the bound unpack buffer
+		glBindTexture(GL_TEXTURE_2D, job.texture);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job.nextRow, job.width, rowCount, job.format, GL_UNSIGNED_BYTE, (void*)0);
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+		nextSlot = (nextSlot + 1) % slots.size();
+		stagedLastFrame += size;
+		job.nextRow += rowCount;
+
+		if (job.nextRow == job.height) {
+			if (job.generateMipmaps) {
+				glGenerateMipmap(GL_TEXTURE_2D);
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+			}
+			finishTextureUpload(job.texture);
+			jobs.pop_front();
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+bool TextureUploader::isIdle() const {
+	return jobs.empty();
+}
+
+size_t TextureUploader::pendingBytes() const {
+	size_t bytes = 0;
+	for (unsigned int i = 0; i < jobs.size(); i++) {
+		bytes += stagedRowBytes(jobs[i]) * (jobs[i].height - jobs[i].nextRow);
+	}
+	return bytes;
+}
+
+size_t TextureUploader::bytesLastFrame() const {
+	return stagedLastFrame;
+}
+
+size_t TextureUploader::stagedRowBytes(const UploadJob& job) {
+	int stagedComponents = job.nrComponents == 3 ? 4 : job.nrComponents;
+	return (size_t)job.width * stagedComponents;
+}
+
+void TextureUploader::stageRows(const UploadJob& job, int firstRow, int rowCount, unsigned char* destination) {
+	const unsigned char* source = &job.pixels[(size_t)firstRow * job.width * job.nrComponents];
+	size_t pixelCount = (size_t)job.width * rowCount;
+
+	if (job.nrComponents == 3) {
+		expandRGBToRGBA(source, destination, pixelCount);
+	} else {
+		memcpy(destination, source, pixelCount * job.nrComponents);
+	}
+}
@@ -0,0 +1,119 @@
+#include "../header/TransparentSorter.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+TransparentSorter::TransparentSorter() : hasOrder(false), path(RADIX_SORT) {
+}
+
+const vector<unsigned int>& TransparentSorter::sortBackToFront(const float* depths, unsigned int count) {
+	// Buffers only ever grow
+	if (keys.size() < count) {
+		keys.resize(count);
+		scratch.resize(count);
+	}
+
+	bool coherent = hasOrder && order.size() == count;
+	if (coherent) {
+		for (unsigned int i = 0; i < count; i++) {
+			keys[i] = makeKey(depths[order[i]], order[i]);
+		}
+
+		// Worth it while objects only move a few places on average; past that the radix sort wins
+		coherent = insertionSort(count, count);
+	} else {
+		for (unsigned int i = 0; i < count; i++) {
+			keys[i] = makeKey(depths[i], i);
+		}
+	}
+	if (!coherent) {
+		radixSort(count);
+	}
+	path = coherent ? COHERENT_SORT : RADIX_SORT;
+
+	order.resize(count);
+	for (unsigned int i = 0; i < count; i++) {
+		order[i] = (unsigned int)(keys[i] & 0xFFFFFFFFu);
+	}
+	hasOrder = true;
+	return order;
+}
+
+void TransparentSorter::reset() {
+	hasOrder = false;
+}
+
+Sort_Path TransparentSorter::lastPath() const {
+	return path;
+}
+
+uint64_t TransparentSorter::makeKey(float depth, unsigned int index) {
+	// Positive floats already sort as integers; negative ones sort reversed, so all their bits
+	// flip, and the sign bit flips on positive ones to put them above
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+
+	// Inverted so the farthest object gets the smallest key
+	return (uint64_t)~bits << 32 | index;
+}
+
+bool TransparentSorter::insertionSort(unsigned int count, size_t maxMoves) {
+	size_t moves = 0;
+	for (unsigned int i = 1; i < count; i++) {
+		uint64_t key = keys[i];
+		unsigned int j = i;
+		while (j > 0 && keys[j - 1] > key) {
+			keys[j] = keys[j - 1];
+			j--;
+
+			// Give up, leaving the keys shuffled but complete for the radix sort
+			if (++moves > maxMoves) {
+				keys[j] = key;
+				return false;
+			}
+		}
+		keys[j] = key;
+	}
+	return true;
+}
+
+void TransparentSorter::radixSort(unsigned int count) {
+	// Histograms of all eight byte digits in one pass over the keys
+	size_t histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (unsigned int i = 0; i < count; i++) {
+		uint64_t key = keys[i];
+		for (unsigned int digit = 0; digit < 8; digit++) {
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+	}
+
+	uint64_t* source = keys.data();
+	uint64_t* target = scratch.data();
+	for (unsigned int digit = 0; digit < 8 && count > 0; digit++) {
+		// A digit every key shares, like the high bytes of small indices, doesn't reorder anything
+		size_t* histogram = histograms[digit];
+		unsigned int shift = digit * 8;
+		if (histogram[(source[0] >> shift) & 0xFF] == count) {
+			continue;
+		}
+
+		size_t offset = 0;
+		for (unsigned int bucket = 0; bucket < 256; bucket++) {
+			size_t bucketCount = histogram[bucket];
+			histogram[bucket] = offset;
+			offset += bucketCount;
+		}
+		for (unsigned int i = 0; i < count; i++) {
+			target[histogram[(source[i] >> shift) & 0xFF]++] = source[i];
+		}
+		swap(source, target);
+	}
+
+	if (source != keys.data()) {
+		memcpy(keys.data(), source, count * sizeof(uint64_t));
+	}
+}
@@ -0,0 +1,81 @@
+// Offline texture compressor. Fills the texture cache for the given images so the demos can
+// upload them with glCompressedTexImage2D, and reports the PSNR of each result. Mip levels are
+// generated here as well, so the demos never call glGenerateMipmap for cached textures. Runs
+// entirely on the CPU, no OpenGL context is created.
+//
+// Usage: texture_compress [--flip] [--srgb] [--uncompressed] [--color | --normal | --height | --cutout] image...
+// The flags apply to every image that follows them. Use --flip for demos that call
+// stbi_set_flip_vertically_on_load(true), as the cache stores the image in upload order.
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../code/header/stb_image.h"
+#include "../code/header/TextureCache.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		cout << "Usage: texture_compress [--flip] [--srgb] [--uncompressed] [--color | --normal | --height | --cutout] image..." << endl;
+		return 1;
+	}
+
+	Texture_Usage usage = TEXTURE_COLOR;
+	bool srgb = false;
+	bool compress = true;
+	int failures = 0;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--flip") == 0) {
+			stbi_set_flip_vertically_on_load(true);
+			continue;
+		} else if (strcmp(argv[i], "--srgb") == 0) {
+			srgb = true;
+			continue;
+		} else if (strcmp(argv[i], "--uncompressed") == 0) {
+			compress = false;
+			continue;
+		} else if (strcmp(argv[i], "--color") == 0) {
+			usage = TEXTURE_COLOR;
+			continue;
+		} else if (strcmp(argv[i], "--normal") == 0) {
+			usage = TEXTURE_NORMAL;
+			continue;
+		} else if (strcmp(argv[i], "--height") == 0) {
+			usage = TEXTURE_HEIGHT;
+			continue;
+		} else if (strcmp(argv[i], "--cutout") == 0) {
+			usage = TEXTURE_CUTOUT;
+			continue;
+		}
+
+		// Always decode to RGBA so every format can be built from the same layout
+		int width, height, nrComponents;
+		unsigned char* data = stbi_load(argv[i], &width, &height, &nrComponents, 4);
+		if (!data) {
+			cout << "Texture failed to load at path: " << argv[i] << endl;
+			failures++;
+			continue;
+		}
+
+		double psnr = 0.0;
+		auto start = chrono::high_resolution_clock::now();
+		bool written = buildTextureCache(argv[i], data, width, height, usage, srgb, compress, &psnr);
+		auto end = chrono::high_resolution_clock::now();
+		stbi_image_free(data);
+
+		if (!written) {
+			cout << "Failed to write " << textureCachePath(argv[i], usage, srgb) << endl;
+			failures++;
+			continue;
+		}
+
+		cout << textureCachePath(argv[i], usage, srgb) << ": " << width << "x" << height << ", PSNR " << psnr << " dB, "
+			<< chrono::duration<double, milli>(end - start).count() << " ms" << endl;
+	}
+
+	return failures == 0 ? 0 : 1;
+}
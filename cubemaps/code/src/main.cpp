@@ -9,8 +9,9 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
 #include "Camera.h"
+#include "../../../common/code/header/CubemapLoader.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 
 using namespace std;
@@ -20,8 +21,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(const char* path);
-unsigned int loadCubemap(vector<string> faces);
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
@@ -75,6 +74,9 @@ int main() {
     // Enable depth testing and blending to allow proper drawing
     glEnable(GL_DEPTH_TEST);
 
+    // Filter across cubemap face edges, so the seams of the skybox don't show
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
 
     // Build and compile shader programs
     Shader shader("cubemaps.vs", "cubemaps.fs");
@@ -221,7 +223,13 @@ int main() {
         "back.jpg",
     };
 
-    unsigned int cubemapTexture = loadCubemap(faces);
+    // Set to an equirectangular .hdr panorama to use it for the skybox instead of the six faces;
+    // it's converted to a cubemap once and cached next to the panorama
+    string skyboxPanorama = "";
+
+    double skyboxStart = glfwGetTime();
+    unsigned int cubemapTexture = skyboxPanorama.empty() ? loadCubemap(faces) : loadEquirectangularCubemap(skyboxPanorama);
+    cout << "Skybox loaded in " << (glfwGetTime() - skyboxStart) * 1000.0 << " ms" << endl;
 
     shader.use();
     shader.setInt("texture1", 0);
@@ -257,8 +265,7 @@ int main() {
 
         // Draw cubes
         glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        bindTexture(0, cubeTexture);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
         // Draw skybox last
@@ -271,6 +278,7 @@ int main() {
         // Skybox cube
         glBindVertexArray(skyboxVAO);
         glActiveTexture(GL_TEXTURE0);
+        glBindSampler(0, 0); // The cubes' sampler would ask for mips the skybox doesn't have
         glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapTexture);
         glDrawArrays(GL_TRIANGLES, 0, 36);
         glBindVertexArray(0);
@@ -332,70 +340,5 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-
-// Utility function for loading a 2D texture from a file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-unsigned int loadCubemap(vector<string> faces) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-    glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
-
-    int width, height, nrChannels;
-    for (unsigned int i = 0; i < faces.size(); i++) {
-        unsigned char* data = stbi_load(faces[i].c_str(), &width, &height, &nrChannels, 0);
-        
-        if (data) {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-            stbi_image_free(data);
-        } else {
-            cout << "Cubemap texxture failed to load at path: " << faces[i] << endl;
-            stbi_image_free(data);
-        }
-    }
-
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-
-    return textureID;
-}
-
 */
 
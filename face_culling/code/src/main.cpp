@@ -8,8 +8,8 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
 #include "Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 using namespace std;
 using namespace glm;
@@ -18,7 +18,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(const char* path);
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
@@ -270,8 +269,7 @@ int main() {
         // Draw cubes
         glEnable(GL_CULL_FACE);
         glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        bindTexture(0, cubeTexture);
 
         // Set up model matrix
         model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
@@ -291,7 +289,7 @@ int main() {
         // Draw the floor
         glDisable(GL_CULL_FACE);
         glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        bindTexture(0, floorTexture);
 
         // Set up model matrix
         shader.setMat4("model", mat4(1.0f));
@@ -302,7 +300,7 @@ int main() {
         // Draw windows
         glDisable(GL_CULL_FACE);
         glBindVertexArray(transparentVAO);
-        glBindTexture(GL_TEXTURE_2D, transparentTexture);
+        bindTexture(0, transparentTexture);
 
         for (map<float, vec3>::reverse_iterator it = sorted.rbegin(); it != sorted.rend(); ++it) {
             model = mat4(1.0f);
@@ -375,41 +373,4 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
-}
-
-
-// Utility function for loading a 2D texture from a file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
 }
\ No newline at end of file
@@ -6,10 +6,14 @@
 
 #include <map>
 #include <iostream>
+#include <algorithm>
 
 #include "Shader.h"
-#include "stb_image.h"
 #include "Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/GaussianBlur.h"
+#include "../../../common/code/header/PostChain.h"
+#include "../../../common/code/header/GpuTimer.h"
 
 
 using namespace std;
@@ -19,12 +23,27 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(const char* path);
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// Blur the scene before the kernel effect; blurring ahead of the edge-detection kernel makes it a
+// Laplacian of Gaussian, which picks up real edges instead of texture noise
+bool blurScene = true;
+bool blurKeyPressed = false;
+float blurSigma = 2.0f;             // In screen pixels
+unsigned int blurDownscale = 1;     // Blur at full, half or quarter resolution
+bool downscaleKeyPressed = false;
+
+// Run the scene through a chain of five effects instead: exposure, blur, edges, invert and
+// grayscale. Fused it compiles to three passes, unfused to one per effect as separate shaders
+bool postChain = false;
+bool chainKeyPressed = false;
+bool fuseChain = true;
+bool fuseKeyPressed = false;
+float exposure = 1.5f;
+
 // Camera set-up
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2;
@@ -262,6 +281,31 @@ int main() {
     // Go back to default framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // Separable Gaussian with weights generated for blurSigma
+    GaussianBlur sceneBlur(SCR_WIDTH, SCR_HEIGHT, blurSigma, blurDownscale, GL_RGBA8);
+
+    // The effects of hdr.fs, screenKernel.fs, screen.fs and post.fs in one chain, with a 3x3 blur
+    // ahead of the edges. The exposure runs on every tap of the horizontal blur, the vertical blur
+    // gets a pass of its own and invert and grayscale run on the result of the edge kernel
+    PostChain chain(SCR_WIDTH, SCR_HEIGHT);
+    chain.addPointEffect("exposure", "        color = vec3(1.0) - exp(-color * exposure);", "uniform float exposure;");
+    chain.addKernelEffect("blur", {
+        1.0f / 16, 2.0f / 16, 1.0f / 16,
+        2.0f / 16, 4.0f / 16, 2.0f / 16,
+        1.0f / 16, 2.0f / 16, 1.0f / 16 });
+    chain.addKernelEffect("edges", {
+        1.0f,  1.0f, 1.0f,
+        1.0f, -8.0f, 1.0f,
+        1.0f,  1.0f, 1.0f });
+    chain.addPointEffect("invert", "        color = vec3(1.0) - color;");
+    chain.addPointEffect("grayscale", "        color = vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));");
+    chain.setFloat("exposure", exposure);
+    chain.compile(fuseChain);
+    bool chainFused = fuseChain;
+
+    // GPU time of the chain, unfused and fused
+    GpuTimer chainTimers[2];
+
     // Draw wireframe
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
 
@@ -295,8 +339,7 @@ int main() {
 
         // Draw cubes
         glBindVertexArray(cubeVAO);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        bindTexture(0, cubeTexture);
 
         // Set up model matrix
         model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
@@ -315,7 +358,7 @@ int main() {
 
         // Draw the floor
         glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        bindTexture(0, floorTexture);
 
         // Set up model matrix
         shader.setMat4("model", mat4(1.0f));
@@ -326,20 +369,45 @@ int main() {
 
         // Now bind back to default framebuffer and draw a quad plane with the attached framebuffer color texture
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        glDisable(GL_DEPTH_TEST); // Disable depth test so screen-space quad isn't discarded due to depth test.
-        
-        // Clear all relevant buffers
-        glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not necessary, as we can't see past the plane)
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        screenShader.use();
-        glBindVertexArray(quadVAO);
-        glBindTexture(GL_TEXTURE_2D, textureColorBuffer); // Sample the color attachment texture as the texture of the quad plane
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-
-        // Unbind VAO
-        glBindVertexArray(0);
 
+        if (postChain) {
+            // Recompiled only when fusing was switched
+            if (chainFused != fuseChain) {
+                chain.compile(fuseChain);
+                chainFused = fuseChain;
+            }
+
+            chainTimers[fuseChain].begin();
+            chain.apply(textureColorBuffer);
+            chainTimers[fuseChain].end();
+
+            cout << "Post chain: " << (fuseChain ? "fused" : "unfused") << " | passes: " << chain.passCount() << " (" << chain.describe()
+                 << ") | GPU: " << chainTimers[fuseChain].averageMilliseconds() << " ms (other: " << chainTimers[!fuseChain].averageMilliseconds() << " ms)" << endl;
+        } else {
+            // Optionally blur the color texture first
+            unsigned int screenTexture = textureColorBuffer;
+            if (blurScene) {
+                sceneBlur.setSigma(blurSigma);
+                sceneBlur.setDownscale(blurDownscale);
+                screenTexture = sceneBlur.apply(textureColorBuffer);
+            }
+            glDisable(GL_DEPTH_TEST); // Disable depth test so screen-space quad isn't discarded due to depth test.
+
+            // Clear all relevant buffers
+            glClearColor(1.0f, 1.0f, 1.0f, 1.0f); // Set clear color to white (not necessary, as we can't see past the plane)
+            glClear(GL_COLOR_BUFFER_BIT);
+
+            screenShader.use();
+            glBindVertexArray(quadVAO);
+            bindTexture(0, screenTexture); // Sample the color attachment texture as the texture of the quad plane
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+
+            // Unbind VAO
+            glBindVertexArray(0);
+
+            cout << "Blur: " << (blurScene ? "on" : "off") << " | sigma: " << blurSigma << " | resolution: 1/" << blurDownscale
+                 << " | fetches per pass: " << sceneBlur.fetchesPerPass() << endl;
+        }
 
         // Swap buffers and poll I/O events
         glfwSwapBuffers(window);
@@ -374,6 +442,48 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !blurKeyPressed) {
+        blurScene = !blurScene;
+        blurKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) {
+        blurKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_PRESS && !downscaleKeyPressed) {
+        blurDownscale = blurDownscale == 4 ? 1 : blurDownscale * 2;
+        downscaleKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_N) == GLFW_RELEASE) {
+        downscaleKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS) {
+        blurSigma = std::max(blurSigma - 2.0f * deltaTime, 0.5f);
+    } else if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
+        blurSigma = std::min(blurSigma + 2.0f * deltaTime, 32.0f);
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS && !chainKeyPressed) {
+        postChain = !postChain;
+        chainKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_P) == GLFW_RELEASE) {
+        chainKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !fuseKeyPressed) {
+        fuseChain = !fuseChain;
+        fuseKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE) {
+        fuseKeyPressed = false;
+    }
 }
 
 // Whenever the window size is changed, this callback function executes
@@ -401,40 +511,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-
-// Utility function for loading a 2D texture from a file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
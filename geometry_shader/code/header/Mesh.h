@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "Shader.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 using namespace std;
 using namespace glm;
@@ -54,8 +55,6 @@ public:
 		unsigned int heightNr = 1;
 
 		for (unsigned int i = 0; i < textures.size(); i++) {
-			glActiveTexture(GL_TEXTURE0 + i); // Activate proper texture unit before binding
-			
 			// Retrieve texture number
 			string number;
 			string name = textures[i].type;
@@ -75,7 +74,7 @@ public:
 			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
 			
 			// And finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			bindTexture(i, textures[i].id);
 		}
 
 		// Draw mesh
@@ -8,9 +8,9 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include "stb_image.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 using namespace std;
 using namespace glm;
@@ -205,41 +205,7 @@ private:`
 };
 
 unsigned int TextureFromFile(const char* path, const string& directory, bool gamma) {
-	string filename = string(path);
-	filename = directory + '/' + filename;
-
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-
-	if(data) { // Check to see if image data was read
-		GLenum format;
-		if (nrComponents == 1) {
-			format = GL_RED;
-		} else if (nrComponents == 3) {
-			format = GL_RGB;
-		} else if (nrComponents == 4) {
-			format = GL_RGBA;
-		}
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	} else {
-		cout << "Texture failed to load at path: " << path << endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
+	return loadTexture(directory + '/' + path, TEXTURE_COLOR, gamma);
 }
 
 #endif
@@ -7,7 +7,7 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
+#include "../../../common/code/header/stb_image.h"
 #include "Camera.h"
 #include "Model.h"
 
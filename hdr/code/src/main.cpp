@@ -7,8 +7,10 @@
 #include <iostream>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/AutoExposure.h"
+#include "../../../common/code/header/ColorGrading.h"
 
 #include <iostream>
 
@@ -20,7 +22,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path, bool gammaCorrection);
 void renderQuad();
 void renderCube();
 
@@ -29,7 +30,15 @@ const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool hdr = true;
 bool hdrKeyPressed = false;
-float exposure = 1.0f;
+float exposure = 1.0f;              // Multiplies the measured exposure when autoExposure is on
+bool autoExposure = true;
+bool autoExposureKeyPressed = false;
+
+// Render targets
+const GLenum HDR_FORMAT = GL_R11F_G11F_B10F;    // 4 bytes a pixel; GL_RGBA16F (8 bytes) when alpha or more precision is needed
+bool srgbFramebuffer = true;                    // Let the default framebuffer do the sRGB encode
+string colorGradePath = "";                     // Optional color grade strip; the grade is neutral without one
+const unsigned int LUT_SIZE = 32;
 
 // camera
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
@@ -49,6 +58,7 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_SRGB_CAPABLE, srgbFramebuffer);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
@@ -80,12 +90,16 @@ int main() {
     glEnable(GL_DEPTH_TEST);
  
 
+    // The composite writes linear color if the default framebuffer encodes, sRGB if it can't
+    bool displayEncodes = srgbFramebuffer && enableSrgbFramebuffer();
+    unsigned int colorLut = createColorLut(colorGradePath, !displayEncodes, LUT_SIZE);
+
     // Build and compile shaders
     Shader shader("lighting.vs", "lighting.fs");
     Shader hdrShader("hdr.vs", "hdr.fs");
 
     // Load textures
-    unsigned int woodTexture = loadTexture("wood.png", true);
+    unsigned int woodTexture = loadTexture("wood.png", TEXTURE_COLOR, true);
 
     // Configure floating point framebuffer
     unsigned int hdrFBO;
@@ -96,7 +110,7 @@ int main() {
     glGenTextures(1, &colorBuffer);
     
     glBindTexture(GL_TEXTURE_2D, colorBuffer);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16F, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexImage2D(GL_TEXTURE_2D, 0, HDR_FORMAT, SCR_WIDTH, SCR_HEIGHT, 0, GL_RGB, GL_FLOAT, NULL);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -115,6 +129,8 @@ int main() {
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // Measures the average luminance of the HDR buffer and adapts to it over time
+    AutoExposure exposureMeter;
 
     // Lighting info
     // Positions
@@ -136,6 +152,8 @@ int main() {
     shader.setInt("diffuseTexture", 0);
     hdrShader.use();
     hdrShader.setInt("hdrBuffer", 0);
+    hdrShader.setInt("colorLut", 1);
+    hdrShader.setFloat("lutSize", LUT_SIZE);
 
     // Render Loop
     while (!glfwWindowShouldClose(window)) {
@@ -160,8 +178,7 @@ int main() {
             shader.use();
             shader.setMat4("projection", projection);
             shader.setMat4("view", view);
-            glActiveTexture(GL_TEXTURE0);
-            glBindTexture(GL_TEXTURE_2D, woodTexture);
+            bindTexture(0, woodTexture);
 
             // Set lighting uniforms
             for (unsigned int i = 0; i < lightPositions.size(); i++) {
@@ -180,16 +197,22 @@ int main() {
             renderCube();
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-        // 2. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffers (clamoed) colors
+        // 2. Measure the frame; the exposure it gives lags a few frames behind
+        exposureMeter.update(colorBuffer, deltaTime);
+        float frameExposure = autoExposure ? exposure * exposureMeter.getExposure() : exposure;
+
+        // 3. Now render floating point color buffer to 2D quad and tonemap HDR colors to default framebuffers (clamoed) colors
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         hdrShader.use();
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, colorBuffer);
+        bindTexture(0, colorBuffer);
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_3D, colorLut);
         hdrShader.setInt("hdr", hdr);
-        hdrShader.setFloat("exposure", exposure);
+        hdrShader.setFloat("exposure", frameExposure);
         renderQuad();
 
-        cout << "hdr: " << (hdr ? "on" : "off") << " | exposure: " << exposure << endl;
+        cout << "hdr: " << (hdr ? "on" : "off") << " | exposure: " << frameExposure
+             << " | auto exposure: " << (autoExposure ? "on" : "off") << " (average luminance " << exposureMeter.getAdaptedLuminance() << ")" << endl;
 
         // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window);
@@ -328,6 +351,15 @@ void processInput(GLFWwindow* window) {
         hdrKeyPressed = false;
     }
 
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_PRESS && !autoExposureKeyPressed) {
+        autoExposure = !autoExposure;
+        autoExposureKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_F) == GLFW_RELEASE) {
+        autoExposureKeyPressed = false;
+    }
+
     if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) {
         if (exposure > 0.0f) {
             exposure -= .001f;
@@ -369,42 +401,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path, bool gammaCorrection) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum dataFormat;
-        GLenum internalFormat;
-
-        if (nrComponents == 1) {
-            internalFormat = dataFormat = GL_RED;
-        } else if (nrComponents == 3) {
-            internalFormat = gammaCorrection ? GL_SRGB : GL_RGB;
-            dataFormat = GL_RGB;
-        } else if (nrComponents == 4) {
-            internalFormat = gammaCorrection ? GL_SRGB_ALPHA : GL_RGBA;
-            dataFormat = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, dataFormat, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT); 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -4,25 +4,28 @@ out vec4 FragColor;
 in vec2 TexCoords;
 
 uniform sampler2D hdrBuffer;
+uniform sampler3D colorLut;
 uniform bool hdr;
 uniform float exposure;
+uniform float lutSize;
 
+// Tone mapping, color grading and display encoding in one pass
 void main() {
-    const float gamma = 2.2;
     vec3 hdrColor = texture(hdrBuffer, TexCoords).rgb;
+    vec3 result;
 
     if(hdr) {
         // Reinhard
         // vec3 result = hdrColor (hdrColor + vec3(1.0))
 
         // Exposure
-        vec3 result = vec3(1.0) - exp(-hdrColor * exposure);
-
-        // Also gamma correct
-        result = pow(result, vec3(1.0 / gamma));
-        FragColor = vec4(result, 1.0);
+        result = vec3(1.0) - exp(-hdrColor * exposure);
     } else {
-        vec3 result = pow(hdrColor, vec3(1.0/gamma));
-        FragColor = vec4(result, 1.0);
+        result = clamp(hdrColor, 0.0, 1.0);
     }
+
+    // Grade and encode through the lookup table. It is indexed by the square root of the color;
+    // the scale and offset land 0 and 1 on the centers of its edge texels
+    vec3 lutCoords = sqrt(result) * ((lutSize - 1.0) / lutSize) + 0.5 / lutSize;
+    FragColor = vec4(texture(colorLut, lutCoords).rgb, 1.0);
 }
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
 using namespace std;
 using namespace glm;
@@ -20,6 +21,10 @@ public:
 	// Constructor reads and builds the shader
 	Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
 
+	// Constructor builds a program without a fragment stage whose listed outputs
+	// are captured by transform feedback into a single interleaved buffer
+	Shader(const char* vertexPath, const char* geometryPath, const vector<string>& feedbackVaryings);
+
 	// Use or activate the shader
 	void use();
 
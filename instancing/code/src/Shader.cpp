@@ -116,6 +116,79 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
 	}
 }
 
+// Constructor to read, compile and build a transform feedback program. The rasterizer
+// is expected to be disabled while it runs, so no fragment shader is attached
+Shader::Shader(const char* vertexPath, const char* geometryPath, const vector<string>& feedbackVaryings) {
+	string vertexCode;
+	string geometryCode;
+	ifstream vShaderFile;
+	ifstream gShaderFile;
+
+	// Ensure that the ifstream objects can throw exceptions
+	vShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+	gShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+
+	try {
+		vShaderFile.open(vertexPath);
+		stringstream vShaderStream;
+		vShaderStream << vShaderFile.rdbuf();
+		vShaderFile.close();
+		vertexCode = vShaderStream.str();
+
+		// The geometry stage is what lets the program drop primitives, so it is optional
+		if (geometryPath != nullptr) {
+			gShaderFile.open(geometryPath);
+			stringstream gShaderStream;
+			gShaderStream << gShaderFile.rdbuf();
+			gShaderFile.close();
+			geometryCode = gShaderStream.str();
+		}
+
+	} catch (ifstream::failure e) {
+		cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << endl;
+	}
+
+	// Vertex Shader
+	const char* vShaderCode = vertexCode.c_str();
+	unsigned int vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex, 1, &vShaderCode, NULL);
+	glCompileShader(vertex);
+	checkCompileErrors(vertex, "VERTEX");
+
+	// If geometry shader is given, compile it
+	unsigned int geometry = 0;
+	if (geometryPath != nullptr) {
+		const char* gShaderCode = geometryCode.c_str();
+		geometry = glCreateShader(GL_GEOMETRY_SHADER);
+		glShaderSource(geometry, 1, &gShaderCode, NULL);
+		glCompileShader(geometry);
+		checkCompileErrors(geometry, "GEOMETRY");
+	}
+
+	// Build the program
+	Shader::ID = glCreateProgram();
+	glAttachShader(ID, vertex);
+	if (geometryPath != nullptr) {
+		glAttachShader(ID, geometry);
+	}
+
+	// The captured outputs have to be declared before the program is linked
+	vector<const char*> varyings;
+	for (unsigned int i = 0; i < feedbackVaryings.size(); i++) {
+		varyings.push_back(feedbackVaryings[i].c_str());
+	}
+	glTransformFeedbackVaryings(ID, (GLsizei)varyings.size(), varyings.data(), GL_INTERLEAVED_ATTRIBS);
+
+	glLinkProgram(ID);
+	checkCompileErrors(ID, "PROGRAM");
+
+	// Delete the shaders as they're linked as they are no longer needed
+	glDeleteShader(vertex);
+	if (geometryPath != nullptr) {
+		glDeleteShader(geometry);
+	}
+}
+
 // Sets the program created by this class to the currently used program for rendering
 void Shader::use() {
 	glUseProgram(Shader::ID);
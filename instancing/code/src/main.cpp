@@ -7,10 +7,13 @@
 #include <iostream>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
+#include "../../../common/code/header/stb_image.h"
 #include "../header/Camera.h"
 
 #include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
 
 using namespace std;
 using namespace glm;
@@ -19,12 +22,23 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void extractFrustumPlanes(const mat4& viewProjection, vec4 planes[6]);
 
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// Instancing settings
+const int GRID_SIZE = 100; // Quads per row and column of the instance grid
+const unsigned int INSTANCE_COUNT = GRID_SIZE * GRID_SIZE;
+bool gpuCulling = true;
+bool cullingKeyPressed = false;
+
+// Culling passes kept in flight, each with its own compacted buffer and query, so the CPU never
+// waits on the GPU for a count
+const unsigned int CULL_RING = 3;
+
 // Camera set-up
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2;
@@ -80,16 +94,32 @@ int main() {
 
     // Build and Compile our shaders
     Shader shader("instancing.vs", "instancing.fs");
+    vector<string> cullVaryings;
+    cullVaryings.push_back("visibleOffset");
+    Shader cullShader("cull.vs", "cull.gs", cullVaryings);
+
+    // Where a transform feedback object can be drawn from directly, the count of visible instances
+    // stays on the GPU. It is drawn as points, one per instance, that a geometry shader grows into
+    // the quad
+    bool drawFromFeedback = false;
+#ifdef GL_VERSION_4_2
+    drawFromFeedback = drawFromFeedback || GLAD_GL_VERSION_4_2;
+#endif
+#ifdef GL_ARB_transform_feedback_instanced
+    drawFromFeedback = drawFromFeedback || GLAD_GL_ARB_transform_feedback_instanced;
+#endif
+    Shader expandShader("expand.vs", "instancing.fs", "expand.gs");
 
     // Load models
 
-    // Generate a list of 100 quad locations/translation vectors
-    vec2 translations[100];
+    // Generate a grid of quad locations/translation vectors. The grid spreads well past
+    // the view so most instances are off-screen at any time
+    vector<vec2> translations(INSTANCE_COUNT);
     int index = 0;
     float offset = 0.1f;
 
-    for (int y = -10; y < 10; y += 2) {
-        for (int x = -10; x < 10; x += 2) {
+    for (int y = -GRID_SIZE; y < GRID_SIZE; y += 2) {
+        for (int x = -GRID_SIZE; x < GRID_SIZE; x += 2) {
             vec2 translation;
             translation.x = (float)x / 10.0f + offset;
             translation.y = (float)y / 10.0f + offset;
@@ -101,9 +131,49 @@ int main() {
     unsigned int instanceVBO;
     glGenBuffers(1, &instanceVBO);
     glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vec2) * 100, &translations[0], GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vec2) * INSTANCE_COUNT, &translations[0], GL_STATIC_DRAW);
     glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+    // Compacted buffers that the culling passes write the visible instances into. They are
+    // sized for the worst case where every instance passes the frustum test
+    unsigned int visibleVBOs[CULL_RING];
+    glGenBuffers(CULL_RING, visibleVBOs);
+    for (unsigned int i = 0; i < CULL_RING; i++) {
+        glBindBuffer(GL_ARRAY_BUFFER, visibleVBOs[i]);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vec2) * INSTANCE_COUNT, NULL, GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // A transform feedback object per buffer remembers how much was written into it
+    unsigned int feedbacks[CULL_RING] = {};
+    if (drawFromFeedback) {
+        glGenTransformFeedbacks(CULL_RING, feedbacks);
+        for (unsigned int i = 0; i < CULL_RING; i++) {
+            glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[i]);
+            glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, visibleVBOs[i]);
+        }
+        glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+    }
+
+    // The culling pass reads every instance as a single point
+    unsigned int cullVAO;
+    glGenVertexArrays(1, &cullVAO);
+    glBindVertexArray(cullVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindVertexArray(0);
+
+    // Queries that tell us how many instances survived each culling pass. They are only read
+    // once their result has arrived
+    unsigned int visibleQueries[CULL_RING];
+    glGenQueries(CULL_RING, visibleQueries);
+    bool cullPending[CULL_RING] = {};       // Culled, but the count hasn't arrived yet
+    int cullFrames[CULL_RING];              // Frame the buffer was culled in, -1 for none
+    unsigned int visibleCounts[CULL_RING] = {};
+    fill(cullFrames, cullFrames + CULL_RING, -1);
+    int cullFrame = 0;
+
     // Set up vertex data
     float quadVertices[] = {
         // positions     // colors
@@ -133,6 +203,33 @@ int main() {
     glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
     glVertexAttribDivisor(2, 1); // Tell OpenGL this is an instanced vertex attribute
 
+    // Quad VAOs that source their instance data from the compacted buffers instead, and point
+    // VAOs that read the same buffers one instance per vertex
+    unsigned int culledQuadVAOs[CULL_RING];
+    unsigned int culledPointVAOs[CULL_RING];
+    glGenVertexArrays(CULL_RING, culledQuadVAOs);
+    glGenVertexArrays(CULL_RING, culledPointVAOs);
+    for (unsigned int i = 0; i < CULL_RING; i++) {
+        glBindVertexArray(culledQuadVAOs[i]);
+        glBindBuffer(GL_ARRAY_BUFFER, quadVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glBindBuffer(GL_ARRAY_BUFFER, visibleVBOs[i]);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+        glVertexAttribDivisor(2, 1);
+
+        glBindVertexArray(culledPointVAOs[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    }
+    glBindVertexArray(0);
+
+    // Bounding sphere of a single quad (half extent of 0.05 in x and y)
+    const float quadRadius = 0.05f * sqrt(2.0f);
+
 
     // Render Loop
     while (!glfwWindowShouldClose(window)) {
@@ -149,12 +246,98 @@ int main() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
-        // Activate shader
-        shader.use();
-        glBindVertexArray(quadVAO);
-        glDrawArraysInstanced(GL_TRIANGLES, 0, 6, 100); // 100 triangles, each with 6 vertices
+        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        mat4 view = camera.GetViewMatrix();
+        unsigned int instanceCount = INSTANCE_COUNT;
+        unsigned int slot = cullFrame % CULL_RING;
+        int newest = -1; // Culled buffer with the most recent count that has arrived
+
+        if (gpuCulling) {
+            // 1. Cull the instances against the camera frustum. Rasterization is turned off
+            // as the pass only exists to fill the compacted buffer
+            vec4 planes[6];
+            extractFrustumPlanes(projection * view, planes);
+
+            cullShader.use();
+            for (unsigned int i = 0; i < 6; i++) {
+                cullShader.setVec4("frustumPlanes[" + to_string(i) + "]", planes[i]);
+            }
+            cullShader.setFloat("boundingRadius", quadRadius);
+
+            // Capture into the oldest compacted buffer; the newer ones may still be drawn from
+            glEnable(GL_RASTERIZER_DISCARD);
+            if (drawFromFeedback) {
+                glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, feedbacks[slot]);
+            } else {
+                glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, visibleVBOs[slot]);
+            }
+            glBeginQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN, visibleQueries[slot]);
+            glBeginTransformFeedback(GL_POINTS);
+
+            glBindVertexArray(cullVAO);
+            glDrawArrays(GL_POINTS, 0, INSTANCE_COUNT);
+
+            glEndTransformFeedback();
+            glEndQuery(GL_TRANSFORM_FEEDBACK_PRIMITIVES_WRITTEN);
+            if (drawFromFeedback) {
+                glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+            } else {
+                glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+            }
+            glDisable(GL_RASTERIZER_DISCARD);
+            cullPending[slot] = true;
+            cullFrames[slot] = cullFrame++;
+
+            // Every emitted point is one visible instance. Counts are collected as they arrive,
+            // usually a frame late, without ever waiting for one
+            for (unsigned int i = 0; i < CULL_RING; i++) {
+                if (cullPending[i]) {
+                    unsigned int available = 0;
+                    glGetQueryObjectuiv(visibleQueries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+                    if (available) {
+                        glGetQueryObjectuiv(visibleQueries[i], GL_QUERY_RESULT, &visibleCounts[i]);
+                        cullPending[i] = false;
+                    }
+                }
+                if (!cullPending[i] && cullFrames[i] >= 0 && (newest < 0 || cullFrames[i] > cullFrames[newest])) {
+                    newest = i;
+                }
+            }
+        } else {
+            // Counts from before culling was turned off belong to an old view
+            fill(cullFrames, cullFrames + CULL_RING, -1);
+            fill(cullPending, cullPending + CULL_RING, false);
+        }
+
+        // 2. Draw only the instances that are left
+        if (gpuCulling && drawFromFeedback) {
+            // This frame's buffer, with the count the GPU kept for it
+            expandShader.use();
+            expandShader.setMat4("projection", projection);
+            expandShader.setMat4("view", view);
+            glBindVertexArray(culledPointVAOs[slot]);
+#if defined(GL_VERSION_4_2) || defined(GL_ARB_transform_feedback_instanced)
+            glDrawTransformFeedbackInstanced(GL_POINTS, feedbacks[slot], 1);
+#endif
+            instanceCount = newest >= 0 ? visibleCounts[newest] : 0;
+        } else {
+            // Without it the count has to come back to the CPU, so the buffer drawn is the newest
+            // one whose count has arrived, usually last frame's. Until one has, everything is drawn
+            shader.use();
+            shader.setMat4("projection", projection);
+            shader.setMat4("view", view);
+            if (gpuCulling && newest >= 0) {
+                instanceCount = visibleCounts[newest];
+                glBindVertexArray(culledQuadVAOs[newest]);
+            } else {
+                glBindVertexArray(quadVAO);
+            }
+            glDrawArraysInstanced(GL_TRIANGLES, 0, 6, instanceCount); // One quad of 6 vertices per instance
+        }
         glBindVertexArray(0);
 
+        cout << "GPU culling: " << (gpuCulling ? "on" : "off") << "| instances drawn: " << instanceCount << " / " << INSTANCE_COUNT << endl;
+
         // Swap buffers and poll I/O events
         glfwSwapBuffers(window);
         glfwPollEvents();
@@ -182,6 +365,32 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !cullingKeyPressed) {
+        gpuCulling = !gpuCulling;
+        cullingKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        cullingKeyPressed = false;
+    }
+}
+
+// Extracts the six world space frustum planes from a combined projection * view matrix
+// (Gribb/Hartmann). The planes are normalized so that a dot product gives the distance
+void extractFrustumPlanes(const mat4& viewProjection, vec4 planes[6]) {
+    mat4 m = transpose(viewProjection); // Rows of the matrix are easier to work with
+
+    planes[0] = m[3] + m[0]; // Left
+    planes[1] = m[3] - m[0]; // Right
+    planes[2] = m[3] + m[1]; // Bottom
+    planes[3] = m[3] - m[1]; // Top
+    planes[4] = m[3] + m[2]; // Near
+    planes[5] = m[3] - m[2]; // Far
+
+    for (unsigned int i = 0; i < 6; i++) {
+        planes[i] /= length(vec3(planes[i]));
+    }
 }
 
 // Whenever the window size is changed, this callback function executes
@@ -0,0 +1,21 @@
+#version 330 core
+
+layout (points) in;
+layout (points, max_vertices = 1) out;
+
+in VS_OUT {
+    vec2 offset;
+    float visible;
+} gs_in[];
+
+// Captured by transform feedback into the compacted instance buffer
+out vec2 visibleOffset;
+
+void main() {
+    // Only emitting visible instances is what compacts the output buffer
+    if(gs_in[0].visible > 0.5) {
+        visibleOffset = gs_in[0].offset;
+        EmitVertex();
+        EndPrimitive();
+    }
+}
\ No newline at end of file
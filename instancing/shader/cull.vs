@@ -0,0 +1,27 @@
+#version 330 core
+
+layout (location = 0) in vec2 aOffset;
+
+out VS_OUT {
+    vec2 offset;
+    float visible;
+} vs_out;
+
+// World space frustum planes (xyz = normal, w = distance), normalized on the CPU
+uniform vec4 frustumPlanes[6];
+uniform float boundingRadius;
+
+void main() {
+    vec4 center = vec4(aOffset, 0.0, 1.0);
+
+    // The instance is visible unless its bounding sphere lies fully behind a plane
+    bool visible = true;
+    for(int i = 0; i < 6; i++) {
+        if(dot(frustumPlanes[i], center) < -boundingRadius) {
+            visible = false;
+        }
+    }
+
+    vs_out.offset = aOffset;
+    vs_out.visible = visible ? 1.0 : 0.0;
+}
\ No newline at end of file
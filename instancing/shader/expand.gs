@@ -0,0 +1,29 @@
+#version 330 core
+
+layout (points) in;
+layout (triangle_strip, max_vertices = 4) out;
+
+in VS_OUT {
+    vec2 offset;
+} gs_in[];
+
+out vec3 fColor;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+// Emits one corner of the quad instancing.vs draws, with the same color
+void emitCorner(vec2 corner, vec3 color) {
+    fColor = color;
+    gl_Position = projection * view * vec4(corner + gs_in[0].offset, 0.0, 1.0);
+    EmitVertex();
+}
+
+void main() {
+    // As a strip the corners make the same two triangles as the quad vertices
+    emitCorner(vec2(-0.05, -0.05), vec3(0.0, 0.0, 1.0));
+    emitCorner(vec2(-0.05,  0.05), vec3(1.0, 0.0, 0.0));
+    emitCorner(vec2( 0.05, -0.05), vec3(0.0, 1.0, 0.0));
+    emitCorner(vec2( 0.05,  0.05), vec3(0.0, 1.0, 1.0));
+    EndPrimitive();
+}
\ No newline at end of file
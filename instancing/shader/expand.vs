@@ -0,0 +1,11 @@
+#version 330 core
+
+layout (location = 0) in vec2 aOffset;
+
+out VS_OUT {
+    vec2 offset;
+} vs_out;
+
+void main() {
+    vs_out.offset = aOffset;
+}
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "Shader.h"
+#include "../../../common/code/header/TextureLoader.h"
 
 using namespace std;
 using namespace glm;
@@ -34,6 +35,8 @@ public:
 	vector<unsigned int> indices;
 	vector<Texture> textures;
 	unsigned int VAO;
+	vec3 BoundsCenter;	// Bounding sphere in model space
+	float BoundsRadius;
 
 	// Constructor
 	Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures) {
@@ -41,6 +44,8 @@ public:
 		this->indices = indices;
 		this->textures = textures;
 
+		computeBounds();
+
 		// Now that we have all the data required, set the vertex buffers and its attribute pointers
 		setupMesh();
 	}
@@ -54,8 +59,6 @@ public:
 		unsigned int heightNr = 1;
 
 		for (unsigned int i = 0; i < textures.size(); i++) {
-			glActiveTexture(GL_TEXTURE0 + i); // Activate proper texture unit before binding
-			
 			// Retrieve texture number
 			string number;
 			string name = textures[i].type;
@@ -75,7 +78,7 @@ public:
 			glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
 			
 			// And finally bind the texture
-			glBindTexture(GL_TEXTURE_2D, textures[i].id);
+			bindTexture(i, textures[i].id);
 		}
 
 		// Draw mesh
@@ -91,6 +94,20 @@ private:
 	// Rendering data
 	unsigned int VBO, EBO;
 
+	// Bounding sphere around the center of the vertices' bounding box
+	void computeBounds() {
+		vec3 minimum(0.0f), maximum(0.0f);
+		for (unsigned int i = 0; i < vertices.size(); i++) {
+			minimum = i == 0 ? vertices[i].Position : glm::min(minimum, vertices[i].Position);
+			maximum = i == 0 ? vertices[i].Position : glm::max(maximum, vertices[i].Position);
+		}
+		BoundsCenter = (minimum + maximum) * 0.5f;
+		BoundsRadius = 0.0f;
+		for (unsigned int i = 0; i < vertices.size(); i++) {
+			BoundsRadius = glm::max(BoundsRadius, length(vertices[i].Position - BoundsCenter));
+		}
+	}
+
 	// Initialize all buffer objects and arrays
 	void setupMesh() {
 		// Create buffers/arrays
@@ -8,15 +8,18 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include "stb_image.h"
 #include "Mesh.h"
 #include "Shader.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/TextureUploader.h"
+#include "../../../common/code/header/TextureStreamer.h"
+#include "../../../common/code/header/TangentGenerator.h"
 
 using namespace std;
 using namespace glm;
 using namespace Assimp;
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false);
+unsigned int TextureFromFile(const char* path, const string& directory, bool gamma = false, TextureUploader* uploader = nullptr, TextureStreamer* streamer = nullptr);
 
 class Model {
 public:
@@ -25,12 +28,31 @@ public:
 	vector<Mesh> meshes;				// Vector to keep track of all meshes in the object
 	string directory;					// Directory of file
 	bool gammaCorrection;				// Boolean for gamma correction
+	TextureUploader* uploader;			// Streams the textures in over several frames when set
+	TextureStreamer* streamer;			// Keeps only the mip levels the view needs resident when set
 
 	// Constructor, expects a filepath to a 3D model
-	Model(const string& path, bool gamma = false) : gammaCorrection(gamma) {
+	Model(const string& path, bool gamma = false, TextureUploader* uploader = nullptr, TextureStreamer* streamer = nullptr) : gammaCorrection(gamma), uploader(uploader), streamer(streamer) {
 		loadModel(path);
 	}
 
+	// Tells the texture streamer how large each mesh's textures appear on screen this frame.
+	// Assumes the texture spans the mesh bounds about once, which holds for unwrapped models
+	void RecordTextureUsage(const mat4& modelView, float fovY, int viewportHeight) {
+		if (streamer == nullptr) {
+			return;
+		}
+
+		float scale = length(vec3(modelView[0])); // Uniform scale assumed
+		for (unsigned int i = 0; i < meshes.size(); i++) {
+			vec3 viewCenter = vec3(modelView * vec4(meshes[i].BoundsCenter, 1.0f));
+			float pixels = TextureStreamer::screenFootprint(viewCenter, meshes[i].BoundsRadius * scale, fovY, viewportHeight);
+			for (unsigned int j = 0; j < meshes[i].textures.size(); j++) {
+				streamer->recordUsage(meshes[i].textures[j].id, pixels);
+			}
+		}
+	}
+
 	// Draws the model (thus all of its meshes)
 	void Draw(Shader& shader) {
 		for (unsigned int i = 0; i < meshes.size(); i++) {
@@ -39,11 +61,19 @@ public:
 	}
 
 private:
+	// A mesh read from the scene, before it is uploaded
+	struct MeshData {
+		vector<Vertex> vertices;
+		vector<unsigned int> indices;
+		vector<Texture> textures;
+	};
+
 	// Loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector
 	void loadModel(const string& path) {
-		// Importer object to import file and load the scene
+		// Importer object to import file and load the scene. Tangents come from the tangent
+		// generator, which matches the MikkTSpace tangents normal maps are usually baked with
 		Importer importer; 
-		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+		const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs);
 		
 		// Check for errors
 		if (!scene || (scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE) || !scene->mRootNode) {
@@ -55,26 +85,33 @@ private:
 		directory = path.substr(0, path.find_last_of('/'));
 
 		// Proccess ASSSIMP's root node recursively
-		processNode(scene->mRootNode, scene);
+		vector<MeshData> meshData;
+		processNode(scene->mRootNode, scene, meshData);
+
+		// Generate the tangents of all meshes at once, then upload them
+		generateMeshTangents(meshData);
+		for (unsigned int i = 0; i < meshData.size(); i++) {
+			meshes.push_back(Mesh(meshData[i].vertices, meshData[i].indices, meshData[i].textures));
+		}
 	}
 
-	void processNode(aiNode* node, const aiScene* scene) {
+	void processNode(aiNode* node, const aiScene* scene, vector<MeshData>& meshData) {
 		// Process each mesh located at the current node
 		for (unsigned int i = 0; i < node->mNumMeshes; i++) {
 			// The node object only contains indices to index the actual objects in the scene.
 			// The scene contains all the data, node is just to kee stuff organized (like relations
 			// between parent and and child meshes, etc.)
 			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes.push_back(processMesh(mesh, scene));
+			meshData.push_back(processMesh(mesh, scene));
 		}
 
 		// After we've process all of the meshes, recurse through each of the child nodes
 		for (unsigned int i = 0; i < node->mNumChildren; i++) {
-			processNode(node->mChildren[i], scene);
+			processNode(node->mChildren[i], scene, meshData);
 		}
 	}
 
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene) {
+	MeshData processMesh(aiMesh* mesh, const aiScene* scene) {
 		// Data to fill for mesh object
 		vector<Vertex> vertices;
 		vector<unsigned int> indices;
@@ -94,8 +131,9 @@ private:
 			// Normals
 			if (mesh->HasNormals()) {
 				vector.x = mesh->mNormals[i].x;
-				vector.x = mesh->mNormals[i].y;
+				vector.y = mesh->mNormals[i].y;
 				vector.z = mesh->mNormals[i].z;
+				vertex.Normal = vector;
 			}
 
 			// Texture Coordinates
@@ -107,16 +145,6 @@ private:
 				vec.x = mesh->mTextureCoords[0][i].x;
 				vec.y = mesh->mTextureCoords[0][i].y;
 				vertex.TexCoords = vec;
-
-				// Tangent
-				vector.x = mesh->mTangents[i].x;
-				vector.y = mesh->mTangents[i].y;
-				vector.z = mesh->mTangents[i].z;
-
-				// Bitangent
-				vector.x = mesh->mBitangents[i].x;
-				vector.y = mesh->mBitangents[i].y;
-				vector.z = mesh->mBitangents[i].z;
 			} else {
 				vertex.TexCoords = vec2(0.0f, 0.0f);
 			}
@@ -161,8 +189,42 @@ private:
 		vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
 		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
-		// return a mesh object created from the extracted mesh data
-		return Mesh(vertices, indices, textures);
+		// return the extracted mesh data; the tangents are generated for all meshes at once
+		return { vertices, indices, textures };
+	}
+
+	// Fills in the tangents and bitangents of every mesh, one mesh per thread
+	void generateMeshTangents(vector<MeshData>& meshData) {
+		vector<vector<float>> tangents(meshData.size());
+		vector<Tangent_Mesh> tangentMeshes(meshData.size());
+		for (unsigned int i = 0; i < meshData.size(); i++) {
+			vector<Vertex>& vertices = meshData[i].vertices;
+			if (vertices.empty()) {
+				continue;
+			}
+			tangents[i].resize(vertices.size() * 4);
+
+			Tangent_Mesh& tangentMesh = tangentMeshes[i];
+			tangentMesh.positions = &vertices[0].Position.x;
+			tangentMesh.normals = &vertices[0].Normal.x;
+			tangentMesh.texCoords = &vertices[0].TexCoords.x;
+			tangentMesh.positionStride = tangentMesh.normalStride = tangentMesh.texCoordStride = sizeof(Vertex) / sizeof(float);
+			tangentMesh.vertexCount = (unsigned int)vertices.size();
+			tangentMesh.indices = meshData[i].indices.data();
+			tangentMesh.indexCount = (unsigned int)meshData[i].indices.size();
+			tangentMesh.tangents = tangents[i].data();
+		}
+		generateTangents(tangentMeshes);
+
+		// The vertex layout keeps a separate bitangent, rebuilt from the sign
+		for (unsigned int i = 0; i < meshData.size(); i++) {
+			vector<Vertex>& vertices = meshData[i].vertices;
+			for (unsigned int j = 0; j < vertices.size(); j++) {
+				const float* tangent = &tangents[i][j * 4];
+				vertices[j].Tangent = vec3(tangent[0], tangent[1], tangent[2]);
+				vertices[j].Bitangent = cross(vertices[j].Normal, vertices[j].Tangent) * tangent[3];
+			}
+		}
 	}
 
 	vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName) {
@@ -186,7 +248,7 @@ private:
 				Texture texture;
 				
 				// Set up texture attributes
-				texture.id = TextureFromFile(str.C_Str(), this->directory);
+				texture.id = TextureFromFile(str.C_Str(), this->directory, false, uploader, streamer);
 				texture.type = typeName;
 				texture.path = str.C_Str();
 
@@ -200,42 +262,12 @@ private:
 	}
 };
 
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma) {
-	string filename = string(path);
-	filename = directory + '/' + filename;
-
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
-
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-
-	if(data) { // Check to see if image data was read
-		GLenum format;
-		if (nrComponents == 1) {
-			format = GL_RED;
-		} else if (nrComponents == 3) {
-			format = GL_RGB;
-		} else if (nrComponents == 4) {
-			format = GL_RGBA;
-		}
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	} else {
-		cout << "Texture failed to load at path: " << path << endl;
-		stbi_image_free(data);
-	}
-
-	return textureID;
+unsigned int TextureFromFile(const char* path, const string& directory, bool gamma, TextureUploader* uploader, TextureStreamer* streamer) {
+	Texture_Options options;
+	options.srgb = gamma;
+	options.uploader = uploader; // Hands the pixels to the upload queue instead of blocking on the upload
+	options.streamer = streamer; // Starts cached textures with their small levels only
+	return loadTexture(directory + '/' + path, options);
 }
 
 #endif
@@ -7,7 +7,7 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
+#include "../../../common/code/header/stb_image.h"
 #include "Camera.h"
 #include "Model.h"
 
@@ -83,8 +83,14 @@ int main() {
     // Build and Compile our shaders
     Shader shader("model.vs", "model.fs");
 
+    // Textures are streamed in through a ring of pixel buffers over the first frames
+    TextureUploader textureUploader;
+
+    // Cached textures keep only the mip levels their on-screen size needs
+    TextureStreamer textureStreamer;
+
     // Load models
-    Model backpackModel("backpack/backpack.obj");
+    Model backpackModel("backpack/backpack.obj", false, &textureUploader, &textureStreamer);
 
     // Draw in wireframe
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -100,6 +106,9 @@ int main() {
         // Input
         processInput(window);
 
+        // Continue any texture uploads that are still in flight, within this frame's budget
+        textureUploader.update();
+
         // Render
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -120,6 +129,10 @@ int main() {
         model = scale(model, vec3(1.0f, 1.0f, 1.0f));
         shader.setMat4("model", model);
         backpackModel.Draw(shader);
+        backpackModel.RecordTextureUsage(view * model, radians(camera.Zoom), SCR_HEIGHT);
+
+        // Read and upload the finer levels that came into view, drop the ones that went out of it
+        textureStreamer.update();
 
         // Swap buffers and poll I/O events
         glfwSwapBuffers(window);
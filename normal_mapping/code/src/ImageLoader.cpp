@@ -1,2 +0,0 @@
-#define STB_IMAGE_IMPLEMENTATION
-#include "../header/stb_image.h"
\ No newline at end of file
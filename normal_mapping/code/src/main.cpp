@@ -7,8 +7,9 @@
 #include <iostream>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/TangentGenerator.h"
 
 #include <iostream>
 
@@ -20,16 +21,18 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 void renderScene(const Shader& shader);
 void renderCube();
 void renderQuad();
+void runTangentBenchmark();
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool shadows = true;
 bool shadowsKeyPressed = false;
+bool runBenchmark = false;
+bool benchmarkKeyPressed = false;
 
 // camera
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
@@ -85,7 +88,7 @@ int main() {
 
     // Load textures
     unsigned int diffuseMap = loadTexture("brickwall.jpg");
-    unsigned int normalMap = loadTexture("brickwall_normal.jpg");
+    unsigned int normalMap = loadTexture("brickwall_normal.jpg", TEXTURE_NORMAL);
 
     // Shader configuration
     shader.use();
@@ -108,6 +111,11 @@ int main() {
         // Input
         processInput(window);
 
+        if (runBenchmark) {
+            runBenchmark = false;
+            runTangentBenchmark();
+        }
+
         // Render
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -128,10 +136,8 @@ int main() {
         shader.setVec3("viewPos", camera.Position);
         shader.setVec3("lightPos", lightPos);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalMap);
+        bindTexture(0, diffuseMap);
+        bindTexture(1, normalMap);
         renderQuad();
 
         // Render light source (simply re-renders a smaller plane at the lights position for visualization
@@ -151,75 +157,32 @@ int main() {
     return 0;
 }
 
-// renders a 1x1 quad in NDC with manually calculated tangent vectors
+// renders a 1x1 quad in NDC with tangents from the tangent generator
 unsigned int quadVAO = 0;
 unsigned int quadVBO;
 void renderQuad() {
     if (quadVAO == 0) {
-        // Positions
-        vec3 pos1(-1.0f, 1.0f, 0.0f);
-        vec3 pos2(-1.0f, -1.0f, 0.0f);
-        vec3 pos3(1.0f, -1.0f, 0.0f);
-        vec3 pos4(1.0f, 1.0f, 0.0f);
-
-        // Texture coordinates
-        vec2 uv1(0.0f, 1.0f);
-        vec2 uv2(0.0f, 0.0f);
-        vec2 uv3(1.0f, 0.0f);
-        vec2 uv4(1.0f, 1.0f);
-
-        // Normal vector
-        vec3 nm(0.0f, 0.0f, 1.0f);
-
-        // Calculate tangent/bitangent vectors of both triangles
-        vec3 tangent1, bitangent1;
-        vec3 tangent2, bitangent2;
-
-        // Triangle 1
-        vec3 edge1 = pos2 - pos1;
-        vec3 edge2 = pos3 - pos1;
-        vec2 deltaUV1 = uv2 - uv1;
-        vec2 deltaUV2 = uv3 - uv1;
-
-        float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-        tangent1.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent1.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent1.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-        bitangent1.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-        bitangent1.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-        bitangent1.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-
-        // Triangle 2
-        edge1 = pos3 - pos1;
-        edge2 = pos4 - pos1;
-        deltaUV1 = uv3 - uv1;
-        deltaUV2 = uv4 - uv1;
-
-        f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-        tangent2.x = f * (deltaUV2.y * edge1.x - deltaUV1.y * edge2.x);
-        tangent2.y = f * (deltaUV2.y * edge1.y - deltaUV1.y * edge2.y);
-        tangent2.z = f * (deltaUV2.y * edge1.z - deltaUV1.y * edge2.z);
-
-
-        bitangent2.x = f * (-deltaUV2.x * edge1.x + deltaUV1.x * edge2.x);
-        bitangent2.y = f * (-deltaUV2.x * edge1.y + deltaUV1.x * edge2.y);
-        bitangent2.z = f * (-deltaUV2.x * edge1.z + deltaUV1.x * edge2.z);
-
-
         float quadVertices[] = {
-            // Positions            // n=Normal         // Texcoords  // Tangent                          // Bitangent
-            pos1.x, pos1.y, pos1.z, nm.x, nm.y, nm.z, uv1.x, uv1.y, tangent1.x, tangent1.y, tangent1.z, bitangent1.x, bitangent1.y, bitangent1.z,
-            pos2.x, pos2.y, pos2.z, nm.x, nm.y, nm.z, uv2.x, uv2.y, tangent1.x, tangent1.y, tangent1.z, bitangent1.x, bitangent1.y, bitangent1.z,
-            pos3.x, pos3.y, pos3.z, nm.x, nm.y, nm.z, uv3.x, uv3.y, tangent1.x, tangent1.y, tangent1.z, bitangent1.x, bitangent1.y, bitangent1.z,
-
-            pos1.x, pos1.y, pos1.z, nm.x, nm.y, nm.z, uv1.x, uv1.y, tangent2.x, tangent2.y, tangent2.z, bitangent2.x, bitangent2.y, bitangent2.z,
-            pos3.x, pos3.y, pos3.z, nm.x, nm.y, nm.z, uv3.x, uv3.y, tangent2.x, tangent2.y, tangent2.z, bitangent2.x, bitangent2.y, bitangent2.z,
-            pos4.x, pos4.y, pos4.z, nm.x, nm.y, nm.z, uv4.x, uv4.y, tangent2.x, tangent2.y, tangent2.z, bitangent2.x, bitangent2.y, bitangent2.z
+            // Positions        // Normal         // Texcoords  // Tangent and bitangent sign, generated below
+            -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+            -1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+             1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+
+            -1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+             1.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+             1.0f,  1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f
         };
 
+        // The generator reads and writes the interleaved vertices in place
+        Tangent_Mesh mesh;
+        mesh.positions = quadVertices;
+        mesh.normals = quadVertices + 3;
+        mesh.texCoords = quadVertices + 6;
+        mesh.tangents = quadVertices + 8;
+        mesh.positionStride = mesh.normalStride = mesh.texCoordStride = mesh.tangentStride = 12;
+        mesh.vertexCount = 6;
+        generateTangents(mesh);
+
         // Configure plane VAO
         glGenVertexArrays(1, &quadVAO);
         glGenBuffers(1, &quadVBO);
@@ -230,19 +193,16 @@ void renderQuad() {
         
         // Set up vertex Attributes
         glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)0);
         
         glEnableVertexAttribArray(1);
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(3 * sizeof(float)));
         
         glEnableVertexAttribArray(2);
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(6 * sizeof(float)));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(6 * sizeof(float)));
         
         glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(8 * sizeof(float)));
-        
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 14 * sizeof(float), (void*)(11 * sizeof(float)));
+        glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, 12 * sizeof(float), (void*)(8 * sizeof(float)));
     }
 
     // Draw the quad
@@ -252,6 +212,70 @@ void renderQuad() {
 }
 
 
+// Generates the tangents of a large procedural grid, alone and as several meshes at once, one
+// per thread, and prints the throughput
+void runTangentBenchmark() {
+    // A wavy grid with texture coordinates that repeat and mirror, so both signs come up
+    const unsigned int GRID_SIZE = 1024;
+    const unsigned int MESH_COUNT = 8;
+    const unsigned int RUNS = 4;
+
+    vector<float> vertices;
+    vertices.reserve(GRID_SIZE * GRID_SIZE * 8);
+    for (unsigned int y = 0; y < GRID_SIZE; y++) {
+        for (unsigned int x = 0; x < GRID_SIZE; x++) {
+            float u = (float)x / (GRID_SIZE - 1);
+            float v = (float)y / (GRID_SIZE - 1);
+            float height = 0.05f * sin(u * 40.0f) * cos(v * 40.0f);
+            vec3 normal = normalize(vec3(-2.0f * cos(u * 40.0f) * cos(v * 40.0f), 1.0f, 2.0f * sin(u * 40.0f) * sin(v * 40.0f)));
+            float texU = fabs(fmod(u * 16.0f, 2.0f) - 1.0f);
+            float vertex[] = { u, height, v, normal.x, normal.y, normal.z, texU, v * 16.0f };
+            vertices.insert(vertices.end(), vertex, vertex + 8);
+        }
+    }
+
+    vector<unsigned int> indices;
+    indices.reserve((GRID_SIZE - 1) * (GRID_SIZE - 1) * 6);
+    for (unsigned int y = 0; y + 1 < GRID_SIZE; y++) {
+        for (unsigned int x = 0; x + 1 < GRID_SIZE; x++) {
+            unsigned int corner = y * GRID_SIZE + x;
+            unsigned int quad[] = { corner, corner + GRID_SIZE, corner + 1, corner + 1, corner + GRID_SIZE, corner + GRID_SIZE + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+
+    vector<vector<float>> tangents(MESH_COUNT, vector<float>(GRID_SIZE * GRID_SIZE * 4));
+    vector<Tangent_Mesh> meshes(MESH_COUNT);
+    for (unsigned int i = 0; i < MESH_COUNT; i++) {
+        meshes[i].positions = vertices.data();
+        meshes[i].normals = vertices.data() + 3;
+        meshes[i].texCoords = vertices.data() + 6;
+        meshes[i].positionStride = meshes[i].normalStride = meshes[i].texCoordStride = 8;
+        meshes[i].vertexCount = GRID_SIZE * GRID_SIZE;
+        meshes[i].indices = indices.data();
+        meshes[i].indexCount = (unsigned int)indices.size();
+        meshes[i].tangents = tangents[i].data();
+    }
+
+    double triangles = indices.size() / 3.0;
+    cout << "Tangent generation benchmark (" << (unsigned int)triangles << " triangles per mesh, average of " << RUNS << " runs):" << endl;
+
+    double start = glfwGetTime();
+    for (unsigned int run = 0; run < RUNS; run++) {
+        generateTangents(meshes[0]);
+    }
+    double seconds = (glfwGetTime() - start) / RUNS;
+    cout << "  1 mesh: " << seconds * 1000.0 << " ms, " << triangles / seconds / 1.0e6 << " million triangles/s" << endl;
+
+    start = glfwGetTime();
+    for (unsigned int run = 0; run < RUNS; run++) {
+        generateTangents(meshes);
+    }
+    seconds = (glfwGetTime() - start) / RUNS;
+    cout << "  " << MESH_COUNT << " meshes, one per thread: " << seconds * 1000.0 << " ms, "
+         << triangles * MESH_COUNT / seconds / 1.0e6 << " million triangles/s" << endl;
+}
+
 // Renders the 3D scene
 void renderScene(const Shader& shader) {
 
@@ -402,6 +426,15 @@ void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE) {
         shadowsKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !benchmarkKeyPressed) {
+        runBenchmark = true;
+        benchmarkKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) {
+        benchmarkKeyPressed = false;
+    }
 }
 
 // GLFW: whenever the window size changed (by OS or user resize) this callback function executes
@@ -432,37 +465,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // For this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
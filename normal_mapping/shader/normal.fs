@@ -16,10 +16,12 @@ uniform vec3 lightPos;
 uniform vec3 viewPos;
 
 void main() {
-    // Obtain normal from normal map in range [0, 1]
-    vec3 normal = texture(normalMap, fs_in.TexCoords).rgb;
+    // Obtain normal from normal map in range [0, 1]. Only x and y are read so the map can be
+    // stored as two-channel BC5; z is rebuilt as the normal has unit length
+    vec2 normalXY = texture(normalMap, fs_in.TexCoords).rg;
     // Transform normal vector to range [-1, 1]
-    normal = normalize(normal * 2.0 - 1.0); // This normal is in tangent space
+    normalXY = normalXY * 2.0 - 1.0;
+    vec3 normal = normalize(vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)))); // This normal is in tangent space
 
     // Diffuse color
     vec3 color = texture(diffuseMap, fs_in.TexCoords).rgb;
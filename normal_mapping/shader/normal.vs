@@ -3,8 +3,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
-layout (location = 3) in vec3 aTangent;
-layout (location = 4) in vec3 aBitanget;
+layout (location = 3) in vec4 aTangent; // Bitangent sign in w
 
 
 out VS_OUT {
@@ -29,13 +28,13 @@ void main() {
 
     // Compute TNB matrix
     mat3 normalMatrix = transpose(inverse(mat3(model)));
-    vec3 T = normalize(normalMatrix * aTangent);
+    vec3 T = normalize(normalMatrix * aTangent.xyz);
     vec3 N = normalize(normalMatrix * aNormal);
 
     // Recalculate T to ensure that tangent vector smoothing didn't effect
     // orthogonality of the vector
     T = normalize(T - dot(T, N) * N);
-    vec3 B = cross(N,T);
+    vec3 B = cross(N, T) * aTangent.w; // Flipped where the texture is mirrored
 
     // Now, use the TBN matrix
     mat3 TBN = transpose(mat3(T, B, N));
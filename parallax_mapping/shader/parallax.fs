@@ -12,10 +12,19 @@ in VS_OUT {
 uniform sampler2D diffuseMap;
 uniform sampler2D normalMap;
 uniform sampler2D depthMap;
+uniform sampler2D coneMap;  // Depth in red, square root of the relaxed cone ratio in green
 
 uniform float heightScale;
+uniform bool coneStepMapping;
+uniform vec2 fallbackDistance;  // Parallax fades out to plain normal mapping between these distances
+uniform vec2 fallbackLod;       // and between these mip levels of the diffuse map
 
-vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
+// The gradients of the unshifted coordinates, for fetches in loops and branches where the
+// implicit ones are undefined
+vec2 dx;
+vec2 dy;
+
+vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir, float depthScale) {
     // Number of depth layers
     const float minLayers = 8;
     const float maxLayers = 32;
@@ -28,19 +37,19 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
     float currentLayerDepth = 0.0;
 
     // The amount to shift the texture coordinates per layer
-    vec2 P = viewDir.xy / viewDir.z * heightScale;
+    vec2 P = viewDir.xy / viewDir.z * depthScale;
     vec2 deltaTexCoords = P / numLayers;
 
     // Get inital values
     vec2 currentTexCoords = texCoords;
-    float currentDepthMapValue = texture(depthMap, currentTexCoords).r;
+    float currentDepthMapValue = textureGrad(depthMap, currentTexCoords, dx, dy).r;
 
     while(currentLayerDepth < currentDepthMapValue) {
         // Shift texture coordinates along direction of P
         currentTexCoords -= deltaTexCoords;
 
         // Get depthmap value at current texture coordinates
-        currentDepthMapValue = texture(depthMap, currentTexCoords).r;
+        currentDepthMapValue = textureGrad(depthMap, currentTexCoords, dx, dy).r;
 
         // Get depth of next layer
         currentLayerDepth += layerDepth;
@@ -51,7 +60,7 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
 
     // Get depth after and before collision
     float afterDepth = currentDepthMapValue - currentLayerDepth;
-    float beforeDepth = texture(depthMap, previousTexCoords).r - currentLayerDepth + layerDepth;
+    float beforeDepth = textureGrad(depthMap, previousTexCoords, dx, dy).r - currentLayerDepth + layerDepth;
 
     // Interpolation of texture coordinates
     float weight = afterDepth / (afterDepth - beforeDepth);
@@ -60,23 +69,85 @@ vec2 ParallaxMapping(vec2 texCoords, vec3 viewDir) {
     return finalTexCoords;
 }
 
+// Relaxed cone step mapping. Every step jumps to where the ray leaves the cone stored at its
+// position; the cone lets the ray cross the surface at most once, so a few steps land just past
+// the surface and a short binary search over the last step finds it
+vec2 ConeStepMapping(vec2 texCoords, vec3 viewDir, float depthScale) {
+    // More steps at grazing angles, where the ray travels further
+    const float minSteps = 3;
+    const float maxSteps = 6;
+    const int refinementSteps = 4;
+    int numSteps = int(mix(maxSteps, minSteps, abs(viewDir.z)) + 0.5);
+
+    // The ray through the depth volume, moving one unit of depth per unit of z
+    vec3 rayDir = vec3(-viewDir.xy / viewDir.z * depthScale, 1.0);
+    float rayRatio = length(rayDir.xy);
+
+    vec3 position = vec3(texCoords, 0.0);
+    vec3 lastStep = vec3(0.0);
+    for (int i = 0; i < numSteps; i++) {
+        vec2 cone = textureLod(coneMap, position.xy, 0.0).rg;
+        float coneRatio = cone.g * cone.g;
+        float height = max(cone.r - position.z, 0.0);
+
+        // Where the ray meets the side of the cone. Once under the surface it stays put
+        float stepLength = coneRatio * height / max(rayRatio + coneRatio, 0.0001);
+        if (stepLength > 0.0) {
+            lastStep = rayDir * stepLength;
+        }
+        position += rayDir * stepLength;
+    }
+
+    // The surface lies within the last step when the ray ended up under it
+    if (textureLod(coneMap, position.xy, 0.0).r < position.z) {
+        vec3 range = lastStep * 0.5;
+        position -= range;
+        for (int i = 0; i < refinementSteps; i++) {
+            range *= 0.5;
+            if (textureLod(coneMap, position.xy, 0.0).r > position.z) {
+                position += range;
+            } else {
+                position -= range;
+            }
+        }
+    }
+    return position.xy;
+}
+
 void main() {
     // Offset texture coordinates with parallax mapping
     vec3 viewDir = normalize(fs_in.TangentViewPos - fs_in.TangentFragPos);
     vec2 texCoords = fs_in.TexCoords;
-
-    texCoords = ParallaxMapping(fs_in.TexCoords, viewDir);
+    dx = dFdx(fs_in.TexCoords);
+    dy = dFdy(fs_in.TexCoords);
+
+    // Far away or heavily minified, the shift is too small to see: the depth fades out with
+    // distance and mip level, and past both limits no ray is marched at all
+    float viewDistance = length(fs_in.TangentViewPos - fs_in.TangentFragPos);
+    vec2 texels = vec2(textureSize(diffuseMap, 0));
+    float lod = 0.5 * log2(max(dot(dx * texels, dx * texels), dot(dy * texels, dy * texels)));
+    float fade = (1.0 - smoothstep(fallbackDistance.x, fallbackDistance.y, viewDistance)) * (1.0 - smoothstep(fallbackLod.x, fallbackLod.y, lod));
+
+    if (fade > 0.0) {
+        if (coneStepMapping) {
+            texCoords = ConeStepMapping(fs_in.TexCoords, viewDir, heightScale * fade);
+        } else {
+            texCoords = ParallaxMapping(fs_in.TexCoords, viewDir, heightScale * fade);
+        }
+    }
     if(texCoords.x > 1.0 || texCoords.y > 1.0 || texCoords.x < 0.0 || texCoords.y < 0.0) {
         discard;
     }
 
-    // Obtain normal from normal map in range [0, 1]
-    vec3 normal = texture(normalMap, fs_in.TexCoords).rgb;
+    // Obtain normal from normal map in range [0, 1]. Only x and y are read so the map can be
+    // stored as two-channel BC5; z is rebuilt as the normal has unit length
+    vec2 normalXY = textureGrad(normalMap, texCoords, dx, dy).rg;
     // Transform normal vector to range [-1, 1]
-    normal = normalize(normal * 2.0 - 1.0); // This normal is in tangent space
+    normalXY = normalXY * 2.0 - 1.0;
+    vec3 normal = normalize(vec3(normalXY, sqrt(max(1.0 - dot(normalXY, normalXY), 0.0)))); // This normal is in tangent space
 
     // Diffuse color
-    vec3 color = texture(diffuseMap, fs_in.TexCoords).rgb;
+    vec3 color = textureGrad(diffuseMap, texCoords, dx, dy).rgb;
 
     // Ambient
     vec3 ambient = 0.1 * color;
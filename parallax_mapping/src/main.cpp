@@ -7,8 +7,10 @@
 #include <iostream>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../common/code/header/TextureLoader.h"
+#include "../../common/code/header/ConeStepMap.h"
+#include "../../common/code/header/GpuTimer.h"
 
 #include <iostream>
 
@@ -20,7 +22,6 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 void renderQuad();
 
 // settings
@@ -28,6 +29,14 @@ const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 float heightScale = 0.1;
 
+// Relaxed cone step mapping in place of the linear layer search; C toggles
+bool coneStepMapping = true;
+bool coneStepKeyPressed = false;
+
+// Parallax fades out to plain normal mapping between these view distances and mip levels
+vec2 fallbackDistance(4.0f, 8.0f);
+vec2 fallbackLod(1.5f, 3.0f);
+
 // camera
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
 float lastX = (float)SCR_WIDTH / 2.0;
@@ -80,20 +89,52 @@ int main() {
     // Build and compile shaders
     Shader shader("parallax.vs", "parallax.fs");
 
-    // Load textures
-    unsigned int diffuseMap = loadTexture("bricks2.jpg");
-    unsigned int normalMap = loadTexture("bricks2_normal.jpg");
-    unsigned int heightMap = loadTexture("bricks2_disp.jpg");
+    // Load textures; the three maps are decoded at the same time on worker threads
+    vector<Texture_Options> mapOptions(3);
+    mapOptions[1].usage = TEXTURE_NORMAL;
+    mapOptions[2].usage = TEXTURE_HEIGHT;
+    vector<unsigned int> maps = loadTextures({ "bricks2.jpg", "bricks2_normal.jpg", "bricks2_disp.jpg" }, mapOptions);
+    unsigned int diffuseMap = maps[0];
+    unsigned int normalMap = maps[1];
+    unsigned int heightMap = maps[2];
+
+    // Precompute the cone step map from the same depth map on every core
+    unsigned int coneMap;
+    glGenTextures(1, &coneMap);
+    Texture_Image depthImage;
+    if (decodeImage("bricks2_disp.jpg", depthImage)) {
+        double coneStart = glfwGetTime();
+        vector<unsigned char> cones = generateConeStepMap(depthImage.pixels.get(), depthImage.width, depthImage.height, depthImage.nrComponents, Cone_Step_Settings());
+        cout << "Cone step map: " << depthImage.width << "x" << depthImage.height << " in " << (glfwGetTime() - coneStart) * 1000.0 << " ms" << endl;
+
+        // Marched at level 0 only, so no mip chain. Rows of two bytes per texel aren't 4 byte aligned
+        glBindTexture(GL_TEXTURE_2D, coneMap);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, depthImage.width, depthImage.height, 0, GL_RG, GL_UNSIGNED_BYTE, cones.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    } else {
+        cout << "Failed to load the depth map for the cone step map" << endl;
+        coneStepMapping = false;
+    }
 
     // Shader configuration
     shader.use();
     shader.setInt("diffuseMap", 0);
     shader.setInt("normalMap", 1);
     shader.setInt("depthMap", 2);
+    shader.setInt("coneMap", 3);
+    shader.setVec2("fallbackDistance", fallbackDistance);
+    shader.setVec2("fallbackLod", fallbackLod);
 
     // Lighting info
     vec3 lightPos(0.5f, 1.0f, 0.3f);
 
+    GpuTimer parallaxTimer;
+
    
     // render loop
     // -----------
@@ -127,15 +168,16 @@ int main() {
         shader.setVec3("viewPos", camera.Position);
         shader.setVec3("lightPos", lightPos);
         shader.setFloat("heightScale", heightScale);
-        cout << heightScale << endl;
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMap);
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, normalMap);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, heightMap);
+        shader.setBool("coneStepMapping", coneStepMapping);
+        cout << heightScale << " | " << (coneStepMapping ? "cone step" : "layers") << ": " << parallaxTimer.averageMilliseconds() << " ms" << endl;
+
+        bindTexture(0, diffuseMap);
+        bindTexture(1, normalMap);
+        bindTexture(2, heightMap);
+        bindTexture(3, coneMap);
+        parallaxTimer.begin();
         renderQuad();
+        parallaxTimer.end();
 
         // Render light source (simply re-renders a smaller plane at the lights position for visualization
         model = mat4(1.0f);
@@ -150,6 +192,8 @@ int main() {
         glfwPollEvents();
     }
 
+    glDeleteTextures(1, &coneMap);
+
     glfwTerminate();
     return 0;
 }
@@ -281,6 +325,15 @@ void processInput(GLFWwindow* window) {
             heightScale = 1.0f;
         }
     }
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !coneStepKeyPressed) {
+        coneStepMapping = !coneStepMapping;
+        coneStepKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        coneStepKeyPressed = false;
+    }
 }
 
 // GLFW: whenever the window size changed (by OS or user resize) this callback function executes
@@ -311,37 +364,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // For this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -5,10 +5,15 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cmath>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/ShadowCache.h"
+#include "../../../common/code/header/GpuTimer.h"
 
 #include <iostream>
 
@@ -20,15 +25,65 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 void renderScene(const Shader& shader);
-void renderCube();
+void renderCasters(const Shader& shader, bool dynamic);
+void buildScene();
+void animateScene(float time);
+void renderCube(unsigned int instances = 1);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 bool shadows = true;
 bool shadowsKeyPressed = false;
+int pcfSamples = 8;                 // Poisson taps per fragment, 4 to 16; 4 where they all agree
+float pcfRadius = 1.5f;             // Scales the filter disk
+bool lightMoving = true;
+bool lightMovingKeyPressed = false;
+bool shadowCaching = true;          // Draw the static casters into a cached map only when the light moves
+bool shadowCachingKeyPressed = false;
+
+// An object of the scene. Dynamic casters are drawn into the shadow map every frame, static
+// ones only when the cache is rebuilt
+struct Caster {
+    mat4 model;
+    vec3 center;        // Bounding sphere, to cull it against the cubemap faces
+    float radius;
+    bool room;
+    bool dynamic;
+};
+vector<Caster> casters;
+const unsigned int CUBE_TRIANGLES = 12;
+
+// How the depth cubemap is drawn. The geometry shader sends every triangle to all six faces;
+// the other two only draw a caster into the faces whose frustum it overlaps
+enum ShadowPath {
+    GEOMETRY_SHADER_PATH,   // One draw per caster, amplified six times in the geometry shader
+    PER_FACE_PATH,          // One draw per caster and visible face, into a single-face framebuffer
+    LAYERED_VERTEX_PATH     // One instanced draw per caster, the vertex shader picks the face
+};
+const char* SHADOW_PATH_NAMES[] = { "geometry shader", "per face", "layered vertex shader" };
+ShadowPath shadowPath = PER_FACE_PATH;
+bool shadowPathKeyPressed = false;
+bool runBenchmark = false;
+bool benchmarkKeyPressed = false;
+
+// Everything a depth cubemap draw needs besides the casters
+struct PointShadowPass {
+    ShadowPath path;
+    const Shader* shader;           // The program of path
+    vector<mat4> faceMatrices;
+    vec3 lightPos;
+    float nearPlane;
+    float farPlane;
+    unsigned int faceFramebuffer;   // Holds the one face the per-face path draws into
+};
+
+enum CasterSet { ALL_CASTERS, STATIC_CASTERS, DYNAMIC_CASTERS };
+
+int visibleFaces(const Caster& caster, const vec3& lightPos, float nearPlane, float farPlane);
+unsigned int renderShadowCasters(const PointShadowPass& pass, CasterSet set, unsigned int cubemap);
+bool layeredVertexShaderSupported();
 
 // camera
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
@@ -79,9 +134,18 @@ int main()
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
 
+    // Lets the filtered shadow taps blend across cubemap faces
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
     // Build and compile shaders
     Shader shader("point_shadows.vs", "point_shadows.fs");
     Shader simpleDepthShader("point_shadows_depth.vs", "point_shadows_depth.fs", "point_shadows_depth.gs");
+    Shader faceDepthShader("point_shadows_face.vs", "point_shadows_depth.fs");
+
+    // Writing gl_Layer from the vertex shader needs an extension; without it the path is skipped
+    bool layeredSupported = layeredVertexShaderSupported();
+    Shader* layeredDepthShader = layeredSupported ? new Shader("point_shadows_layer.vs", "point_shadows_depth.fs") : nullptr;
+    const Shader* pathShaders[] = { &simpleDepthShader, &faceDepthShader, layeredDepthShader };
 
     // Load textures
     unsigned int woodTexture = loadTexture("wood.png");
@@ -100,8 +164,10 @@ int main()
         glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
     }
     
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
@@ -114,6 +180,24 @@ int main()
     glReadBuffer(GL_NONE);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // The per-face path attaches one face at a time to this one
+    unsigned int faceFBO;
+    glGenFramebuffers(1, &faceFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, faceFBO);
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // Static casters as seen from cachedLightPos
+    ShadowCache shadowCache(GL_TEXTURE_CUBE_MAP, SHADOW_WIDTH, 6);
+    vec3 cachedLightPos(0.0f);
+
+    // Shadow pass time for frames that draw every caster and for frames that reuse the cache
+    GpuTimer fullShadowTimer;
+    GpuTimer cachedShadowTimer;
+
+    buildScene();
+
     // Shader configuration
     shader.use();
     shader.setInt("diffuseTexture", 0);
@@ -121,6 +205,7 @@ int main()
 
     // Lighting info
     vec3 lightPos(0.0f, 0.0f, 0.0f);
+    float lightTime = 0.0f;
 
     // render loop
     // -----------
@@ -134,7 +219,17 @@ int main()
         // Input
         processInput(window);
 
-        lightPos.z = sin(glfwGetTime() * 0.5) * 3.0;
+        if (lightMoving) {
+            lightTime += deltaTime;
+        }
+        lightPos.z = sin(lightTime * 0.5) * 3.0;
+        animateScene(currentFrame);
+
+        // Every face of the cache is stale once the light has moved
+        if (lightPos != cachedLightPos) {
+            shadowCache.invalidate();
+            cachedLightPos = lightPos;
+        }
 
         // Render
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -154,19 +249,89 @@ int main()
 
 
         // 1. Render scene to depth cubemap
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        simpleDepthShader.use();
+        if (shadowPath == LAYERED_VERTEX_PATH && !layeredSupported) {
+            shadowPath = GEOMETRY_SHADER_PATH;
+        }
+
+        // Every path shares the fragment shader, so they all take the same uniforms
+        for (const Shader* depthShader : pathShaders) {
+            if (depthShader == nullptr) {
+                continue;
+            }
+
+            glUseProgram(depthShader->ID);
+            for (unsigned int i = 0; i < 6; ++i) {
+                depthShader->setMat4("shadowMatrices[" + to_string(i) + "]", shadowTransforms[i]);
+            }
+            depthShader->setFloat("far_plane", far_plane);
+            depthShader->setVec3("lightPos", lightPos);
+        }
+
+        PointShadowPass pass = { shadowPath, pathShaders[shadowPath], shadowTransforms, lightPos, near_plane, far_plane, faceFBO };
+
+        if (runBenchmark) {
+            // Each path draws the whole scene, repeated to scale up the triangle count, into the
+            // shadow map; the map is redrawn right after, so this doesn't show
+            runBenchmark = false;
+            cout << "Shadow pass benchmark (" << SHADOW_WIDTH << "x" << SHADOW_HEIGHT << " cubemap, average of 32 runs):" << endl;
+            for (unsigned int copies = 1; copies <= 64; copies *= 4) {
+                for (unsigned int path = GEOMETRY_SHADER_PATH; path <= LAYERED_VERTEX_PATH; path++) {
+                    if (pathShaders[path] == nullptr) {
+                        continue;
+                    }
+
+                    PointShadowPass benchmarkPass = pass;
+                    benchmarkPass.path = (ShadowPath)path;
+                    benchmarkPass.shader = pathShaders[path];
+
+                    glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+                    glFinish();
+                    double start = glfwGetTime();
+                    unsigned int triangles = 0;
+                    for (unsigned int run = 0; run < 32; run++) {
+                        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+                        glClear(GL_DEPTH_BUFFER_BIT);
+                        triangles = 0;
+                        for (unsigned int copy = 0; copy < copies; copy++) {
+                            triangles += renderShadowCasters(benchmarkPass, ALL_CASTERS, depthCubemap);
+                        }
+                    }
+                    glFinish();
+                    double milliseconds = (glfwGetTime() - start) * 1000.0 / 32.0;
+
+                    cout << "  " << copies << "x scene, " << SHADOW_PATH_NAMES[path] << ": " << triangles << " triangles, "
+                         << milliseconds << " ms" << endl;
+                }
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            shadowCache.invalidate();
+        }
 
-        for (unsigned int i = 0; i < 6; ++i) {
-            simpleDepthShader.setMat4("shadowMatrices[" + to_string(i) +"]", shadowTransforms[i]);
+        unsigned int shadowTriangles = 0;
+        bool redrawn = !shadowCaching || shadowCache.dirtyMask() != 0;
+        GpuTimer& shadowTimer = redrawn ? fullShadowTimer : cachedShadowTimer;
+        shadowTimer.begin();
+
+        if (shadowCaching) {
+            // Redraw the static casters only if the cache is stale, then start from a copy of it
+            if (shadowCache.dirtyMask() != 0) {
+                shadowCache.beginRebuild();
+                shadowTriangles += renderShadowCasters(pass, STATIC_CASTERS, shadowCache.texture());
+                shadowCache.endRebuild();
+            }
+            shadowCache.copyTo(depthCubemap);
+
+            glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            shadowTriangles += renderShadowCasters(pass, DYNAMIC_CASTERS, depthCubemap);
+        } else {
+            glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            shadowTriangles += renderShadowCasters(pass, ALL_CASTERS, depthCubemap);
         }
-        
-        simpleDepthShader.setFloat("far_plane", far_plane);
-        simpleDepthShader.setVec3("lightPos", lightPos);
-        renderScene(simpleDepthShader);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        shadowTimer.end();
 
         // 2. Render scene as normal using the generated depth/shadow map  
         glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
@@ -182,74 +347,209 @@ int main()
         shader.setVec3("lightPos", lightPos);
         shader.setInt("shadows", shadows);
         shader.setFloat("far_plane", far_plane);
+        shader.setInt("pcfSamples", pcfSamples);
+        shader.setFloat("pcfRadius", pcfRadius);
 
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
+        bindTexture(0, woodTexture);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_CUBE_MAP, depthCubemap);
         renderScene(shader);
 
+        // Time saved is what a full redraw costs over reusing the cache
+        float savedMs = 0.0f;
+        if (fullShadowTimer.averageMilliseconds() > 0.0f && cachedShadowTimer.averageMilliseconds() > 0.0f) {
+            savedMs = std::max(fullShadowTimer.averageMilliseconds() - cachedShadowTimer.averageMilliseconds(), 0.0f);
+        }
+        cout << "Shadow path: " << SHADOW_PATH_NAMES[shadowPath] << " | triangles: " << shadowTriangles
+             << " | caching: " << (shadowCaching ? "on" : "off") << " | shadow pass: " << (redrawn ? "redrawn" : "cached")
+             << " | full: " << fullShadowTimer.averageMilliseconds() << " ms | cached: " << cachedShadowTimer.averageMilliseconds()
+             << " ms | saved per frame: " << savedMs << " ms" << endl;
+
         // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window);
         glfwPollEvents();
     }
 
+    delete layeredDepthShader;
+
     glfwTerminate();
     return 0;
 }
 
-// Renders the 3D scene
-void renderScene(const Shader& shader) {
-
+// Sets up the objects of the 3D scene
+void buildScene() {
     // room cube
     mat4 model = mat4(1.0f);
     model = scale(model, vec3(5.0f));
-    shader.setMat4("model", model);
-    glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
-    shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
-    renderCube();
-
-    shader.setInt("reverse_normals", 0); // and of course disable it
-    glEnable(GL_CULL_FACE);
+    casters.push_back({ model, vec3(0.0f), 5.0f * sqrt(3.0f), true, false });
 
     // cubes
     model = mat4(1.0f);
     model = translate(model, vec3(4.0f, -3.5f, 0.0));
     model = scale(model, vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(4.0f, -3.5f, 0.0f), 0.5f * sqrt(3.0f), false, false });
 
     model = mat4(1.0f);
     model = translate(model, vec3(2.0f, 3.0f, 1.0));
     model = scale(model, vec3(0.75f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(2.0f, 3.0f, 1.0f), 0.75f * sqrt(3.0f), false, false });
 
     model = mat4(1.0f);
     model = translate(model, vec3(-3.0f, -1.0f, 0.0));
     model = scale(model, vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(-3.0f, -1.0f, 0.0f), 0.5f * sqrt(3.0f), false, false });
 
     model = mat4(1.0f);
     model = translate(model, vec3(-1.5f, 1.0f, 1.5));
     model = scale(model, vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(-1.5f, 1.0f, 1.5f), 0.5f * sqrt(3.0f), false, false });
 
-    model = mat4(1.0f);
+    // Spinning cube, set by animateScene()
+    casters.push_back({ mat4(1.0f), vec3(-1.5f, 2.0f, -3.0f), 0.75f * sqrt(3.0f), false, true });
+}
+
+// Moves the dynamic casters
+void animateScene(float time) {
+    mat4 model = mat4(1.0f);
     model = translate(model, vec3(-1.5f, 2.0f, -3.0));
-    model = rotate(model, radians(60.0f), normalize(vec3(1.0, 0.0, 1.0)));
+    model = rotate(model, radians(60.0f) + time * 0.5f, normalize(vec3(1.0, 0.0, 1.0)));
     model = scale(model, vec3(0.75f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.back().model = model;
+}
+
+void renderCaster(const Shader& shader, const Caster& caster, unsigned int instances = 1) {
+    shader.setMat4("model", caster.model);
+    if (caster.room) {
+        glDisable(GL_CULL_FACE); // note that we disable culling here since we render 'inside' the cube instead of the usual 'outside' which throws off the normal culling methods.
+        shader.setInt("reverse_normals", 1); // A small little hack to invert normals when drawing cube from the inside so lighting still works.
+        renderCube(instances);
+
+        shader.setInt("reverse_normals", 0); // and of course disable it
+        glEnable(GL_CULL_FACE);
+    } else {
+        renderCube(instances);
+    }
+}
+
+// Renders the 3D scene
+void renderScene(const Shader& shader) {
+    for (const Caster& caster : casters) {
+        renderCaster(shader, caster);
+    }
+}
+
+// Renders only the dynamic or only the static casters
+void renderCasters(const Shader& shader, bool dynamic) {
+    for (const Caster& caster : casters) {
+        if (caster.dynamic == dynamic) {
+            renderCaster(shader, caster);
+        }
+    }
+}
+
+// Faces of the cubemap, one bit each in the order of the shadow matrices, whose frustum the
+// caster's bounding sphere overlaps. Each face looks down one axis with a 90 degree field of view,
+// so its four side planes are where that axis and one of the other two are equally far out
+int visibleFaces(const Caster& caster, const vec3& lightPos, float nearPlane, float farPlane) {
+    vec3 position = caster.center - lightPos;
+    float slack = caster.radius * sqrt(2.0f);
+
+    int mask = 0;
+    for (int face = 0; face < 6; face++) {
+        int axis = face / 2;
+        float depth = (face % 2 == 0) ? position[axis] : -position[axis];
+        float side1 = position[(axis + 1) % 3];
+        float side2 = position[(axis + 2) % 3];
+
+        bool inside = depth + caster.radius > nearPlane && depth - caster.radius < farPlane
+            && depth - abs(side1) > -slack && depth - abs(side2) > -slack;
+        if (inside) {
+            mask |= 1 << face;
+        }
+    }
+    return mask;
+}
+
+// Renders the casters of set into cubemap along pass.path and returns the triangles sent to the
+// rasterizer. The geometry shader and layered paths draw into the layered framebuffer that is
+// bound; the per-face path binds pass.faceFramebuffer with one face of cubemap at a time
+unsigned int renderShadowCasters(const PointShadowPass& pass, CasterSet set, unsigned int cubemap) {
+    glUseProgram(pass.shader->ID);
+    unsigned int triangles = 0;
+
+    vector<int> masks(casters.size());
+    for (unsigned int i = 0; i < casters.size(); i++) {
+        masks[i] = visibleFaces(casters[i], pass.lightPos, pass.nearPlane, pass.farPlane);
+    }
+
+    auto included = [set](const Caster& caster) {
+        return set == ALL_CASTERS || caster.dynamic == (set == DYNAMIC_CASTERS);
+    };
+
+    if (pass.path == GEOMETRY_SHADER_PATH) {
+        for (const Caster& caster : casters) {
+            if (included(caster)) {
+                renderCaster(*pass.shader, caster);
+                triangles += 6 * CUBE_TRIANGLES;
+            }
+        }
+    } else if (pass.path == PER_FACE_PATH) {
+        GLint layeredFramebuffer;
+        glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &layeredFramebuffer);
+
+        glBindFramebuffer(GL_FRAMEBUFFER, pass.faceFramebuffer);
+        for (int face = 0; face < 6; face++) {
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, cubemap, 0);
+            pass.shader->setMat4("shadowMatrix", pass.faceMatrices[face]);
+            for (unsigned int i = 0; i < casters.size(); i++) {
+                if (included(casters[i]) && (masks[i] & (1 << face))) {
+                    renderCaster(*pass.shader, casters[i]);
+                    triangles += CUBE_TRIANGLES;
+                }
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, layeredFramebuffer);
+    } else {
+        for (unsigned int i = 0; i < casters.size(); i++) {
+            if (!included(casters[i]) || masks[i] == 0) {
+                continue;
+            }
+
+            // Instance n draws into the nth visible face
+            unsigned int instances = 0;
+            for (int face = 0; face < 6; face++) {
+                if (masks[i] & (1 << face)) {
+                    pass.shader->setInt("faces[" + to_string(instances) + "]", face);
+                    instances++;
+                }
+            }
+            renderCaster(*pass.shader, casters[i], instances);
+            triangles += instances * CUBE_TRIANGLES;
+        }
+    }
+    return triangles;
+}
+
+// gl_Layer can only be written from the vertex shader with one of these extensions
+bool layeredVertexShaderSupported() {
+#ifdef GL_ARB_shader_viewport_layer_array
+    if (GLAD_GL_ARB_shader_viewport_layer_array) {
+        return true;
+    }
+#endif
+#ifdef GL_AMD_vertex_shader_layer
+    if (GLAD_GL_AMD_vertex_shader_layer) {
+        return true;
+    }
+#endif
+    return false;
 }
 
 
 // renderCube() renders a 1x1 3D cube in NDC.
 unsigned int cubeVAO = 0;
 unsigned int cubeVBO = 0;
-void renderCube() {
+void renderCube(unsigned int instances) {
     // initialize (if necessary)
     if (cubeVAO == 0) {
         float vertices[] = {
@@ -322,7 +622,11 @@ void renderCube() {
     }
     // Render Cube
     glBindVertexArray(cubeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 36);
+    if (instances == 1) {
+        glDrawArrays(GL_TRIANGLES, 0, 36);
+    } else {
+        glDrawArraysInstanced(GL_TRIANGLES, 0, 36, instances);
+    }
     glBindVertexArray(0);
 }
 
@@ -348,6 +652,43 @@ void processInput(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_RELEASE) {
         shadowsKeyPressed = false;
     }
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && !lightMovingKeyPressed) {
+        lightMoving = !lightMoving;
+        lightMovingKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE) {
+        lightMovingKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && !shadowCachingKeyPressed) {
+        shadowCaching = !shadowCaching;
+        shadowCachingKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE) {
+        shadowCachingKeyPressed = false;
+    }
+
+    // G cycles the shadow paths; main() skips the layered one when it isn't supported
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_PRESS && !shadowPathKeyPressed) {
+        shadowPath = (ShadowPath)((shadowPath + 1) % 3);
+        shadowPathKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_G) == GLFW_RELEASE) {
+        shadowPathKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_PRESS && !benchmarkKeyPressed) {
+        runBenchmark = true;
+        benchmarkKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_B) == GLFW_RELEASE) {
+        benchmarkKeyPressed = false;
+    }
 }
 
 // GLFW: whenever the window size changed (by OS or user resize) this callback function executes
@@ -378,37 +719,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // For this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -9,24 +9,29 @@ in VS_OUT {
 } fs_in;
 
 uniform sampler2D diffuseTexture;
-uniform samplerCube depthMap;
+uniform samplerCubeShadow depthMap; // Each fetch compares 4 texels against the reference and filters the results
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
 uniform float far_plane;
 uniform bool shadows;
-
-// Array of offset direction for sampling
-vec3 gridSamplingDisk[20] = vec3[](
-   vec3(1, 1,  1), vec3( 1, -1,  1), vec3(-1, -1,  1), vec3(-1, 1,  1),
-   vec3(1, 1, -1), vec3( 1, -1, -1), vec3(-1, -1, -1), vec3(-1, 1, -1),
-   vec3(1, 1,  0), vec3( 1, -1,  0), vec3(-1, -1,  0), vec3(-1, 1,  0),
-   vec3(1, 0,  1), vec3(-1,  0,  1), vec3( 1,  0, -1), vec3(-1, 0, -1),
-   vec3(0, 1,  1), vec3( 0, -1,  1), vec3( 0, -1, -1), vec3( 0, 1, -1)
+uniform int pcfSamples;    // Poisson taps per fragment, 4 to 16
+uniform float pcfRadius;   // Scales the disk; 1.5 covers about what the old 20-tap grid did
+
+// Poisson disk, ordered so the first four taps lie far apart, one in each quadrant
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725), vec2( 0.97484398,  0.75648379), vec2(-0.81409955,  0.91437590),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760), vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420), vec2(-0.26496911, -0.41893023),
+    vec2( 0.79197514,  0.19090188), vec2(-0.24188840,  0.99706507), vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100161)
 );
 
-
+// Per-pixel angle to rotate the kernel by, so the banding of a few taps turns into fine noise
+float KernelAngle() {
+    float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    return noise * 6.28318531;
+}
 
 float ShadowCalculation(vec3 fragPos) {
     // Get vector between Fragment position and light position
@@ -35,23 +40,33 @@ float ShadowCalculation(vec3 fragPos) {
     // Now get the current linear depth as the length between fragment and light position
     float currentDepth = length(fragToLight);
 
-    float shadow = 0.0;
     float bias = 0.15;
-    float samples = 20;
     float viewDistance = length(viewPos - fragPos);
-    float diskRadius = (1.0 + (viewDistance / far_plane)) / 25.0;
-
-    for(int i = 0; i < samples; i++) {
-        float closestDepth = texture(depthMap, fragToLight + gridSamplingDisk[i] * diskRadius).r;
-        closestDepth *= far_plane; // Undo [0;1] mapping
-        if(currentDepth - bias > closestDepth) {
-            shadow += 1.0;
+    float diskRadius = (1.0 + (viewDistance / far_plane)) / 25.0 * pcfRadius;
+
+    // The depth map holds distances divided by far_plane
+    float reference = (currentDepth - bias) / far_plane;
+
+    // The disk lies in the plane across the direction to the light, rotated per pixel
+    vec3 axis = fragToLight / currentDepth;
+    vec3 tangent = normalize(cross(axis, abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0)));
+    vec3 bitangent = cross(axis, tangent);
+    float angle = KernelAngle();
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+
+    float lit = 0.0;
+    int samples = clamp(pcfSamples, 4, 16);
+    for (int i = 0; i < samples; i++) {
+        vec2 offset = rotation * poissonDisk[i] * diskRadius;
+        lit += texture(depthMap, vec4(fragToLight + tangent * offset.x + bitangent * offset.y, reference));
+
+        // Fully lit or fully shadowed at all four outer taps: not in a penumbra, so the rest
+        // of the taps would agree as well
+        if (i == 3 && (lit < 0.001 || lit > 3.999)) {
+            return 1.0 - lit / 4.0;
         }
     }
-
-    shadow /= float(samples);
-    return shadow;
-
+    return 1.0 - lit / float(samples);
 }
 
 void main() {
@@ -0,0 +1,12 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 shadowMatrix; // Light space of the one face being drawn
+
+out vec4 FragPos;
+
+void main() {
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrix * FragPos;
+}
@@ -0,0 +1,19 @@
+#version 330 core
+#extension GL_ARB_shader_viewport_layer_array : enable
+#extension GL_AMD_vertex_shader_layer : enable
+layout (location = 0) in vec3 aPos;
+
+uniform mat4 model;
+uniform mat4 shadowMatrices[6];
+uniform int faces[6]; // Faces the object is visible in; instance i draws into faces[i]
+
+out vec4 FragPos;
+
+// Picks the cubemap face in the vertex shader, so one instanced draw fills every face the object
+// touches without a geometry shader
+void main() {
+    int face = faces[gl_InstanceID];
+    FragPos = model * vec4(aPos, 1.0);
+    gl_Position = shadowMatrices[face] * FragPos;
+    gl_Layer = face;
+}
@@ -0,0 +1,136 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <vector>
+
+using namespace std;
+using namespace glm;
+
+// Defines several possible options for camera movement. Used as abstraction
+// to stay away from window-system specific input methods
+
+enum Camera_Movement {
+	FORWARD,
+	BACKWARD,
+	LEFT,
+	RIGHT
+};
+
+// Default camera values
+const float YAW = -90.0f;
+const float PITCH = 0.0f;
+const float SPEED = 2.5f;
+const float SENSITIVITY = 0.1f;
+const float ZOOM = 45.0f;
+
+// An abstract camera class that processes input and calculate 
+// the corresponding Euler Angles, Vectors and matrices for use in OpenGL
+class Camera {
+public:
+	// Camera attributes
+	vec3 Position;
+	vec3 Front;
+	vec3 Up;
+	vec3 Right;
+	vec3 WorldUp;
+
+	// Euler angles
+	float Yaw;
+	float Pitch;
+
+	// Camera Options
+	float MovementSpeed;
+	float MouseSensitivity;
+	float Zoom;
+
+	// Constructor with vectors
+	Camera(vec3 position = vec3(0.0f, 0.0f, 0.0f), vec3 up = vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH)
+		: Front(vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM) {
+		Position = position;
+		WorldUp = up;
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
+	// Constructor camera with scalar values
+	Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) 
+		: Front(vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM) {
+		Position = vec3(posX, posY, posZ);
+		WorldUp = vec3(upX, upY, upZ);
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
+	// Returns the view matrix calculated using Euler Angles and the LookAt matrix
+	mat4 GetViewMatrix() {
+		return lookAt(Position, Position + Front, Up);
+	}
+
+	// Processes input recieved from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM
+	void ProcessKeyboard(Camera_Movement direction, float deltaTime) {
+		float velocity = MovementSpeed * deltaTime;
+
+		if (direction == FORWARD)
+			Position += Front * velocity;
+		if (direction == BACKWARD)
+			Position -= Front * velocity;
+		if (direction == LEFT)
+			Position -= Right * velocity;
+		if (direction == RIGHT)
+			Position += Right * velocity;
+	}
+
+	// Processes input recieved from a mouse input system. Expects the offset value in both the x and y direction
+	void ProcessMouseMovement(float xoffset, float yoffset, GLboolean constrainPitch = true) {
+		xoffset *= MouseSensitivity;
+		yoffset *= MouseSensitivity;
+
+		Yaw += xoffset;
+		Pitch += yoffset;
+
+		// Make sure that when pitch is out of bounds, screen doesn't get flipped
+		if (constrainPitch) {
+			if (Pitch > 89.0f)
+				Pitch = 89.0f;
+			if (Pitch < -89.0f)
+				Pitch = -89.0f;
+		}
+
+		// Update Front, Right, and Up vectors using updated Euler angles
+		updateCameraVectors();
+	}
+
+	// Processes input recieved from a mouse scroll-wheel event. Only requries input on the vertical wheel-axis
+	void ProcessMouseScroll(float yoffset) {
+		Zoom -= (float)yoffset;
+		if (Zoom < 1.0f)
+			Zoom = 1.0f;
+		if (Zoom > 45.0f)
+			Zoom = 45.0f;
+	}
+
+private:
+	// Calculates the front vector from the Camera's (updated) Euler Angles	
+	void updateCameraVectors() {
+		vec3 front;
+		front.x = cos(radians(Yaw)) * cos(radians(Pitch));
+		front.y = sin(radians(Pitch));
+		front.z = sin(radians(Yaw)) * cos(radians(Pitch));
+
+		// Normalize front vector of camera
+		Front = normalize(front);
+
+		// Also recalculate the Right and Up vector
+		Right = normalize(cross(Front, WorldUp)); // Normalize the vectors because their length gets closer to 0 the more you look up or down, resulting in slower movement
+		Up = normalize(cross(Right, Front));
+
+	}
+};
+
+#endif
\ No newline at end of file
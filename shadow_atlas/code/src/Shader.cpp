@@ -0,0 +1,203 @@
+#include "../header/Shader.h"
+
+using namespace std;
+
+// Constructor to read, compile and build shader
+Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath) {
+	// Get the vertex and shader ID's and the file handles
+	string vertexCode;
+	string fragmentCode;
+	string geometryCode;
+	ifstream vShaderFile;
+	ifstream fShaderFile;
+	ifstream gShaderFile;
+
+	// Ensure that the ifstream objects can throw exceptions
+	vShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+	fShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+	gShaderFile.exceptions(ifstream::failbit | ifstream::badbit);
+
+	try {
+		// Open the files
+		vShaderFile.open(vertexPath);
+		fShaderFile.open(fragmentPath);
+		stringstream vShaderStream, fShaderStream;
+
+		// Read file's buffer contents into streams
+		vShaderStream << vShaderFile.rdbuf();
+		fShaderStream << fShaderFile.rdbuf();
+
+		// Close file handles
+		vShaderFile.close();
+		fShaderFile.close();
+
+		// Convert stream into string
+		vertexCode = vShaderStream.str();
+		fragmentCode = fShaderStream.str();
+
+		// If a geometry shader is present, load it in as well
+		if (geometryPath != nullptr) {
+			gShaderFile.open(geometryPath);
+			stringstream gShaderStream;
+			gShaderStream << gShaderFile.rdbuf();
+			gShaderFile.close();
+			geometryCode = gShaderStream.str();
+		}
+
+	} catch (ifstream::failure e) {
+		cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << endl;
+	}
+
+	// Convert the shaders into a C-string
+	const char* vShaderCode = vertexCode.c_str();
+	const char* fShaderCode = fragmentCode.c_str();
+
+	// Compile Shaders
+	unsigned int vertex, fragment; // Variables for storing IDs
+	int success; // Compilation or linking state
+	char infoLog[512]; // Info Log
+
+	// Vertex Shader
+	vertex = glCreateShader(GL_VERTEX_SHADER);
+	glShaderSource(vertex, 1, &vShaderCode, NULL);
+	glCompileShader(vertex);
+
+	// Print and compile errors, if any
+	glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(vertex, 512, NULL, infoLog);
+		cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << endl;
+	}
+
+	// Fragment Shader
+	fragment = glCreateShader(GL_FRAGMENT_SHADER);
+	glShaderSource(fragment, 1, &fShaderCode, NULL);
+	glCompileShader(fragment);
+
+	// Print and compile errors, if any
+	glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		glGetShaderInfoLog(fragment, 512, NULL, infoLog);
+		cout << "ERROR::SHADER:FRAGMENT::COMPILATION_FAILED\n" << infoLog << endl;
+	}
+
+	// If geometry shader is given, compile it
+	unsigned int geometry;
+	if (geometryPath != nullptr) {
+		const char* gShaderCode = geometryCode.c_str();
+		geometry = glCreateShader(GL_GEOMETRY_SHADER);
+		glShaderSource(geometry, 1, &gShaderCode, NULL);
+		glCompileShader(geometry);
+		checkCompileErrors(geometry, "GEOMETRY");
+	}
+
+	// Build the program
+	Shader::ID = glCreateProgram();
+	glAttachShader(ID, vertex);
+	glAttachShader(ID, fragment);
+	if (geometryPath != nullptr) {
+		glAttachShader(ID, geometry);
+	}
+
+	glLinkProgram(ID);
+
+	// Print linking errors, if any
+	glGetProgramiv(ID, GL_LINK_STATUS, &success);
+	if (!success) {
+		glGetProgramInfoLog(ID, 512, NULL, infoLog);
+		cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << endl;
+	}
+
+	// Delete the shaders as they're linked as they are no longer needed
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	if (geometryPath != nullptr) {
+		glDeleteShader(geometry);
+	}
+}
+
+// Sets the program created by this class to the currently used program for rendering
+void Shader::use() {
+	glUseProgram(Shader::ID);
+}
+
+// Set the boolean value of a uniform variable
+void Shader::setBool(const string& name, bool value) const {
+	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+}
+
+// Set the integer value of uniform variable
+void Shader::setInt(const string& name, int value) const {
+	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+}
+
+// Set the float value of a uniform variable
+void Shader::setFloat(const string& name, float value) const {
+	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+}
+
+// Set the 2D vector value of a uniform variable
+void Shader::setVec2(const string& name, const vec2& value) const {
+	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
+// Set the 2D vector value of a uniform variable
+void Shader::setVec2(const string& name, float x, float y) const {
+	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+}
+
+// Set the 3D vector value of a uniform variable
+void Shader::setVec3(const string& name, const vec3& value) const {
+	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
+// Set the 3D vector value of a uniform variable
+void Shader::setVec3(const string& name, float x, float y, float z) const {
+	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+}
+
+// Set the 4D vector value of a uniform variable
+void Shader::setVec4(const string& name, const vec4& value) const {
+	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+}
+
+// Set the 4D vector value of a uniform variable
+void Shader::setVec4(const string& name, float x, float y, float z, float w) const {
+	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+}
+
+// Set the 2 by 2 matrix value of a uniform variable
+void Shader::setMat2(const string& name, const mat2& mat) const {
+	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+}
+
+// Set the 3 by 3 matrix value of a uniform variable
+void Shader::setMat3(const string& name, const mat3& mat) const {
+	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+}
+
+// Set the 4 by 4 matrix value of a uniform variable
+void Shader::setMat4(const string& name, const mat4& mat) const {
+	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::checkCompileErrors(GLuint shader, string type) {
+	GLint success;
+	GLchar infoLog[1024];
+
+	if (type != "PROGRAM") {
+
+		glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+		if (!success) {
+			glGetShaderInfoLog(shader, 1024, NULL, infoLog);
+			cout << "ERROR::SHADER::COMPILATION_ERROR of type: " << type << "\n" << infoLog << "\n" << "\n-- -------------------------------------- -- \n";
+		}
+
+	} else {
+		glGetProgramiv(shader, GL_LINK_STATUS, &success);
+		if (!success) {
+			glGetProgramInfoLog(shader, 1024, NULL, infoLog);
+			cout << "ERROR::PROGRAM_LINKING_ERROR of type " << type << "\n" << infoLog << "\n-- -------------------------------------- -- \n";
+		}
+	}
+}
\ No newline at end of file
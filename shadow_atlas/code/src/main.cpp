@@ -0,0 +1,619 @@
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cmath>
+
+#include "../header/Shader.h"
+#include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/TextureStreamer.h"
+#include "../../../common/code/header/ShadowAtlas.h"
+#include "../../../common/code/header/GpuTimer.h"
+
+using namespace std;
+using namespace glm;
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void mouse_callback(GLFWwindow* window, double xpos, double ypos);
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
+void processInput(GLFWwindow* window);
+void renderCube();
+
+// settings
+const unsigned int SCR_WIDTH = 800;
+const unsigned int SCR_HEIGHT = 600;
+
+// shadow atlas
+const unsigned int ATLAS_SIZE = 4096;          // One 24-bit depth texture for every light, 64 MB
+const unsigned int MAX_TILE_SIZE = 1024;
+const unsigned int MIN_TILE_SIZE = 64;
+const unsigned int MAX_LIGHTS = 32;            // MAX_LIGHTS and MAX_TILES of the lighting shader
+const unsigned int MAX_TILES = 96;
+unsigned int tilesPerFrame = 8;                // Shadow tiles drawn each frame; [ and ] change it
+bool tilesKeyPressed = false;
+bool lightsMoving = true;
+bool lightsMovingKeyPressed = false;
+
+// An object of the scene, with a bounding sphere to skip it for lights that can't reach it
+struct Caster {
+    mat4 model;
+    vec3 center;
+    float radius;
+    bool plane;
+};
+vector<Caster> casters;
+
+// The LightBlock uniform block of the lighting shader, member for member in std140 layout
+struct Gpu_Light {
+    vec3 position;
+    float range;
+    vec3 direction;
+    float cutoff;
+    vec3 color;
+    int type;
+    vec3 shadowPosition;
+    int firstTile;
+};
+
+struct Light_Block {
+    mat4 lightSpaceMatrices[MAX_LIGHTS];
+    vec4 shadowTiles[MAX_TILES];
+    Gpu_Light lights[MAX_LIGHTS];
+    int lightCount;
+    int padding[3];             // std140 rounds the block up to a whole vec4
+};
+
+struct Light {
+    Shadow_Light_Type type;
+    vec3 position;
+    vec3 direction;
+    vec3 color;
+    float range;
+    float outerAngle;           // Of a spot light's cone, in degrees
+    vec3 origin;                // Moving lights circle around it
+    float phase;
+    bool moving;
+    unsigned int atlasLight;
+
+    // Where the light was when its tiles were last drawn; the tiles are sampled with these until
+    // they are drawn again
+    vec3 shadowPosition;
+    mat4 shadowMatrix;
+};
+vector<Light> lights;
+
+// camera
+Camera camera(vec3(0.0f, 8.0f, 22.0f));
+float lastX = (float)SCR_WIDTH / 2.0;
+float lastY = (float)SCR_HEIGHT / 2.0;
+bool firstMouse = true;
+
+// timing
+float deltaTime = 0.0f;
+float lastFrame = 0.0f;
+
+// meshes
+unsigned int planeVAO;
+
+void buildScene();
+void buildLights(ShadowAtlas& atlas);
+void animateLights(float time);
+vector<mat4> lightTileMatrices(const Light& light);
+void renderScene(const Shader& shader);
+void renderShadowCasters(const Shader& shader, const Light& light);
+
+int main()
+{
+    // GLFW: initialize and configure
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // GLFW window creation
+    GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    if (window == NULL)
+    {
+        cout << "Failed to create GLFW window" << endl;
+        glfwTerminate();
+        return -1;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwSetCursorPosCallback(window, mouse_callback);
+    glfwSetScrollCallback(window, scroll_callback);
+
+    // Tell GLFW to capture our mouse
+    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+    // GLAD: load all OpenGL function pointers
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        cout << "Failed to initialize GLAD" << endl;
+        return -1;
+    }
+
+    // Configure global opengl state
+    glEnable(GL_DEPTH_TEST);
+
+    // Build and compile shaders
+    Shader shader("atlas_lighting.vs", "atlas_lighting.fs");
+    Shader depthShader("atlas_depth.vs", "atlas_depth.fs");
+
+    // Set up vertex data (and buffer(s)) and configure vertex attributes
+    float planeVertices[] = {
+        // positions            // normals         // texcoords
+         25.0f, -0.5f,  25.0f,  0.0f, 1.0f, 0.0f,  25.0f,  0.0f,
+        -25.0f, -0.5f,  25.0f,  0.0f, 1.0f, 0.0f,   0.0f,  0.0f,
+        -25.0f, -0.5f, -25.0f,  0.0f, 1.0f, 0.0f,   0.0f, 25.0f,
+
+         25.0f, -0.5f,  25.0f,  0.0f, 1.0f, 0.0f,  25.0f,  0.0f,
+        -25.0f, -0.5f, -25.0f,  0.0f, 1.0f, 0.0f,   0.0f, 25.0f,
+         25.0f, -0.5f, -25.0f,  0.0f, 1.0f, 0.0f,  25.0f, 25.0f
+    };
+
+    // Plane VAO
+    unsigned int planeVBO;
+    glGenVertexArrays(1, &planeVAO);
+    glGenBuffers(1, &planeVBO);
+    glBindVertexArray(planeVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, planeVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(planeVertices), planeVertices, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+    glBindVertexArray(0);
+
+    // Load textures
+    unsigned int woodTexture = loadTexture("wood.png");
+
+    // Every light draws its shadows into tiles of the one atlas
+    ShadowAtlas atlas(ATLAS_SIZE, MAX_TILE_SIZE, MIN_TILE_SIZE, tilesPerFrame);
+    GpuTimer shadowTimer;
+
+    buildScene();
+    buildLights(atlas);
+
+    // Shader configuration
+    shader.use();
+    shader.setInt("diffuseTexture", 0);
+    shader.setInt("shadowAtlas", 1);
+
+    // The lights reach the shader through a uniform buffer on binding point 0
+    glUniformBlockBinding(shader.ID, glGetUniformBlockIndex(shader.ID, "LightBlock"), 0);
+    unsigned int lightUBO;
+    glGenBuffers(1, &lightUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, lightUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Light_Block), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, 0, lightUBO);
+    Light_Block lightBlock = {};
+
+    float lightTime = 0.0f;
+
+    // render loop
+    // -----------
+    while (!glfwWindowShouldClose(window)) {
+        // Per-frame time logic
+        float currentFrame = glfwGetTime();
+        deltaTime = currentFrame - lastFrame;
+        lastFrame = currentFrame;
+
+        // Input
+        processInput(window);
+        atlas.setTilesPerFrame(tilesPerFrame);
+
+        // Move the lights and tell the atlas how large each one appears and how far it moved
+        vector<Light> previous = lights;
+        if (lightsMoving) {
+            lightTime += deltaTime;
+        }
+        animateLights(lightTime);
+
+        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+        mat4 view = camera.GetViewMatrix();
+        for (unsigned int i = 0; i < lights.size(); i++) {
+            const Light& light = lights[i];
+            float movement = length(light.position - previous[i].position) + length(light.direction - previous[i].direction) * light.range;
+
+            // A spot light reaches about as far as a sphere around the middle of its cone
+            float pixels = 0.0f;
+            float distance = 0.0f;
+            if (light.type != DIRECTIONAL_SHADOW) {
+                vec3 center = light.type == SPOT_SHADOW ? light.position + light.direction * light.range * 0.5f : light.position;
+                float radius = light.type == SPOT_SHADOW ? light.range * 0.5f : light.range;
+                vec3 viewCenter = vec3(view * vec4(center, 1.0f));
+                if (viewCenter.z - radius < 0.0f) {
+                    pixels = TextureStreamer::screenFootprint(viewCenter, radius, radians(camera.Zoom), SCR_HEIGHT);
+                }
+                distance = length(camera.Position - light.position);
+            }
+            atlas.updateLight(light.atlasLight, pixels, distance, movement);
+        }
+
+        // 1. Draw the tiles of the lights the atlas picked for this frame
+        vector<Shadow_Update> updates = atlas.schedule();
+        unsigned int drawnTiles = 0;
+
+        shadowTimer.begin();
+        depthShader.use();
+        for (const Shadow_Update& update : updates) {
+            Light& light = *find_if(lights.begin(), lights.end(), [&update](const Light& candidate) {
+                return candidate.atlasLight == update.light;
+            });
+
+            vector<mat4> matrices = lightTileMatrices(light);
+            light.shadowPosition = light.position;
+            light.shadowMatrix = matrices[0];
+
+            depthShader.setBool("linearDepth", light.type != DIRECTIONAL_SHADOW);
+            depthShader.setVec3("lightPos", light.position);
+            depthShader.setFloat("range", light.range);
+            for (unsigned int tile = 0; tile < update.tiles.size(); tile++) {
+                atlas.beginTile(update.tiles[tile]);
+                depthShader.setMat4("lightSpaceMatrix", matrices[tile]);
+                renderShadowCasters(depthShader, light);
+                drawnTiles++;
+            }
+        }
+        atlas.endTiles();
+        shadowTimer.end();
+
+        // 2. Render scene as normal, every light looking up its tiles in the atlas
+        glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
+        glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        shader.use();
+        shader.setMat4("projection", projection);
+        shader.setMat4("view", view);
+        shader.setVec3("viewPos", camera.Position);
+
+        unsigned int tileCount = 0;
+        unsigned int lightCount = std::min((unsigned int)lights.size(), MAX_LIGHTS);
+        lightBlock.lightCount = lightCount;
+        for (unsigned int i = 0; i < lightCount; i++) {
+            const Light& light = lights[i];
+            Gpu_Light& gpuLight = lightBlock.lights[i];
+            gpuLight.type = light.type;
+            gpuLight.position = light.position;
+            gpuLight.direction = light.direction;
+            gpuLight.color = light.color;
+            gpuLight.range = light.range;
+            gpuLight.cutoff = cos(radians(light.outerAngle));
+            gpuLight.shadowPosition = light.shadowPosition;
+            lightBlock.lightSpaceMatrices[i] = light.shadowMatrix;
+
+            const vector<Shadow_Tile>& tiles = atlas.getTiles(light.atlasLight);
+            if (tiles.empty() || tileCount + tiles.size() > MAX_TILES) {
+                gpuLight.firstTile = -1;
+                continue;
+            }
+            gpuLight.firstTile = tileCount;
+            for (const Shadow_Tile& tile : tiles) {
+                lightBlock.shadowTiles[tileCount] = atlas.tileTransform(tile);
+                tileCount++;
+            }
+        }
+        glBindBuffer(GL_UNIFORM_BUFFER, lightUBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Light_Block), &lightBlock);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+        bindTexture(0, woodTexture);
+        bindTexture(1, atlas.texture());
+        renderScene(shader);
+
+        cout << "Lights: " << lights.size() << " | tiles drawn: " << drawnTiles << "/" << tilesPerFrame
+             << " | atlas used: " << (int)(atlas.occupancy() * 100.0f) << "% | shadow pass: " << shadowTimer.averageMilliseconds() << " ms" << endl;
+
+        // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+        glfwSwapBuffers(window);
+        glfwPollEvents();
+    }
+
+    // Optional: de-allocate all resources once they've outlived their purpose:
+    glDeleteVertexArrays(1, &planeVAO);
+    glDeleteBuffers(1, &planeVBO);
+
+    glfwTerminate();
+    return 0;
+}
+
+// Sets up the objects of the 3D scene: a floor with a grid of cubes of a few sizes
+void buildScene() {
+    // floor
+    casters.push_back({ mat4(1.0f), vec3(0.0f, -0.5f, 0.0f), 25.0f * sqrt(2.0f), true });
+
+    for (int x = 0; x < 6; x++) {
+        for (int z = 0; z < 6; z++) {
+            float size = 0.5f + 0.25f * ((x * 7 + z * 3) % 4);
+            vec3 position(-15.0f + x * 6.0f, size - 0.5f, -15.0f + z * 6.0f);
+
+            mat4 model = mat4(1.0f);
+            model = translate(model, position);
+            model = rotate(model, radians((float)((x * z * 17) % 90)), vec3(0.0f, 1.0f, 0.0f));
+            model = scale(model, vec3(size));
+            casters.push_back({ model, position, size * sqrt(3.0f), false });
+        }
+    }
+}
+
+// A sun, a grid of spot lights shining down and a ring of point lights between the cubes. Every
+// other spot and point light moves
+void buildLights(ShadowAtlas& atlas) {
+    vec3 palette[] = {
+        vec3(1.0f, 0.6f, 0.3f), vec3(0.3f, 0.6f, 1.0f), vec3(0.5f, 1.0f, 0.4f),
+        vec3(1.0f, 0.3f, 0.6f), vec3(0.9f, 0.9f, 0.5f), vec3(0.6f, 0.4f, 1.0f)
+    };
+
+    Light sun = {};
+    sun.type = DIRECTIONAL_SHADOW;
+    sun.direction = normalize(vec3(-0.4f, -1.0f, -0.3f));
+    sun.color = vec3(0.15f, 0.15f, 0.2f);
+    lights.push_back(sun);
+
+    for (int i = 0; i < 16; i++) {
+        Light spot = {};
+        spot.type = SPOT_SHADOW;
+        spot.origin = vec3(-12.0f + (i % 4) * 8.0f, 5.0f, -12.0f + (i / 4) * 8.0f);
+        spot.position = spot.origin;
+        spot.direction = vec3(0.0f, -1.0f, 0.0f);
+        spot.color = palette[i % 6] * 12.0f;
+        spot.range = 14.0f;
+        spot.outerAngle = 35.0f;
+        spot.phase = i * 1.7f;
+        spot.moving = i % 2 == 0;
+        lights.push_back(spot);
+    }
+
+    for (int i = 0; i < 8; i++) {
+        float angle = radians(i * 45.0f);
+        Light point = {};
+        point.type = POINT_SHADOW;
+        point.origin = vec3(cos(angle) * 10.0f, 1.5f, sin(angle) * 10.0f);
+        point.position = point.origin;
+        point.direction = vec3(0.0f, -1.0f, 0.0f);
+        point.color = palette[(i + 3) % 6] * 6.0f;
+        point.range = 8.0f;
+        point.phase = i * 0.9f;
+        point.moving = i % 2 == 1;
+        lights.push_back(point);
+    }
+
+    for (Light& light : lights) {
+        light.atlasLight = atlas.addLight(light.type);
+    }
+}
+
+// Moving spot lights circle and sway their cones, moving point lights circle and bob
+void animateLights(float time) {
+    for (Light& light : lights) {
+        if (!light.moving) {
+            continue;
+        }
+
+        float t = time + light.phase;
+        if (light.type == SPOT_SHADOW) {
+            light.position = light.origin + vec3(cos(t * 0.7f), 0.0f, sin(t * 0.7f)) * 2.0f;
+            light.direction = normalize(vec3(0.35f * cos(t), -1.0f, 0.35f * sin(t)));
+        } else if (light.type == POINT_SHADOW) {
+            light.position = light.origin + vec3(cos(t * 0.5f) * 1.5f, sin(t) * 0.5f, sin(t * 0.5f) * 1.5f);
+        }
+    }
+}
+
+// The light-space matrices of a light's tiles: one for spot and directional lights, one per cube
+// face for point lights
+vector<mat4> lightTileMatrices(const Light& light) {
+    vector<mat4> matrices;
+    vec3 up = abs(light.direction.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+
+    if (light.type == SPOT_SHADOW) {
+        // A little wider than the cone, so the smooth edge still has a shadow
+        mat4 lightProjection = perspective(radians(2.0f * light.outerAngle + 10.0f), 1.0f, 0.1f, light.range);
+        matrices.push_back(lightProjection * lookAt(light.position, light.position + light.direction, up));
+    } else if (light.type == POINT_SHADOW) {
+        mat4 lightProjection = perspective(radians(90.0f), 1.0f, 0.1f, light.range);
+        vec3 p = light.position;
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f)));
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(-1.0f, 0.0f, 0.0f), vec3(0.0f, -1.0f, 0.0f)));
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(0.0f, 1.0f, 0.0f), vec3(0.0f, 0.0f, 1.0f)));
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(0.0f, -1.0f, 0.0f), vec3(0.0f, 0.0f, -1.0f)));
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, -1.0f, 0.0f)));
+        matrices.push_back(lightProjection * lookAt(p, p + vec3(0.0f, 0.0f, -1.0f), vec3(0.0f, -1.0f, 0.0f)));
+    } else {
+        // The sun covers the whole floor from outside the scene
+        mat4 lightProjection = ortho(-36.0f, 36.0f, -36.0f, 36.0f, 1.0f, 80.0f);
+        matrices.push_back(lightProjection * lookAt(-light.direction * 40.0f, vec3(0.0f), up));
+    }
+    return matrices;
+}
+
+// Renders the 3D scene
+void renderScene(const Shader& shader) {
+    for (const Caster& caster : casters) {
+        shader.setMat4("model", caster.model);
+        if (caster.plane) {
+            glBindVertexArray(planeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            renderCube();
+        }
+    }
+}
+
+// Renders the casters within the light's range into the bound tile
+void renderShadowCasters(const Shader& shader, const Light& light) {
+    for (const Caster& caster : casters) {
+        if (light.type != DIRECTIONAL_SHADOW && length(caster.center - light.position) > light.range + caster.radius) {
+            continue;
+        }
+
+        shader.setMat4("model", caster.model);
+        if (caster.plane) {
+            glBindVertexArray(planeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            renderCube();
+        }
+    }
+}
+
+// renderCube() renders a 1x1 3D cube in NDC.
+unsigned int cubeVAO = 0;
+unsigned int cubeVBO = 0;
+void renderCube() {
+    // initialize (if necessary)
+    if (cubeVAO == 0) {
+        float vertices[] = {
+            // Back face
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right         
+             1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+            -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+            -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+
+            // Front face
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+             1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+            -1.0f,  1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+            -1.0f, -1.0f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+
+            // Left face
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+            -1.0f,  1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f, -1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f,  1.0f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-right
+
+            // Right face
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right         
+             1.0f, -1.0f, -1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // bottom-right
+             1.0f,  1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // top-left
+             1.0f, -1.0f,  1.0f,  1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left 
+
+            // Bottom face
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+             1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+             1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-left
+            -1.0f, -1.0f,  1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-right
+            -1.0f, -1.0f, -1.0f,  0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-right
+
+            // Top face
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+             1.0f,  1.0f , 1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+             1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right     
+             1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+            -1.0f,  1.0f, -1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+            -1.0f,  1.0f,  1.0f,  0.0f,  1.0f,  0.0f, 0.0f, 0.0f  // bottom-left        
+        };
+
+        glGenVertexArrays(1, &cubeVAO);
+        glGenBuffers(1, &cubeVBO);
+
+        // Fill buffer
+        glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+        // Link vertex attributes
+        glBindVertexArray(cubeVAO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    // Render Cube
+    glBindVertexArray(cubeVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 36);
+    glBindVertexArray(0);
+}
+
+// Process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
+void processInput(GLFWwindow* window) {
+    if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
+        glfwSetWindowShouldClose(window, true);
+
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        camera.ProcessKeyboard(FORWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        camera.ProcessKeyboard(BACKWARD, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        camera.ProcessKeyboard(LEFT, deltaTime);
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS && !lightsMovingKeyPressed) {
+        lightsMoving = !lightsMoving;
+        lightsMovingKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE) {
+        lightsMovingKeyPressed = false;
+    }
+
+    // [ and ] halve and double the tile budget
+    if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS && !tilesKeyPressed) {
+        tilesPerFrame = std::max(1u, tilesPerFrame / 2);
+        tilesKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS && !tilesKeyPressed) {
+        tilesPerFrame = std::min(64u, tilesPerFrame * 2);
+        tilesKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_RELEASE && glfwGetKey(window, GLFW_KEY_RIGHT_BRACKET) == GLFW_RELEASE) {
+        tilesKeyPressed = false;
+    }
+}
+
+// GLFW: whenever the window size changed (by OS or user resize) this callback function executes
+void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
+    // Make sure the viewport matches the new window dimensions; note that width and 
+    // height will be significantly larger than specified on retina displays.
+    glViewport(0, 0, width, height);
+}
+
+// GLFW: whenever the mouse moves, this callback is called
+void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
+    if (firstMouse) {
+        lastX = xpos;
+        lastY = ypos;
+        firstMouse = false;
+    }
+
+    float xoffset = xpos - lastX;
+    float yoffset = lastY - ypos; // Reversed since y-coordinates go from bottom to top
+
+    lastX = xpos;
+    lastY = ypos;
+
+    camera.ProcessMouseMovement(xoffset, yoffset);
+}
+
+// GLFE: whenever the mouse scroll wheel scrolls, this callback is called
+void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
+    camera.ProcessMouseScroll(yoffset);
+}
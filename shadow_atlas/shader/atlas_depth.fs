@@ -0,0 +1,11 @@
+#version 330 core
+in vec4 FragPos;
+
+uniform vec3 lightPos;
+uniform float range;
+uniform bool linearDepth; // Spot and point lights store the distance over their range
+
+void main() {
+    // The orthographic depth of a directional light is already linear
+    gl_FragDepth = linearDepth ? length(FragPos.xyz - lightPos) / range : gl_FragCoord.z;
+}
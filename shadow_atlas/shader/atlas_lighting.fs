@@ -0,0 +1,145 @@
+#version 330 core
+out vec4 FragColor;
+
+in VS_OUT {
+    vec3 FragPos;
+    vec3 Normal;
+    vec2 TexCoords;
+} fs_in;
+
+const int MAX_LIGHTS = 32;
+const int MAX_TILES = 96;
+
+const int SPOT_LIGHT = 0;
+const int POINT_LIGHT = 1;
+const int DIRECTIONAL_LIGHT = 2;
+
+// Every vec3 is followed by a scalar, so std140 packs a light into 64 bytes without padding
+struct Light {
+    vec3 position;
+    float range;
+    vec3 direction;
+    float cutoff;        // Cosine of a spot light's outer angle
+    vec3 color;
+    int type;
+    vec3 shadowPosition; // Where the light was when its tiles were drawn
+    int firstTile;       // Into shadowTiles; point lights use six in a row, -1 without a shadow
+};
+
+uniform sampler2D diffuseTexture;
+uniform sampler2DShadow shadowAtlas;
+
+// As plain uniforms the lights would take about 1900 components, past the 1024 a fragment shader
+// is guaranteed. A uniform block is guaranteed 16 KB. Filled from Light_Block in main.cpp
+layout (std140) uniform LightBlock {
+    mat4 lightSpaceMatrices[MAX_LIGHTS]; // Spot and directional lights, as their tiles were drawn
+    vec4 shadowTiles[MAX_TILES];         // Scale in xy and offset in zw, from tile to atlas coordinates
+    Light lights[MAX_LIGHTS];
+    int lightCount;
+};
+
+uniform vec3 viewPos;
+
+// Cube face the direction points into and its [0, 1] coordinates on it, laid out like the faces
+// of a cubemap so they match tiles drawn with the cubemap face matrices
+vec2 CubeFaceCoords(vec3 v, out int face) {
+    vec3 a = abs(v);
+    vec2 sc;
+    float ma;
+    if (a.x >= a.y && a.x >= a.z) {
+        face = v.x > 0.0 ? 0 : 1;
+        sc = vec2(v.x > 0.0 ? -v.z : v.z, -v.y);
+        ma = a.x;
+    } else if (a.y >= a.z) {
+        face = v.y > 0.0 ? 2 : 3;
+        sc = vec2(v.x, v.y > 0.0 ? v.z : -v.z);
+        ma = a.y;
+    } else {
+        face = v.z > 0.0 ? 4 : 5;
+        sc = vec2(v.z > 0.0 ? v.x : -v.x, -v.y);
+        ma = a.z;
+    }
+    return (sc / ma + 1.0) * 0.5;
+}
+
+// Four hardware-compared taps inside one tile. The coordinates are kept a texel and a half away
+// from the tile's edges so the filter never reads the neighboring tile
+float TileShadow(int tile, vec2 coords, float reference) {
+    vec4 transform = shadowTiles[tile];
+    float texel = 1.0 / (transform.x * float(textureSize(shadowAtlas, 0).x));
+    coords = clamp(coords, vec2(1.5 * texel), vec2(1.0 - 1.5 * texel));
+
+    float lit = 0.0;
+    vec2 offsets[4] = vec2[](vec2(-0.5, -0.5), vec2(0.5, -0.5), vec2(-0.5, 0.5), vec2(0.5, 0.5));
+    for (int i = 0; i < 4; i++) {
+        vec2 atlasCoords = transform.zw + (coords + offsets[i] * texel) * transform.xy;
+        lit += texture(shadowAtlas, vec3(atlasCoords, reference));
+    }
+    return lit * 0.25;
+}
+
+float LightShadow(int index, vec3 normal) {
+    Light light = lights[index];
+    if (light.firstTile < 0) {
+        return 1.0;
+    }
+
+    // Push the lookup out along the normal, so a surface doesn't shadow itself
+    vec3 position = fs_in.FragPos + normal * 0.05;
+
+    if (light.type == POINT_LIGHT) {
+        vec3 fromLight = position - light.shadowPosition;
+        int face;
+        vec2 coords = CubeFaceCoords(fromLight, face);
+        return TileShadow(light.firstTile + face, coords, length(fromLight) / light.range - 0.002);
+    }
+
+    vec4 lightSpace = lightSpaceMatrices[index] * vec4(position, 1.0);
+    vec3 projected = lightSpace.xyz / lightSpace.w * 0.5 + 0.5;
+    if (light.type == SPOT_LIGHT) {
+        projected.z = length(position - light.shadowPosition) / light.range;
+    }
+    if (projected.z > 1.0) {
+        return 1.0;
+    }
+    return TileShadow(light.firstTile, projected.xy, projected.z - 0.002);
+}
+
+void main() {
+    vec3 color = texture(diffuseTexture, fs_in.TexCoords).rgb;
+    vec3 normal = normalize(fs_in.Normal);
+    vec3 viewDir = normalize(viewPos - fs_in.FragPos);
+    vec3 lighting = 0.05 * color;
+
+    for (int i = 0; i < lightCount; i++) {
+        Light light = lights[i];
+        vec3 lightDir;
+        float attenuation = 1.0;
+        if (light.type == DIRECTIONAL_LIGHT) {
+            lightDir = -light.direction;
+        } else {
+            vec3 toLight = light.position - fs_in.FragPos;
+            float distance = length(toLight);
+            if (distance > light.range) {
+                continue;
+            }
+            lightDir = toLight / distance;
+
+            // Falls off with the square of the distance and reaches zero at the range
+            float window = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+            attenuation = window * window / (1.0 + distance * distance);
+            if (light.type == SPOT_LIGHT) {
+                attenuation *= smoothstep(light.cutoff, light.cutoff + 0.05, dot(-lightDir, light.direction));
+            }
+        }
+
+        float diff = max(dot(lightDir, normal), 0.0);
+        if (diff * attenuation <= 0.0) {
+            continue;
+        }
+        float spec = pow(max(dot(normal, normalize(lightDir + viewDir)), 0.0), 64.0);
+        lighting += (diff * color + spec * 0.3) * light.color * attenuation * LightShadow(i, normal);
+    }
+
+    FragColor = vec4(lighting, 1.0);
+}
@@ -72,6 +72,21 @@ public:
 		return lookAt(Position, Position + Front, Up);
 	}
 
+	// Returns the perspective projection shifted by a sub-pixel offset, a different one each frame,
+	// for temporal anti-aliasing. The offsets follow the Halton (2, 3) sequence, which spreads them
+	// evenly over the pixel, and repeat every 8 frames
+	mat4 GetJitteredProjectionMatrix(float aspect, float nearPlane, float farPlane, unsigned int frame, float width, float height) {
+		unsigned int index = frame % 8 + 1; // Index 0 is 0 in both bases and would land on the corner
+		float jitterX = halton(index, 2) - 0.5f;
+		float jitterY = halton(index, 3) - 0.5f;
+
+		// Moves every vertex by the offset after the perspective divide, two units of clip space per screen
+		mat4 projection = perspective(radians(Zoom), aspect, nearPlane, farPlane);
+		projection[2][0] += jitterX * 2.0f / width;
+		projection[2][1] += jitterY * 2.0f / height;
+		return projection;
+	}
+
 	// Processes input recieved from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM
 	void ProcessKeyboard(Camera_Movement direction, float deltaTime) {
 		float velocity = MovementSpeed * deltaTime;
@@ -116,6 +131,18 @@ public:
 	}
 
 private:
+	// The index-th number of the radical inverse sequence in base, in [0, 1)
+	static float halton(unsigned int index, unsigned int base) {
+		float result = 0.0f;
+		float fraction = 1.0f / base;
+		while (index > 0) {
+			result += (index % base) * fraction;
+			index /= base;
+			fraction /= base;
+		}
+		return result;
+	}
+
 	// Calculates the front vector from the Camera's (updated) Euler Angles	
 	void updateCameraVectors() {
 		vec3 front;
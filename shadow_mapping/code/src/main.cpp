@@ -5,10 +5,17 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
 
 #include "../header/Shader.h"
-#include "../header/stb_image.h"
 #include "../header/Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/ShadowCache.h"
+#include "../../../common/code/header/GpuTimer.h"
+#include "../../../common/code/header/GaussianBlur.h"
+#include "../../../common/code/header/TemporalAA.h"
 
 #include <iostream>
 
@@ -19,8 +26,8 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow* window);
-unsigned int loadTexture(const char* path);
 void renderScene(const Shader& shader);
+void renderShadowCasters(const Shader& shader, bool dynamic, int cascadeMask);
 void renderCube();
 void renderQuad();
 
@@ -41,6 +48,80 @@ float lastFrame = 0.0f;
 // meshes
 unsigned int planeVAO;
 
+// cascaded shadow maps
+const unsigned int CASCADE_COUNT = 4;          // At most MAX_CASCADES of the shaders
+const unsigned int SHADOW_SIZE = 512;          // Per cascade: four 512x512 layers hold as many texels as one 1024x1024 map
+const float CAMERA_NEAR = 0.1f;
+const float CAMERA_FAR = 100.0f;
+float shadowDistance = 50.0f;                  // Shadows end this far from the camera
+float splitLambda = 0.75f;                     // Blend between even (0) and logarithmic (1) split spacing
+bool showCascades = false;
+bool showCascadesKeyPressed = false;
+int pcfSamples = 8;                            // Poisson taps per fragment, 4 to 16; 4 where they all agree
+float pcfRadius = 1.5f;                        // Filter radius in texels
+
+// Prefiltered shadows: the lighting pass takes one filtered fetch of blurred moments instead of PCF taps
+enum ShadowFilter { PCF_FILTER, VSM_FILTER, EVSM_FILTER };
+const char* SHADOW_FILTER_NAMES[] = { "PCF", "VSM", "EVSM" };
+ShadowFilter shadowFilter = PCF_FILTER;
+bool shadowFilterKeyPressed = false;
+float momentBlurSigma = 1.5f;                  // In shadow map texels
+float minVariance = 0.00002f;
+float lightBleedReduction = 0.3f;
+const vec2 EVSM_EXPONENTS = vec2(5.54f, 5.54f); // The largest that keep e^(2c) within half floats
+
+// One cascade's depths are turned into moments, blurred at shadow map resolution and copied into
+// their layer of the array, which is then mipmapped
+struct MomentMaps {
+    bool exponential;
+    unsigned int texture;           // GL_TEXTURE_2D_ARRAY with mips, one layer per cascade
+    unsigned int momentTexture;     // One cascade's moments before the blur
+    unsigned int momentFBO;
+    unsigned int readFBO;           // Reads the blurred moments to copy them into their layer
+    GaussianBlur* blur;
+};
+
+MomentMaps createMomentMaps(GLenum internalFormat, bool exponential);
+void updateMomentMaps(MomentMaps& maps, unsigned int depthMap, unsigned int rawDepthSampler, const Shader& momentShader);
+void deleteMomentMaps(MomentMaps& maps);
+bool shadowCaching = true;                     // Draw the static casters into a cached map only when a cascade moves
+bool shadowCachingKeyPressed = false;
+
+// Temporal anti-aliasing: each frame is drawn with a jittered projection and blended with the ones
+// before it. The PCF kernel turns every frame, so fewer taps per frame average out over time
+bool temporalAA = false;
+bool temporalAAKeyPressed = false;
+int temporalPcfSamples = 4;                    // Poisson taps per fragment under TAA
+const float GOLDEN_ANGLE = 2.39996323f;        // Kernel turn per frame, which takes long to repeat a direction
+
+// An object of the scene, with a bounding sphere to cull it against the cascades
+struct Caster {
+    mat4 model;
+    vec3 center;
+    float radius;
+    bool plane;
+    bool dynamic;       // Drawn into the shadow map every frame instead of only into the cache
+    int cascadeMask;    // Cascades it overlaps this frame, one bit each
+    mat4 previousModel; // Last frame's, for the velocity buffer
+};
+vector<Caster> casters;
+
+// One cascade's light projection, with the box it covers in light view space for culling
+struct Cascade {
+    mat4 lightSpaceMatrix;
+    float splitFar;     // Distance from the camera where the cascade ends
+    vec2 minBounds;
+    vec2 maxBounds;
+    float farDistance;  // Depth from the light past which casters can't shadow anything in the cascade
+    float bias;
+};
+
+void buildScene();
+void animateScene(float time);
+vector<Cascade> fitCascades(const mat4& view, float fovY, float aspect, const vec3& lightDir);
+void cullCasters(const vector<Cascade>& cascades, const vec3& lightDir);
+mat4 lightViewMatrix(const vec3& lightDir);
+
 int main()
 {
     // GLFW: initialize and configure
@@ -80,8 +161,9 @@ int main()
 
     // Build and compile shaders
     Shader shader("shadow_mapping.vs", "shadow_mapping.fs");
-    Shader simpleDepthShader("shadow_mapping_depth.vs", "shadow_mapping_depth.fs");
+    Shader simpleDepthShader("shadow_mapping_depth.vs", "shadow_mapping_depth.fs", "shadow_mapping_depth.gs");
     Shader debugDepthQuad("debug_quad.vs", "debug_quad.fs");
+    Shader momentShader("debug_quad.vs", "shadow_moments.fs");
 
     // Set up vertex data (and buffer(s)) and configure vertex attributes
     float planeVertices[] = {
@@ -114,36 +196,103 @@ int main()
     unsigned int woodTexture = loadTexture("wood.png");
 
     // Configure depth map FBO
-    const unsigned int SHADOW_WIDTH = 1024, SHADOW_HEIGHT = 1024;
     unsigned int depthMapFBO;
     glGenFramebuffers(1, &depthMapFBO);
 
-    // Create depth texture
+    // Create depth texture array, one layer per cascade
     unsigned int depthMap;
     glGenTextures(1, &depthMap);
-    glBindTexture(GL_TEXTURE_2D, depthMap);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, SHADOW_WIDTH, SHADOW_HEIGHT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT, SHADOW_SIZE, SHADOW_SIZE, CASCADE_COUNT, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
     float borderColor[] = { 1.0, 1.0, 1.0, 1.0 };
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
 
-    // Attach depth texture as FBO's depth buffer
+    // Attach the whole array as FBO's depth buffer, so the geometry shader can pick the layer
     glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthMap, 0);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, depthMap, 0);
     glDrawBuffer(GL_NONE);
     glReadBuffer(GL_NONE);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
+    // The map compares in the sampler; the debug quad reads the raw depths through this one
+    unsigned int rawDepthSampler;
+    glGenSamplers(1, &rawDepthSampler);
+    glSamplerParameteri(rawDepthSampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glSamplerParameteri(rawDepthSampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glSamplerParameteri(rawDepthSampler, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    // Two moments in full floats for VSM, four warped ones in half floats for EVSM
+    MomentMaps vsmMaps = createMomentMaps(GL_RG32F, false);
+    MomentMaps evsmMaps = createMomentMaps(GL_RGBA16F, true);
+    GpuTimer momentTimer;
+
+    // Static casters of every cascade, as seen through cachedLightSpaceMatrices
+    ShadowCache shadowCache(GL_TEXTURE_2D_ARRAY, SHADOW_SIZE, CASCADE_COUNT);
+    vector<mat4> cachedLightSpaceMatrices(CASCADE_COUNT, mat4(0.0f));
+
+    // Shadow pass time for frames that draw every caster and for frames that reuse the cache
+    GpuTimer fullShadowTimer;
+    GpuTimer cachedShadowTimer;
+
+    // Under TAA the scene is drawn into its own framebuffer, with the velocity of every pixel
+    unsigned int sceneFBO;
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+
+    unsigned int sceneTextures[2];
+    glGenTextures(2, sceneTextures);
+    GLenum sceneFormats[2] = { GL_RGBA16F, GL_RG16F };
+    GLenum sceneLayouts[2] = { GL_RGBA, GL_RG };
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, sceneTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, sceneFormats[i], SCR_WIDTH, SCR_HEIGHT, 0, sceneLayouts[i], GL_FLOAT, NULL);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, sceneTextures[i], 0);
+    }
+
+    unsigned int sceneDepth;
+    glGenRenderbuffers(1, &sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepth);
+
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    TemporalAA temporal(SCR_WIDTH, SCR_HEIGHT);
+    GpuTimer resolveTimer;
+    unsigned int frameIndex = 0;
+    mat4 previousViewProjection = mat4(1.0f);
+    bool lastTemporalAA = temporalAA;
+
+    buildScene();
 
     // Shader configuration
     shader.use();
     shader.setInt("diffuseTexture", 0);
     shader.setInt("shadowMap", 1);
+    shader.setInt("momentMap", 2);
     debugDepthQuad.use();
-    debugDepthQuad.setInt("depthMap", 0);
+    debugDepthQuad.setInt("depthMap", 1);
+    momentShader.use();
+    momentShader.setInt("depthMap", 0);
+    momentShader.setVec2("exponents", EVSM_EXPONENTS);
 
     // Lighting info
     vec3 lightPos(-2.0f, 4.0f, -1.0f);
@@ -164,6 +313,10 @@ int main()
         //lightPos.x = sin(glfwGetTime()) * 3.0f;
         //lightPos.z = cos(glfwGetTime()) * 2.0f;
         //lightPos.y = 5.0 + cos(glfwGetTime()) * 1.0f;
+        for (Caster& caster : casters) {
+            caster.previousModel = caster.model;
+        }
+        animateScene(currentFrame);
 
         // Render
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -175,25 +328,68 @@ int main()
        // glEnable(GL_CULL_FACE);
        // glCullFace(GL_FRONT);
 
-        glm::mat4 lightProjection, lightView;
-        glm::mat4 lightSpaceMatrix;
-        float near_plane = 1.0f, far_plane = 7.5f;
-        //lightProjection = perspective(radians(45.0f), (GLfloat)SHADOW_WIDTH / (GLfloat)SHADOW_HEIGHT, near_plane, far_plane); // note that if you use a perspective projection matrix you'll have to change the light position as the current light position isn't enough to reflect the whole scene
-        lightProjection = ortho(-10.0f, 10.0f, -10.0f, 10.0f, near_plane, far_plane);
-        lightView = lookAt(lightPos, vec3(0.0f), vec3(0.0, 1.0, 0.0));
-        lightSpaceMatrix = lightProjection * lightView;
-
-        // Render scene from light's point of view
+        // The light shines from lightPos towards the origin; each cascade gets an orthographic
+        // projection fitted around its slice of the camera frustum
+        vec3 lightDir = normalize(-lightPos);
+        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, CAMERA_NEAR, CAMERA_FAR);
+        mat4 view = camera.GetViewMatrix();
+        vector<Cascade> cascades = fitCascades(view, radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, lightDir);
+        cullCasters(cascades, lightDir);
+
+        // A cascade's cached layer is stale once its projection has changed. Cascades only move in
+        // whole texels, so a still camera keeps reusing them; the light turning moves all of them
+        for (unsigned int i = 0; i < CASCADE_COUNT; i++) {
+            if (cascades[i].lightSpaceMatrix != cachedLightSpaceMatrices[i]) {
+                shadowCache.invalidate(i);
+                cachedLightSpaceMatrices[i] = cascades[i].lightSpaceMatrix;
+            }
+        }
+
+        // Render scene from light's point of view, into every cascade at once
         simpleDepthShader.use();
-        simpleDepthShader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-
-        glViewport(0, 0, SHADOW_WIDTH, SHADOW_HEIGHT);
-        glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
-        glClear(GL_DEPTH_BUFFER_BIT);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
-        renderScene(simpleDepthShader);
+        simpleDepthShader.setInt("cascadeCount", CASCADE_COUNT);
+        for (unsigned int i = 0; i < CASCADE_COUNT; i++) {
+            simpleDepthShader.setMat4("lightSpaceMatrices[" + to_string(i) + "]", cascades[i].lightSpaceMatrix);
+        }
+
+        // Casters between the light and a cascade's near plane still need to land in it; depth
+        // clamping flattens them onto the near plane instead of clipping them
+        glEnable(GL_DEPTH_CLAMP);
+        bool redrawn = !shadowCaching || shadowCache.dirtyMask() != 0;
+        GpuTimer& shadowTimer = redrawn ? fullShadowTimer : cachedShadowTimer;
+        shadowTimer.begin();
+
+        if (shadowCaching) {
+            // Redraw the static casters of the stale cascades only, then start from a copy of the cache
+            if (shadowCache.dirtyMask() != 0) {
+                shadowCache.beginRebuild();
+                renderShadowCasters(simpleDepthShader, false, shadowCache.dirtyMask());
+                shadowCache.endRebuild();
+            }
+            shadowCache.copyTo(depthMap);
+
+            glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            renderShadowCasters(simpleDepthShader, true, ~0);
+        } else {
+            glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
+            glBindFramebuffer(GL_FRAMEBUFFER, depthMapFBO);
+            glClear(GL_DEPTH_BUFFER_BIT);
+            renderShadowCasters(simpleDepthShader, false, ~0);
+            renderShadowCasters(simpleDepthShader, true, ~0);
+        }
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        shadowTimer.end();
+        glDisable(GL_DEPTH_CLAMP);
+
+        // Prefilter the finished shadow map into moments
+        MomentMaps& momentMaps = shadowFilter == EVSM_FILTER ? evsmMaps : vsmMaps;
+        if (shadowFilter != PCF_FILTER) {
+            momentTimer.begin();
+            momentMaps.blur->setSigma(momentBlurSigma);
+            updateMomentMaps(momentMaps, depthMap, rawDepthSampler, momentShader);
+            momentTimer.end();
+        }
 
         // Disable culling for rendering
         // glDisable(GL_CULL_FACE);
@@ -202,32 +398,90 @@ int main()
         glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+        // The history of the frames before is no use to the first frame with TAA back on
+        if (temporalAA != lastTemporalAA) {
+            temporal.reset();
+            lastTemporalAA = temporalAA;
+        }
+
+        // Velocities are measured without the jitter, so a still scene has none
+        mat4 viewProjection = projection * view;
+        mat4 drawProjection = projection;
+        if (temporalAA) {
+            drawProjection = camera.GetJitteredProjectionMatrix((float)SCR_WIDTH / (float)SCR_HEIGHT, CAMERA_NEAR, CAMERA_FAR, frameIndex, (float)SCR_WIDTH, (float)SCR_HEIGHT);
+        }
+
         // 2. Render scene as normal using the generated depth/shadow map  
+        glBindFramebuffer(GL_FRAMEBUFFER, temporalAA ? sceneFBO : 0);
         glViewport(0, 0, SCR_WIDTH, SCR_HEIGHT);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        if (temporalAA) {
+            const float noVelocity[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 1, noVelocity);
+        }
         shader.use();
-        mat4 projection = perspective(radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        mat4 view = camera.GetViewMatrix();
-        shader.setMat4("projection", projection);
+        shader.setMat4("projection", drawProjection);
         shader.setMat4("view", view);
+        shader.setMat4("viewProjection", viewProjection);
+        shader.setMat4("previousViewProjection", previousViewProjection);
 
         // Set light uniforms
         shader.setVec3("viewPos", camera.Position);
         shader.setVec3("lightPos", lightPos);
-        shader.setMat4("lightSpaceMatrix", lightSpaceMatrix);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, woodTexture);
+        shader.setInt("cascadeCount", CASCADE_COUNT);
+        for (unsigned int i = 0; i < CASCADE_COUNT; i++) {
+            shader.setMat4("lightSpaceMatrices[" + to_string(i) + "]", cascades[i].lightSpaceMatrix);
+            shader.setFloat("cascadeSplits[" + to_string(i) + "]", cascades[i].splitFar);
+            shader.setFloat("cascadeBias[" + to_string(i) + "]", cascades[i].bias);
+        }
+        shader.setBool("showCascades", showCascades);
+        shader.setInt("pcfSamples", temporalAA ? temporalPcfSamples : pcfSamples);
+        shader.setFloat("pcfRadius", pcfRadius);
+        shader.setFloat("kernelRotation", temporalAA ? GOLDEN_ANGLE * (frameIndex % 256) : 0.0f);
+        shader.setInt("shadowFilter", shadowFilter);
+        shader.setVec2("evsmExponents", EVSM_EXPONENTS);
+        shader.setFloat("minVariance", minVariance);
+        shader.setFloat("lightBleedReduction", lightBleedReduction);
+        bindTexture(0, woodTexture);
         glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+        glActiveTexture(GL_TEXTURE2);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, momentMaps.texture);
         renderScene(shader);
 
-        // Render Depth map to quad for visual debugging
+        // Blend the frame into the history and show the result
+        if (temporalAA) {
+            resolveTimer.begin();
+            temporal.resolve(sceneTextures[0], sceneTextures[1]);
+            resolveTimer.end();
+
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, temporal.resultFramebuffer());
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+        previousViewProjection = viewProjection;
+        frameIndex++;
+
+        // Render Depth map to quad for visual debugging. The map compares in its sampler, so the
+        // raw depths have to be read through rawDepthSampler
         debugDepthQuad.use();
-        debugDepthQuad.setFloat("near_plane", near_plane);
-        debugDepthQuad.setFloat("far_plane", far_plane);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, depthMap);
+        debugDepthQuad.setInt("layer", 0);
+        //glBindSampler(1, rawDepthSampler);
         //renderQuad();
+        //glBindSampler(1, 0);
+
+        // Time saved is what a full redraw costs over reusing the cache
+        float savedMs = 0.0f;
+        if (fullShadowTimer.averageMilliseconds() > 0.0f && cachedShadowTimer.averageMilliseconds() > 0.0f) {
+            savedMs = std::max(fullShadowTimer.averageMilliseconds() - cachedShadowTimer.averageMilliseconds(), 0.0f);
+        }
+        cout << "Shadow caching: " << (shadowCaching ? "on" : "off") << " | shadow pass: " << (redrawn ? "redrawn" : "cached")
+             << " | full: " << fullShadowTimer.averageMilliseconds() << " ms | cached: " << cachedShadowTimer.averageMilliseconds()
+             << " ms | saved per frame: " << savedMs << " ms | filter: " << SHADOW_FILTER_NAMES[shadowFilter]
+             << " | moments: " << (shadowFilter != PCF_FILTER ? momentTimer.averageMilliseconds() : 0.0f) << " ms"
+             << " | TAA: " << (temporalAA ? "on" : "off") << ", " << (temporalAA ? temporalPcfSamples : pcfSamples)
+             << " PCF taps, resolve " << (temporalAA ? resolveTimer.averageMilliseconds() : 0.0f) << " ms" << endl;
 
         // GLFW: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         glfwSwapBuffers(window);
@@ -237,40 +491,247 @@ int main()
     // Optional: de-allocate all resources once they've outlived their purpose:
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &planeVBO);
+    deleteMomentMaps(vsmMaps);
+    deleteMomentMaps(evsmMaps);
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteTextures(2, sceneTextures);
+    glDeleteRenderbuffers(1, &sceneDepth);
 
     glfwTerminate();
     return 0;
 }
 
-// Renders the 3D scene
-void renderScene(const Shader& shader) {
+// Sets up the objects of the 3D scene
+void buildScene() {
     // floor
-    mat4 model = mat4(1.0f);
-    shader.setMat4("model", model);
-    glBindVertexArray(planeVAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+    casters.push_back({ mat4(1.0f), vec3(0.0f, -0.5f, 0.0f), 25.0f * sqrt(2.0f), true, false, 0 });
 
     // Cubes
-    model = mat4(1.0f);
+    mat4 model = mat4(1.0f);
     model = translate(model, vec3(0.0f, 1.5f, 0.0));
     model = scale(model, vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(0.0f, 1.5f, 0.0f), 0.5f * sqrt(3.0f), false, false, 0 });
 
     model = mat4(1.0f);
     model = translate(model, vec3(2.0f, 0.0f, 1.0));
     model = scale(model, vec3(0.5f));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.push_back({ model, vec3(2.0f, 0.0f, 1.0f), 0.5f * sqrt(3.0f), false, false, 0 });
 
-    model = mat4(1.0f);
+    // Spinning cube, set by animateScene()
+    casters.push_back({ mat4(1.0f), vec3(-1.0f, 0.0f, 2.0f), 0.25f * sqrt(3.0f), false, true, 0 });
+}
+
+// Moves the dynamic casters. They spin in place, so their bounding spheres stay put
+void animateScene(float time) {
+    mat4 model = mat4(1.0f);
     model = translate(model, vec3(-1.0f, 0.0f, 2.0));
-    model = rotate(model, radians(60.0f), normalize(vec3(1.0, 0.0, 1.0)));
+    model = rotate(model, radians(60.0f) + time * 0.5f, normalize(vec3(1.0, 0.0, 1.0)));
     model = scale(model, vec3(0.25));
-    shader.setMat4("model", model);
-    renderCube();
+    casters.back().model = model;
+}
+
+// Renders the 3D scene
+void renderScene(const Shader& shader) {
+    for (const Caster& caster : casters) {
+        shader.setMat4("model", caster.model);
+        shader.setMat4("previousModel", caster.previousModel);
+        if (caster.plane) {
+            glBindVertexArray(planeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            renderCube();
+        }
+    }
+}
+
+// Renders the dynamic or the static casters into the cascades of cascadeMask they overlap; the
+// ones that overlap none of them are skipped
+void renderShadowCasters(const Shader& shader, bool dynamic, int cascadeMask) {
+    for (const Caster& caster : casters) {
+        int mask = caster.cascadeMask & cascadeMask;
+        if (caster.dynamic != dynamic || mask == 0) {
+            continue;
+        }
+
+        shader.setInt("cascadeMask", mask);
+        shader.setMat4("model", caster.model);
+        if (caster.plane) {
+            glBindVertexArray(planeVAO);
+            glDrawArrays(GL_TRIANGLES, 0, 6);
+        } else {
+            renderCube();
+        }
+    }
+}
+
+// Rotates world space into the light's view, looking along lightDir
+mat4 lightViewMatrix(const vec3& lightDir) {
+    vec3 up = abs(lightDir.y) > 0.99f ? vec3(0.0f, 0.0f, 1.0f) : vec3(0.0f, 1.0f, 0.0f);
+    return lookAt(vec3(0.0f), lightDir, up);
+}
+
+// Splits the camera frustum up to shadowDistance and fits an orthographic light projection
+// around each slice
+vector<Cascade> fitCascades(const mat4& view, float fovY, float aspect, const vec3& lightDir) {
+    mat4 lightView = lightViewMatrix(lightDir);
+    float farPlane = std::min(shadowDistance, CAMERA_FAR);
+
+    vector<Cascade> cascades(CASCADE_COUNT);
+    float splitNear = CAMERA_NEAR;
+    for (unsigned int i = 0; i < CASCADE_COUNT; i++) {
+        // Practical split scheme: logarithmic spacing keeps texels per screen pixel even, but
+        // starves the far cascades; blending in even spacing gives them back some of the range
+        float fraction = (float)(i + 1) / CASCADE_COUNT;
+        float logSplit = CAMERA_NEAR * pow(farPlane / CAMERA_NEAR, fraction);
+        float evenSplit = CAMERA_NEAR + (farPlane - CAMERA_NEAR) * fraction;
+        float splitFar = splitLambda * logSplit + (1.0f - splitLambda) * evenSplit;
+
+        // Corners of the slice in world space
+        mat4 inverseSlice = inverse(perspective(fovY, aspect, splitNear, splitFar) * view);
+        vec3 corners[8];
+        vec3 center(0.0f);
+        for (int corner = 0; corner < 8; corner++) {
+            vec4 ndc((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f, 1.0f);
+            vec4 world = inverseSlice * ndc;
+            corners[corner] = vec3(world) / world.w;
+            center += corners[corner] / 8.0f;
+        }
+
+        // A bounding sphere doesn't change size as the camera turns, so neither do the texels.
+        // Rounding the radius up keeps float noise from resizing it every frame
+        float radius = 0.0f;
+        for (int corner = 0; corner < 8; corner++) {
+            radius = std::max(radius, length(corners[corner] - center));
+        }
+        radius = ceil(radius * 16.0f) / 16.0f;
+
+        // Move the center only in whole texels, so the map's texel grid stays put in world space
+        // and edges don't shimmer as the camera moves
+        float texelSize = 2.0f * radius / SHADOW_SIZE;
+        vec3 lightCenter = vec3(lightView * vec4(center, 1.0f));
+        lightCenter.x = floor(lightCenter.x / texelSize) * texelSize;
+        lightCenter.y = floor(lightCenter.y / texelSize) * texelSize;
+
+        float nearDistance = -lightCenter.z - radius;
+        float farDistance = -lightCenter.z + radius;
+        mat4 lightProjection = ortho(lightCenter.x - radius, lightCenter.x + radius, lightCenter.y - radius, lightCenter.y + radius, nearDistance, farDistance);
+
+        Cascade& cascade = cascades[i];
+        cascade.lightSpaceMatrix = lightProjection * lightView;
+        cascade.splitFar = splitFar;
+        cascade.minBounds = vec2(lightCenter.x - radius, lightCenter.y - radius);
+        cascade.maxBounds = vec2(lightCenter.x + radius, lightCenter.y + radius);
+        cascade.farDistance = farDistance;
+
+        // About one and a half texels of depth; the depth range is as wide as the map
+        cascade.bias = 1.5f * texelSize / (farDistance - nearDistance);
+
+        splitNear = splitFar;
+    }
+    return cascades;
 }
 
+// Marks each caster with the cascades whose light-space box its bounding sphere overlaps. A
+// caster in front of a cascade along the light still shadows it, one behind it can't
+void cullCasters(const vector<Cascade>& cascades, const vec3& lightDir) {
+    mat4 lightView = lightViewMatrix(lightDir);
+    for (Caster& caster : casters) {
+        vec3 center = vec3(lightView * vec4(caster.center, 1.0f));
+        caster.cascadeMask = 0;
+
+        for (unsigned int i = 0; i < cascades.size(); i++) {
+            const Cascade& cascade = cascades[i];
+            bool outside = center.x + caster.radius < cascade.minBounds.x || center.x - caster.radius > cascade.maxBounds.x
+                || center.y + caster.radius < cascade.minBounds.y || center.y - caster.radius > cascade.maxBounds.y
+                || -center.z - caster.radius > cascade.farDistance;
+            if (!outside) {
+                caster.cascadeMask |= 1 << i;
+            }
+        }
+    }
+}
+
+
+// Allocates the moment array with its full mip chain and the targets of one cascade's moments
+MomentMaps createMomentMaps(GLenum internalFormat, bool exponential) {
+    MomentMaps maps;
+    maps.exponential = exponential;
+
+    glGenTextures(1, &maps.texture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, maps.texture);
+    unsigned int levels = 1;
+    while ((SHADOW_SIZE >> levels) > 0) {
+        levels++;
+    }
+    for (unsigned int level = 0; level < levels; level++) {
+        unsigned int size = SHADOW_SIZE >> level;
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat, size, size, CASCADE_COUNT, 0, GL_RGBA, GL_FLOAT, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenTextures(1, &maps.momentTexture);
+    glBindTexture(GL_TEXTURE_2D, maps.momentTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, SHADOW_SIZE, SHADOW_SIZE, 0, GL_RGBA, GL_FLOAT, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glGenFramebuffers(1, &maps.momentFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, maps.momentFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, maps.momentTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Moment framebuffer not complete." << endl;
+    }
+    glGenFramebuffers(1, &maps.readFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    maps.blur = new GaussianBlur(SHADOW_SIZE, SHADOW_SIZE, momentBlurSigma, 1, internalFormat);
+    return maps;
+}
+
+// Turns every cascade of the depth map into blurred moments and mipmaps them
+void updateMomentMaps(MomentMaps& maps, unsigned int depthMap, unsigned int rawDepthSampler, const Shader& momentShader) {
+    glUseProgram(momentShader.ID);
+    momentShader.setBool("exponential", maps.exponential);
+    glDisable(GL_DEPTH_TEST);
+
+    for (unsigned int cascade = 0; cascade < CASCADE_COUNT; cascade++) {
+        glBindFramebuffer(GL_FRAMEBUFFER, maps.momentFBO);
+        glViewport(0, 0, SHADOW_SIZE, SHADOW_SIZE);
+        glUseProgram(momentShader.ID);
+        momentShader.setInt("layer", cascade);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, depthMap);
+        glBindSampler(0, rawDepthSampler);
+        renderQuad();
+        glBindSampler(0, 0);
+
+        unsigned int blurred = maps.blur->apply(maps.momentTexture);
+
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, maps.readFBO);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, blurred, 0);
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, maps.texture);
+        glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, cascade, 0, 0, SHADOW_SIZE, SHADOW_SIZE);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, maps.texture);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glEnable(GL_DEPTH_TEST);
+}
+
+void deleteMomentMaps(MomentMaps& maps) {
+    delete maps.blur;
+    glDeleteFramebuffers(1, &maps.momentFBO);
+    glDeleteFramebuffers(1, &maps.readFBO);
+    glDeleteTextures(1, &maps.momentTexture);
+    glDeleteTextures(1, &maps.texture);
+}
 
 // renderCube() renders a 1x1 3D cube in NDC.
 unsigned int cubeVAO = 0;
@@ -394,6 +855,43 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS && !showCascadesKeyPressed) {
+        showCascades = !showCascades;
+        showCascadesKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_C) == GLFW_RELEASE) {
+        showCascadesKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_PRESS && !shadowCachingKeyPressed) {
+        shadowCaching = !shadowCaching;
+        shadowCachingKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_K) == GLFW_RELEASE) {
+        shadowCachingKeyPressed = false;
+    }
+
+    // V cycles PCF, VSM and EVSM
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_PRESS && !shadowFilterKeyPressed) {
+        shadowFilter = (ShadowFilter)((shadowFilter + 1) % 3);
+        shadowFilterKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_V) == GLFW_RELEASE) {
+        shadowFilterKeyPressed = false;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS && !temporalAAKeyPressed) {
+        temporalAA = !temporalAA;
+        temporalAAKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_T) == GLFW_RELEASE) {
+        temporalAAKeyPressed = false;
+    }
 }
 
 // GLFW: whenever the window size changed (by OS or user resize) this callback function executes
@@ -424,38 +922,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-// Utility function for loading a 2D texture from file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT); // For this tutorial: use GL_CLAMP_TO_EDGE to prevent semi-transparent borders. Due to interpolation it takes texels from next repeat 
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, format == GL_RGBA ? GL_CLAMP_TO_EDGE : GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
@@ -3,7 +3,8 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
-uniform sampler2D depthMap;
+uniform sampler2DArray depthMap;
+uniform int layer;
 uniform float near_plane;
 uniform float far_plane;
 
@@ -14,7 +15,7 @@ float LinearizeDepth(float depth) {
 }
 
 void main() {             
-    float depthValue = texture(depthMap, TexCoords).r;
+    float depthValue = texture(depthMap, vec3(TexCoords, layer)).r;
 
     // FragColor = vec4(vec3(LinearizeDepth(depthValue) / far_plane), 1.0); // Perspective
     FragColor = vec4(vec3(depthValue), 1.0); // Orthographic
@@ -1,57 +1,143 @@
 #version 330 core
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out vec2 Velocity; // Texture coordinates moved since the last frame, for temporal anti-aliasing
 
 in VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    float ViewDepth;
+    vec4 CurrentClip;
+    vec4 PreviousClip;
 } fs_in;
 
+const int MAX_CASCADES = 4;
+
 uniform sampler2D diffuseTexture;
-uniform sampler2D shadowMap;
+uniform sampler2DArrayShadow shadowMap; // Each fetch compares 4 texels against the reference and filters the results
+uniform sampler2DArray momentMap;       // Blurred and mipmapped moments of each cascade, for VSM and EVSM
 
 uniform vec3 lightPos;
 uniform vec3 viewPos;
 
-float ShadowCalculation(vec4 fragPosLightSpace) {
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform float cascadeSplits[MAX_CASCADES]; // Far distance of each cascade from the camera
+uniform float cascadeBias[MAX_CASCADES];   // Depth bias of a surface facing the light, about one and a half texels
+uniform int cascadeCount;
+uniform bool showCascades;
+uniform int pcfSamples;    // Poisson taps per fragment, 4 to 16
+uniform float pcfRadius;   // Filter radius in texels
+uniform float kernelRotation; // Turned every frame under temporal anti-aliasing, which averages the taps of many frames
+
+const int PCF_FILTER = 0;
+const int VSM_FILTER = 1;
+const int EVSM_FILTER = 2;
+uniform int shadowFilter;
+uniform vec2 evsmExponents;
+uniform float minVariance;
+uniform float lightBleedReduction; // Cuts off this much of the upper bound, where it bleeds light
+
+// Poisson disk, ordered so the first four taps lie far apart, one in each quadrant
+const vec2 poissonDisk[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2( 0.94558609, -0.76890725), vec2( 0.97484398,  0.75648379), vec2(-0.81409955,  0.91437590),
+    vec2(-0.09418410, -0.92938870), vec2( 0.34495938,  0.29387760), vec2(-0.91588581,  0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543,  0.27676845), vec2( 0.44323325, -0.97511554), vec2( 0.53742981, -0.47373420), vec2(-0.26496911, -0.41893023),
+    vec2( 0.79197514,  0.19090188), vec2(-0.24188840,  0.99706507), vec2( 0.19984126,  0.78641367), vec2( 0.14383161, -0.14100161)
+);
+
+// Per-pixel angle to rotate the kernel by, so the banding of a few taps turns into fine noise
+float KernelAngle() {
+    float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy, vec2(0.06711056, 0.00583715))));
+    return noise * 6.28318531 + kernelRotation;
+}
+
+// The nearest cascade that still covers the fragment, or -1 past the last one
+int CascadeIndex() {
+    for (int i = 0; i < cascadeCount; i++) {
+        if (fs_in.ViewDepth < cascadeSplits[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Upper bound on the fraction of the filter area that is lit at depth t, from its first two moments
+float ChebyshevUpperBound(vec2 moments, float t, float varianceFloor) {
+    if (t <= moments.x) {
+        return 1.0;
+    }
+
+    float variance = max(moments.y - moments.x * moments.x, varianceFloor);
+    float d = t - moments.x;
+    float pMax = variance / (variance + d * d);
+    return clamp((pMax - lightBleedReduction) / (1.0 - lightBleedReduction), 0.0, 1.0);
+}
+
+// One trilinear fetch of the prefiltered moments in place of the PCF taps
+float MomentShadow(vec3 projCoords, int cascade) {
+    vec4 moments = texture(momentMap, vec3(projCoords.xy, cascade));
+    if (shadowFilter == VSM_FILTER) {
+        return 1.0 - ChebyshevUpperBound(moments.xy, projCoords.z, minVariance);
+    }
+
+    // The warp stretches depths by its derivative, so the variance floor has to grow with it
+    float warped = projCoords.z * 2.0 - 1.0;
+    float positive = exp(evsmExponents.x * warped);
+    float negative = -exp(-evsmExponents.y * warped);
+    float positiveFloor = minVariance * pow(evsmExponents.x * positive, 2.0);
+    float negativeFloor = minVariance * pow(evsmExponents.y * negative, 2.0);
+    float lit = min(ChebyshevUpperBound(moments.xy, positive, positiveFloor), ChebyshevUpperBound(moments.zw, negative, negativeFloor));
+    return 1.0 - lit;
+}
+
+float ShadowCalculation(int cascade) {
+    if (cascade < 0) {
+        return 0.0;
+    }
+
     // Perform perspective divide
+    vec4 fragPosLightSpace = lightSpaceMatrices[cascade] * vec4(fs_in.FragPos, 1.0);
     vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
 
     // Transform to [0,1] range
     projCoords = projCoords * 0.5 + 0.5;
 
-    // Get closest depth value from light's perspective (using [0,1] range fragPosLight as coords)
-    float closestDepth = texture(shadowMap, projCoords.xy).r; 
-
     // Get depth of current fragment from light's perspective
     float currentDepth = projCoords.z;
 
-    // Calculate bias (based on depth map resolution and slope)
+    // Calculate bias (based on the cascade's texel size and slope)
     vec3 normal = normalize(fs_in.Normal);
     vec3 lightDir = normalize(lightPos - fs_in.FragPos);
-    float bias = max(0.05 * (1.0 - dot(normal, lightDir)), 0.005);
+    float bias = cascadeBias[cascade] * max(10.0 * (1.0 - dot(normal, lightDir)), 1.0);
 
-    // Check whether current frag pos is in shadow
-    // float shadow = currentDepth - bias > closestDepth  ? 1.0 : 0.0;
+    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
+    if(projCoords.z > 1.0)
+        return 0.0;
 
-    // PCF
-    float shadow = 0.0;
-    vec2 texelSize = 1.0 / textureSize(shadowMap, 0);
+    if (shadowFilter != PCF_FILTER) {
+        return MomentShadow(projCoords, cascade);
+    }
 
-    for(int x = -1; x <= 1; ++x) {
-        for(int y = -1; y <= 1; ++y) {
-            float pcfDepth = texture(shadowMap, projCoords.xy + vec2(x, y) * texelSize).r; 
-            shadow += currentDepth - bias > pcfDepth  ? 1.0 : 0.0;        
-        }    
+    // PCF over a rotated Poisson disk. Each tap is already a bilinear blend of 4 comparisons, so
+    // a few of them cover more ground than the 9 single comparisons of a 3x3 grid
+    vec2 texelSize = 1.0 / vec2(textureSize(shadowMap, 0).xy);
+    float angle = KernelAngle();
+    mat2 rotation = mat2(cos(angle), sin(angle), -sin(angle), cos(angle));
+    float reference = currentDepth - bias;
+
+    float lit = 0.0;
+    int samples = clamp(pcfSamples, 4, 16);
+    for (int i = 0; i < samples; i++) {
+        vec2 offset = rotation * poissonDisk[i] * pcfRadius * texelSize;
+        lit += texture(shadowMap, vec4(projCoords.xy + offset, cascade, reference));
+
+        // Fully lit or fully shadowed at all four outer taps: not in a penumbra, so the rest
+        // of the taps would agree as well
+        if (i == 3 && (lit < 0.001 || lit > 3.999)) {
+            return 1.0 - lit / 4.0;
+        }
     }
-    shadow /= 9.0;
-    
-    // Keep the shadow at 0.0 when outside the far_plane region of the light's frustum.
-    if(projCoords.z > 1.0)
-        shadow = 0.0;
-        
-    return shadow;
+    return 1.0 - lit / float(samples);
 }
 
 void main() {           
@@ -76,8 +162,16 @@ void main() {
     vec3 specular = spec * lightColor; 
     
     // Calculate shadow
-    float shadow = ShadowCalculation(fs_in.FragPosLightSpace);                      
+    int cascade = CascadeIndex();
+    float shadow = ShadowCalculation(cascade);                      
     vec3 lighting = (ambient + (1.0 - shadow) * (diffuse + specular)) * color;    
+
+    // Tint each cascade to see where the splits fall
+    if (showCascades && cascade >= 0) {
+        vec3 tints[MAX_CASCADES] = vec3[](vec3(1.0, 0.6, 0.6), vec3(0.6, 1.0, 0.6), vec3(0.6, 0.6, 1.0), vec3(1.0, 1.0, 0.6));
+        lighting *= tints[cascade];
+    }
     
     FragColor = vec4(lighting, 1.0);
+    Velocity = (fs_in.CurrentClip.xy / fs_in.CurrentClip.w - fs_in.PreviousClip.xy / fs_in.PreviousClip.w) * 0.5;
 }
\ No newline at end of file
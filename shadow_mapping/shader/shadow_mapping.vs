@@ -9,18 +9,28 @@ out VS_OUT {
     vec3 FragPos;
     vec3 Normal;
     vec2 TexCoords;
-    vec4 FragPosLightSpace;
+    float ViewDepth;
+    vec4 CurrentClip;   // Without the jitter, for the velocity
+    vec4 PreviousClip;
 } vs_out;
 
 uniform mat4 projection;
 uniform mat4 view;
 uniform mat4 model;
-uniform mat4 lightSpaceMatrix;
+uniform mat4 previousModel;
+uniform mat4 viewProjection;         // This frame's, without the jitter
+uniform mat4 previousViewProjection; // The last frame's, without the jitter
 
 void main() {
     vs_out.FragPos = vec3(model * vec4(aPos, 1.0));
     vs_out.Normal = transpose(inverse(mat3(model))) * aNormal;
     vs_out.TexCoords = aTexCoords;
-    vs_out.FragPosLightSpace = lightSpaceMatrix * vec4(vs_out.FragPos, 1.0);
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+
+    // Distance along the view direction picks the cascade
+    vec4 viewPos = view * vec4(vs_out.FragPos, 1.0);
+    vs_out.ViewDepth = -viewPos.z;
+    gl_Position = projection * viewPos;
+
+    vs_out.CurrentClip = viewProjection * vec4(vs_out.FragPos, 1.0);
+    vs_out.PreviousClip = previousViewProjection * previousModel * vec4(aPos, 1.0);
 }
\ No newline at end of file
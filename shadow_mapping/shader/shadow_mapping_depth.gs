@@ -0,0 +1,26 @@
+#version 330 core
+layout (triangles) in;
+layout (triangle_strip, max_vertices = 12) out;
+
+const int MAX_CASCADES = 4;
+
+uniform mat4 lightSpaceMatrices[MAX_CASCADES];
+uniform int cascadeCount;
+uniform int cascadeMask; // Cascades the current caster overlaps, one bit each
+
+// Renders every cascade in one pass: each triangle is sent to the layer of every cascade its
+// caster overlaps, and skipped for the rest
+void main() {
+    for (int cascade = 0; cascade < cascadeCount; cascade++) {
+        if ((cascadeMask & (1 << cascade)) == 0) {
+            continue;
+        }
+
+        for (int i = 0; i < 3; i++) {
+            gl_Layer = cascade;
+            gl_Position = lightSpaceMatrices[cascade] * gl_in[i].gl_Position;
+            EmitVertex();
+        }
+        EndPrimitive();
+    }
+}
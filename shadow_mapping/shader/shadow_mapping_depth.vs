@@ -1,9 +1,9 @@
-  #version 330 core
+#version 330 core
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 lightSpaceMatrix;
 uniform mat4 model;
 
 void main() {
-    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);
+    // World space; the geometry shader projects it into each cascade
+    gl_Position = model * vec4(aPos, 1.0);
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec2 TexCoords;
+
+uniform sampler2DArray depthMap; // Read without the comparison
+uniform int layer;
+uniform bool exponential;
+uniform vec2 exponents;          // Positive and negative warp of EVSM
+
+// Turns one cascade's depths into moments, which unlike depths can be blurred and mipmapped:
+// the filtered moments still bound how much of the filter area is in front of a depth
+void main() {
+    float depth = texture(depthMap, vec3(TexCoords, layer)).r;
+    if (exponential) {
+        // Warping the depth exponentially makes the bound much tighter, which cuts light bleeding
+        float warped = depth * 2.0 - 1.0;
+        float positive = exp(exponents.x * warped);
+        float negative = -exp(-exponents.y * warped);
+        FragColor = vec4(positive, positive * positive, negative, negative * negative);
+    } else {
+        FragColor = vec4(depth, depth * depth, 0.0, 0.0);
+    }
+}
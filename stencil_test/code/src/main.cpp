@@ -6,8 +6,10 @@
 #include <iostream>
 
 #include "Shader.h"
-#include "stb_image.h"
 #include "Camera.h"
+#include "../../../common/code/header/TextureLoader.h"
+#include "../../../common/code/header/JumpFloodOutline.h"
+#include "../../../common/code/header/GpuTimer.h"
 
 using namespace std;
 using namespace glm;
@@ -17,12 +19,18 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(const char* path);
 
 // Settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
 
+// Outline settings
+const float OUTLINE_THICKNESS = 4.0f; // In pixels
+const unsigned int OUTLINE_DOWNSCALE = 2; // The jump flood runs at half resolution
+const vec3 OUTLINE_COLOR = vec3(0.04f, 0.28f, 0.26f);
+bool floodOutline = true; // Jump flood outline from object IDs instead of the stencil double-draw
+bool outlineKeyPressed = false;
+
 // Camera set-up
 Camera camera(vec3(0.0f, 0.0f, 3.0f));
 float lastX = SCR_WIDTH / 2;
@@ -189,6 +197,44 @@ int main() {
     unsigned int cubeTexture = loadTexture("marble.jpg");
     unsigned int floorTexture = loadTexture("metal.png");
 
+    // For the jump flood outline the scene is drawn into a framebuffer with a second target, which
+    // every object writes its ID to, 0 for the ones that aren't outlined
+    unsigned int sceneFBO;
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+
+    unsigned int rboColor;
+    glGenRenderbuffers(1, &rboColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rboColor);
+
+    unsigned int idTexture;
+    glGenTextures(1, &idTexture);
+    glBindTexture(GL_TEXTURE_2D, idTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SCR_WIDTH, SCR_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, idTexture, 0);
+
+    unsigned int rboDepth;
+    glGenRenderbuffers(1, &rboDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, SCR_WIDTH, SCR_HEIGHT);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+
+    unsigned int attachments[2] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+    glDrawBuffers(2, attachments);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cout << "Framebuffer not complete." << endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    JumpFloodOutline outline(SCR_WIDTH, SCR_HEIGHT, OUTLINE_THICKNESS, OUTLINE_DOWNSCALE);
+    GpuTimer floodTimer;
+    GpuTimer stencilTimer;
+
     shader.use();
     shader.setInt("texture1", 0);
 
@@ -203,8 +249,14 @@ int main() {
         processInput(window);
 
         // Render
+        glBindFramebuffer(GL_FRAMEBUFFER, floodOutline ? sceneFBO : 0);
         glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+        if (floodOutline) {
+            // glClear filled the IDs with the clear color, so they're cleared to "no object" apart
+            const float clearId[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 1, clearId);
+        }
 
 
         // Set up uniforms
@@ -224,10 +276,11 @@ int main() {
 
         // Draw the floor
         glBindVertexArray(planeVAO);
-        glBindTexture(GL_TEXTURE_2D, floorTexture);
+        bindTexture(0, floorTexture);
 
         // Set up model matrix
         shader.setMat4("model", mat4(1.0f));
+        shader.setFloat("objectId", 0.0f);
 
         // Draw the floor
         glDrawArrays(GL_TRIANGLES, 0, 6);
@@ -243,13 +296,13 @@ int main() {
         glBindVertexArray(cubeVAO);
 
         // Bind texture
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
+        bindTexture(0, cubeTexture);
      
         // Set up model matrix
         model = mat4(1.0f);
         model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
         shader.setMat4("model", model);
+        shader.setFloat("objectId", 1.0f / 255.0f);
 
         // Draw cube
         glDrawArrays(GL_TRIANGLES, 0, 36);
@@ -257,46 +310,71 @@ int main() {
         model = mat4(1.0f);
         model = translate(model, vec3(2.0f, 0.0f, 0.0f));
         shader.setMat4("model", model);
+        shader.setFloat("objectId", 2.0f / 255.0f);
         glDrawArrays(GL_TRIANGLES, 0, 36);
 
+        // Show the scene first, so only the outline itself is timed on either path
+        if (floodOutline) {
+            glBindVertexArray(0);
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            glBlitFramebuffer(0, 0, SCR_WIDTH, SCR_HEIGHT, 0, 0, SCR_WIDTH, SCR_HEIGHT, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
 
-        // 2nd Render Pass: Now draw slightly scaled up versions of the objects, this time disablinh
-        // stencil writing. Because the stencil buffer is now filled with several 1s, the parts of the
-        // the buffer that are 1 are not drawn, thus only drawing the objects size differences, making it
-        // appear that the boxes have an outline
-        glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
-        glStencilMask(0x00);
-        glDisable(GL_DEPTH_TEST);
-        singleColor.use();
-        float scale = 1.1;
-
-        // Draw Cubes
-        glBindVertexArray(cubeVAO);
-        glBindTexture(GL_TEXTURE_2D, cubeTexture);
-
-        // Set up model matrix
-        model = mat4(1.0f);
-        model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
-        model = ::scale(model, vec3(scale, scale, scale));
-        singleColor.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // Draw second cube
-        model = mat4(1.0f);
-        model = translate(model, vec3(2.0f, 0.0f, 0.0f));
-        model = ::scale(model, vec3(scale, scale, scale));
-        singleColor.setMat4("model", model);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        glBindVertexArray(0);
-        glStencilMask(0xFF);
-        glStencilFunc(GL_ALWAYS, 0, 0xFF);
-        glEnable(GL_DEPTH_TEST);
+        GpuTimer& outlineTimer = floodOutline ? floodTimer : stencilTimer;
+        outlineTimer.begin();
+        if (floodOutline) {
+            // Outline every object with an ID in a fixed number of full-screen passes, without
+            // drawing any of them again
+            outline.draw(idTexture, OUTLINE_COLOR);
+        } else {
+            // 2nd Render Pass: Now draw slightly scaled up versions of the objects, this time disablinh
+            // stencil writing. Because the stencil buffer is now filled with several 1s, the parts of the
+            // the buffer that are 1 are not drawn, thus only drawing the objects size differences, making it
+            // appear that the boxes have an outline
+            glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+            glStencilMask(0x00);
+            glDisable(GL_DEPTH_TEST);
+            singleColor.use();
+            float scale = 1.1;
+
+            // Draw Cubes
+            glBindVertexArray(cubeVAO);
+            bindTexture(0, cubeTexture);
+
+            // Set up model matrix
+            model = mat4(1.0f);
+            model = translate(model, vec3(-1.0f, 0.0f, -1.0f));
+            model = ::scale(model, vec3(scale, scale, scale));
+            singleColor.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+
+            // Draw second cube
+            model = mat4(1.0f);
+            model = translate(model, vec3(2.0f, 0.0f, 0.0f));
+            model = ::scale(model, vec3(scale, scale, scale));
+            singleColor.setMat4("model", model);
+            glDrawArrays(GL_TRIANGLES, 0, 36);
+
+            glBindVertexArray(0);
+            glStencilMask(0xFF);
+            glStencilFunc(GL_ALWAYS, 0, 0xFF);
+            glEnable(GL_DEPTH_TEST);
+        }
+        outlineTimer.end();
 
         // Swap buffers and poll I/O events
         glfwSwapBuffers(window);
         glfwPollEvents();
 
+        if (floodOutline) {
+            cout << "Outline: jump flood, " << outline.passCount() << " full-screen passes";
+        } else {
+            cout << "Outline: stencil double-draw";
+        }
+        cout << " | GPU: " << outlineTimer.averageMilliseconds() << " ms" << endl;
+
     }
 
     // Deallocate all resources once they are no longer needed
@@ -304,6 +382,10 @@ int main() {
     glDeleteVertexArrays(1, &planeVAO);
     glDeleteBuffers(1, &cubeVBO);
     glDeleteBuffers(1, &planeVBO);
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteRenderbuffers(1, &rboColor);
+    glDeleteRenderbuffers(1, &rboDepth);
+    glDeleteTextures(1, &idTexture);
 
     // Terminate the program
     glfwTerminate();
@@ -326,6 +408,15 @@ void processInput(GLFWwindow* window) {
         camera.ProcessKeyboard(LEFT, deltaTime);
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_PRESS && !outlineKeyPressed) {
+        floodOutline = !floodOutline;
+        outlineKeyPressed = true;
+    }
+
+    if (glfwGetKey(window, GLFW_KEY_O) == GLFW_RELEASE) {
+        outlineKeyPressed = false;
+    }
 }
 
 // Whenever the window size is changed, this callback function executes
@@ -353,40 +444,3 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
     camera.ProcessMouseScroll(yoffset);
 }
-
-
-// Utility function for loading a 2D texture from a file
-unsigned int loadTexture(char const* path) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
-
-    if (data) {
-        GLenum format;
-        if (nrComponents == 1) {
-            format = GL_RED;
-        } else if (nrComponents == 3) {
-            format = GL_RGB;
-        } else if (nrComponents == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    } else {
-        cout << "Texture failed to load at path: " << path << endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
@@ -1,11 +1,14 @@
 #version 330 core
 
-out vec4 FragColor;
+layout (location = 0) out vec4 FragColor;
+layout (location = 1) out float ObjectId; // Read by the jump flood outline; ignored without a second target
 
 in vec2 TexCoords;
 
 uniform sampler2D texture1;
+uniform float objectId; // ID / 255, 0 for objects that aren't outlined
 
 void main() {    
   FragColor = texture(texture1, TexCoords);
+  ObjectId = objectId;
 }
\ No newline at end of file